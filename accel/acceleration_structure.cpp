@@ -0,0 +1,30 @@
+// Ray Tracer: acceleration_structure.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: An Acceleration Structure provides a template for all 
+//                  structures sorting the geometry of a scene so that rays 
+//                  only need to be tested against the geometry near them. 
+//                  Contains methods to find the nearest intersection of a 
+//                  ray, to check whether a ray hits anything, and to update
+//                  the structure after geometry moved.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "acceleration_structure.h"
+
+AccelerationStructure::~AccelerationStructure(){}
@@ -0,0 +1,681 @@
+// Ray Tracer: bvh.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Bounding Volume Hierarchy sorts the geometry of the scene 
+//                  into a tree of boxes, so a ray only has to be tested 
+//                  against the geometry inside the boxes it crosses. The 
+//                  tree is split using the Surface Area Heuristic, and can 
+//                  be refit to geometry that moved without rebuilding it.
+//                  Refitting runs on several threads for large trees, and 
+//                  the tree is rebuilt once refitting has made it too slow.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "bvh.h"
+
+#include "../scene.h"
+
+//Gets one coordinate of a point by axis (0: X, 1: Y, 2: Z)
+static double getAxis(Point3D point, int axis){
+    switch(axis){
+        case 0: return point.getX();
+        case 1: return point.getY();
+        default: return point.getZ();
+    }
+}
+
+//Sorts primitives into the bins left of a split plane
+struct BvhBinPartition {
+    int axis;
+    int split_bin;
+    double min_center;
+    double bin_scale;
+    
+    bool operator()(const BvhPrimitive& primitive) const {
+        int bin = (int)((getAxis(primitive.center, axis) - min_center) * bin_scale);
+        return std::min(bin, BVH_BIN_COUNT - 1) < split_bin;
+    }
+};
+
+//Orders primitives by the position of their centers along one axis
+struct BvhAxisOrder {
+    int axis;
+    
+    bool operator()(const BvhPrimitive& a, const BvhPrimitive& b) const {
+        return getAxis(a.center, axis) < getAxis(b.center, axis);
+    }
+};
+
+/**
+ * Builds the hierarchy over the geometry of the scene. The hierarchy does not
+ * take ownership of the geometry.
+ *
+ * @param scene Scene containing the geometry
+ */
+Bvh::Bvh(Scene* scene){
+    this->scene_ = scene;
+    this->rebuild_threshold_ = DEFAULT_BVH_REBUILD_THRESHOLD;
+    build();
+}
+
+/**
+ * Builds the hierarchy over a fixed list of geometry, such as the geometry of
+ * an Asset. The hierarchy does not take ownership of the geometry.
+ *
+ * @param geometry Geometry to sort into the hierarchy
+ */
+Bvh::Bvh(std::vector<Geometry*> geometry){
+    this->scene_ = NULL;
+    this->source_geometry_ = geometry;
+    this->rebuild_threshold_ = DEFAULT_BVH_REBUILD_THRESHOLD;
+    build();
+}
+
+Bvh::~Bvh(){}
+
+/**
+ * Builds the hierarchy from scratch over the geometry currently in the scene
+ * (or the fixed list of geometry it was created with)
+ */
+void Bvh::build(){
+    std::vector<Geometry*> geometry = this->source_geometry_;
+    if(this->scene_ != NULL){
+        geometry.resize(this->scene_->getGeoListSize());
+        for (int i = 0; i < this->scene_->getGeoListSize(); i++) {
+            geometry[i] = this->scene_->getGeoAt(i);
+        }
+    }
+    
+    std::vector<BvhPrimitive> primitives(geometry.size());
+    for (unsigned int i = 0; i < geometry.size(); i++) {
+        primitives[i].geometry = geometry[i];
+        primitives[i].bounds = primitives[i].geometry->getBounds();
+        primitives[i].center = primitives[i].bounds.getCenter();
+    }
+    
+    this->nodes_.clear();
+    if(!primitives.empty()){
+        this->nodes_.reserve(2 * primitives.size());
+        buildNode(&primitives, 0, primitives.size(), 0);
+    }
+    
+    this->geometry_.resize(primitives.size());
+    for (unsigned int i = 0; i < primitives.size(); i++) {
+        this->geometry_[i] = primitives[i].geometry;
+    }
+    
+    this->cost_ = computeCost();
+    this->build_cost_ = this->cost_;
+}
+
+/**
+ * Updates the boxes of the hierarchy to enclose the geometry after it moved, 
+ * keeping the structure of the tree. Children are always stored after their
+ * parent, so walking the nodes from last to first updates every child before
+ * its parent. 
+ * 
+ * Each subtree occupies a contiguous range of nodes, so large trees are cut 
+ * into one subtree per hardware thread, which are refit in parallel before 
+ * the few nodes above them. 
+ * 
+ * The tree gets slower as the geometry moves away from where it was when the
+ * tree was built. The Surface Area Heuristic cost of the tree is recomputed 
+ * while refitting, and the tree is rebuilt once it exceeds the cost of the 
+ * freshly built tree by more than the rebuild threshold.
+ * 
+ * @return Flag indicating whether the tree was rebuilt
+ */
+bool Bvh::refit(){
+    if(this->nodes_.empty()){
+        return false;
+    }
+    
+    int thread_count = std::thread::hardware_concurrency();
+    int split_depth = 0;
+    if(this->nodes_.size() >= BVH_PARALLEL_REFIT_MIN_NODES){
+        while((1 << split_depth) < thread_count){
+            split_depth++;
+        }
+    }
+    
+    std::vector<int> subtree_bounds;
+    std::vector<int> top_nodes;
+    collectSubtrees(0, this->nodes_.size(), split_depth, &subtree_bounds, &top_nodes);
+    
+    int subtree_count = subtree_bounds.size() / 2;
+    std::vector<double> subtree_costs(subtree_count, 0.0);
+    std::vector<std::thread> threads;
+    for (int i = 1; i < subtree_count; i++) {
+        threads.push_back(std::thread(&Bvh::refitRange, this, subtree_bounds[2 * i], subtree_bounds[2 * i + 1], &subtree_costs[i]));
+    }
+    refitRange(subtree_bounds[0], subtree_bounds[1], &subtree_costs[0]);
+    for (unsigned int i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    
+    double cost = 0.0;
+    for (int i = 0; i < subtree_count; i++) {
+        cost += subtree_costs[i];
+    }
+    for (int i = top_nodes.size() - 1; i >= 0; i--) {
+        cost += refitNode(top_nodes[i]);
+    }
+    
+    double root_area = this->nodes_[0].bounds.getSurfaceArea();
+    this->cost_ = root_area > 0 ? cost / root_area : 0.0;
+    
+    if(this->cost_ > this->build_cost_ * (1 + this->rebuild_threshold_)){
+        build();
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Finds the geometry nearest to the origin of the ray that the ray intersects.
+ * Boxes further away than the nearest intersection found so far are skipped, 
+ * and the nearer child of each node is visited first.
+ *
+ * @param ray Ray to compute intersections with
+ * @param nearest_point Resulting point of the nearest intersection
+ * @param normal_at_nearest_point Resulting normal at the nearest intersection
+ * @return Geometry nearest to the origin of the ray (NULL if none is hit)
+ */
+Geometry* Bvh::computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point){
+    Geometry* nearest_geometry = NULL;
+    if(this->nodes_.empty()){
+        return nearest_geometry;
+    }
+    
+    float nearest_intersection_distance = INFINITY;
+    double origin[3] = {ray->getOrigin()->getX(), ray->getOrigin()->getY(), ray->getOrigin()->getZ()};
+    double inverse_direction[3] = {1.0 / ray->getDirection()->getX(), 1.0 / ray->getDirection()->getY(), 1.0 / ray->getDirection()->getZ()};
+    
+    Point3D point_hit (0,0,0);
+    Vector3D normal_hit (1,1,1);
+    
+    int stack[BVH_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while(stack_size > 0){
+        BvhNode* node = &this->nodes_[stack[--stack_size]];
+        double entry_distance;
+        if(!intersectBounds(node, origin, inverse_direction, std::min((double)nearest_intersection_distance, ray->getMaxDistance()), entry_distance)){
+            continue;
+        }
+        
+        if(node->geometry_count > 0){
+            for (int i = node->first_geometry_index; i < node->first_geometry_index + node->geometry_count; i++) {
+                Geometry* geometry_hit = this->geometry_[i]->computeNearestIntersection(ray, &point_hit, &normal_hit);
+                if (geometry_hit != NULL) {
+                    float distance = ray->getOrigin()->computeDistance(&point_hit);
+                    if (distance < nearest_intersection_distance) {
+                        nearest_geometry = geometry_hit;
+                        nearest_intersection_distance = distance;
+                        *nearest_point = point_hit;
+                        *normal_at_nearest_point = normal_hit;
+                    }
+                }
+            }
+            continue;
+        }
+        
+        int first_child = (node - &this->nodes_[0]) + 1;
+        int second_child = node->second_child_index;
+        double first_distance, second_distance;
+        bool hits_first = intersectBounds(&this->nodes_[first_child], origin, inverse_direction, nearest_intersection_distance, first_distance);
+        bool hits_second = intersectBounds(&this->nodes_[second_child], origin, inverse_direction, nearest_intersection_distance, second_distance);
+        
+        //Push the further child first so the nearer child is visited first
+        if(hits_first && hits_second){
+            if(first_distance <= second_distance){
+                stack[stack_size++] = second_child;
+                stack[stack_size++] = first_child;
+            } else {
+                stack[stack_size++] = first_child;
+                stack[stack_size++] = second_child;
+            }
+        } else if(hits_first){
+            stack[stack_size++] = first_child;
+        } else if(hits_second){
+            stack[stack_size++] = second_child;
+        }
+    }
+    
+    return nearest_geometry;
+}
+
+/**
+ * Determines if the ray intersects any geometry within its interval. The 
+ * search stops at the first intersection found, which is all a shadow ray 
+ * needs to know. Only the children whose boxes the ray crosses are pushed.
+ *
+ * @param ray Ray to compute intersections with
+ * @return Result of the check
+ */
+bool Bvh::hasIntersection(Ray* ray){
+    if(this->nodes_.empty()){
+        return false;
+    }
+    
+    double origin[3] = {ray->getOrigin()->getX(), ray->getOrigin()->getY(), ray->getOrigin()->getZ()};
+    double inverse_direction[3] = {1.0 / ray->getDirection()->getX(), 1.0 / ray->getDirection()->getY(), 1.0 / ray->getDirection()->getZ()};
+    
+    Point3D point_hit_noop (0,0,0);
+    Vector3D normal_hit_noop (1,1,1);
+    
+    double max_distance = ray->getMaxDistance();
+    double entry_distance;
+    if(!intersectBounds(&this->nodes_[0], origin, inverse_direction, max_distance, entry_distance)){
+        return false;
+    }
+    
+    int stack[BVH_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while(stack_size > 0){
+        int node_index = stack[--stack_size];
+        BvhNode* node = &this->nodes_[node_index];
+        if(node->geometry_count > 0){
+            for (int i = node->first_geometry_index; i < node->first_geometry_index + node->geometry_count; i++) {
+                if (this->geometry_[i]->hasIntersection(ray, &point_hit_noop, &normal_hit_noop)) {
+                    return true;
+                }
+            }
+            continue;
+        }
+        
+        if(intersectBounds(&this->nodes_[node->second_child_index], origin, inverse_direction, max_distance, entry_distance)){
+            stack[stack_size++] = node->second_child_index;
+        }
+        if(intersectBounds(&this->nodes_[node_index + 1], origin, inverse_direction, max_distance, entry_distance)){
+            stack[stack_size++] = node_index + 1;
+        }
+    }
+    
+    return false;
+}
+
+/**
+ * Gets the amount of geometry sorted into the hierarchy
+ *
+ * @return Amount of geometry in the hierarchy
+ */
+int Bvh::getGeometryCount(){
+    return this->geometry_.size();
+}
+
+/**
+ * Gets the amount of nodes in the hierarchy
+ *
+ * @return Amount of nodes in the hierarchy
+ */
+int Bvh::getNodeCount(){
+    return this->nodes_.size();
+}
+
+/**
+ * Gets a node of the hierarchy. The root is the first node.
+ *
+ * @param index Index of the node
+ * @return Node at the given index
+ */
+BvhNode* Bvh::getNodeAt(int index){
+    return &this->nodes_[index];
+}
+
+/**
+ * Gets the geometry at the given position in the order of the leaves. Each 
+ * leaf holds a contiguous range of this order.
+ *
+ * @param index Position of the geometry
+ * @return Geometry at the given position
+ */
+Geometry* Bvh::getGeometryAt(int index){
+    return this->geometry_[index];
+}
+
+/**
+ * Computes the memory held by the nodes and geometry list of the hierarchy
+ *
+ * @return Size of the hierarchy in bytes
+ */
+long long Bvh::getMemoryUsage(){
+    return (long long)this->nodes_.capacity() * sizeof(BvhNode) + 
+           (long long)this->geometry_.capacity() * sizeof(Geometry*);
+}
+
+/**
+ * Returns the type of Acceleration Structure
+ * 
+ * Acceleration Structure Flag List (10/19/2016)
+ * 
+ * 0: Bounding Volume Hierarchy
+ * 1: Compressed Bounding Volume Hierarchy
+ * 2: 4-wide Bounding Volume Hierarchy
+ * 3: Uniform Grid
+ * 4: Two-Level Grid
+ * 
+ * @return The flag defining the structure as a bounding volume hierarchy (0)
+ */
+int Bvh::getType(){
+    return 0;
+}
+
+/**
+ * Gets the Surface Area Heuristic cost of the hierarchy as of the last build 
+ * or refit: the expected cost of tracing a ray that crosses the root box, in
+ * units of intersection tests
+ *
+ * @return Current cost of the hierarchy
+ */
+double Bvh::getCost(){
+    return this->cost_;
+}
+
+/**
+ * Gets the Surface Area Heuristic cost of the hierarchy right after it was 
+ * last built
+ *
+ * @return Cost of the hierarchy when built
+ */
+double Bvh::getBuildCost(){
+    return this->build_cost_;
+}
+
+/**
+ * Sets how much the cost of the hierarchy may grow through refitting, as a 
+ * fraction of its cost when built, before it is rebuilt
+ *
+ * @param rebuild_threshold Allowed growth of the cost (e.g. 0.25 for 25%)
+ */
+void Bvh::setRebuildThreshold(double rebuild_threshold){
+    this->rebuild_threshold_ = rebuild_threshold;
+}
+
+/**
+ * Gets how much the cost of the hierarchy may grow through refitting before
+ * it is rebuilt
+ *
+ * @return Allowed growth of the cost
+ */
+double Bvh::getRebuildThreshold(){
+    return this->rebuild_threshold_;
+}
+
+/**
+ * Recursively builds the node enclosing the given range of primitives. The
+ * centers of the primitives are sorted into bins along each axis, and the 
+ * split between bins with the lowest cost under the Surface Area Heuristic 
+ * is chosen: the chance of a ray crossing each side (proportional to its 
+ * surface area) times the amount of geometry on that side. The range becomes
+ * a leaf when no split is cheaper than testing all of its geometry.
+ * 
+ * On skewed geometry the cheapest split may only cut off a few primitives at
+ * a time, so past BVH_MEDIAN_SPLIT_DEPTH ranges are split at their median 
+ * along the longest axis of their centers instead. Halving the range leaves 
+ * at most 28 more levels, so no leaf is deeper than 60 and the traversal 
+ * stacks of BVH_STACK_SIZE entries cannot overflow.
+ *
+ * @param primitives Primitives being sorted into the hierarchy
+ * @param begin Index of the first primitive in the range
+ * @param end Index after the last primitive in the range
+ * @param depth Depth of the node (0 for the root)
+ * @return Index of the node built
+ */
+int Bvh::buildNode(std::vector<BvhPrimitive>* primitives, int begin, int end, int depth){
+    int node_index = this->nodes_.size();
+    this->nodes_.push_back(BvhNode());
+    
+    BoundingBox bounds;
+    BoundingBox center_bounds;
+    for (int i = begin; i < end; i++) {
+        bounds.expand((*primitives)[i].bounds);
+        center_bounds.expand((*primitives)[i].center);
+    }
+    this->nodes_[node_index].bounds = bounds;
+    this->nodes_[node_index].first_geometry_index = begin;
+    this->nodes_[node_index].geometry_count = end - begin;
+    this->nodes_[node_index].second_child_index = -1;
+    
+    int count = end - begin;
+    if(count <= 1){
+        return node_index;
+    }
+    
+    if(depth >= BVH_MEDIAN_SPLIT_DEPTH){
+        if(count <= BVH_MAX_LEAF_SIZE){
+            return node_index;
+        }
+        
+        BvhAxisOrder order;
+        order.axis = 0;
+        for (int axis = 1; axis < 3; axis++) {
+            if(getAxis(center_bounds.getMax(), axis) - getAxis(center_bounds.getMin(), axis) > 
+               getAxis(center_bounds.getMax(), order.axis) - getAxis(center_bounds.getMin(), order.axis)){
+                order.axis = axis;
+            }
+        }
+        int middle = (begin + end) / 2;
+        std::nth_element(primitives->begin() + begin, primitives->begin() + middle, primitives->begin() + end, order);
+        
+        buildNode(primitives, begin, middle, depth + 1);
+        int second_child_index = buildNode(primitives, middle, end, depth + 1);
+        this->nodes_[node_index].geometry_count = 0;
+        this->nodes_[node_index].second_child_index = second_child_index;
+        return node_index;
+    }
+    
+    //Find the split with the lowest cost over all axes
+    double best_cost = INFINITY;
+    int best_axis = -1;
+    int best_bin = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        double min_center = getAxis(center_bounds.getMin(), axis);
+        double extent = getAxis(center_bounds.getMax(), axis) - min_center;
+        if(extent <= 0){
+            continue;
+        }
+        
+        BvhBinPartition partition;
+        partition.axis = axis;
+        partition.min_center = min_center;
+        partition.bin_scale = BVH_BIN_COUNT / extent;
+        
+        int bin_counts[BVH_BIN_COUNT] = {0};
+        BoundingBox bin_bounds[BVH_BIN_COUNT];
+        for (int i = begin; i < end; i++) {
+            int bin = std::min((int)((getAxis((*primitives)[i].center, axis) - min_center) * partition.bin_scale), BVH_BIN_COUNT - 1);
+            bin_counts[bin]++;
+            bin_bounds[bin].expand((*primitives)[i].bounds);
+        }
+        
+        //Sweep from the right to find the area and count right of each split
+        double right_area[BVH_BIN_COUNT];
+        int right_count[BVH_BIN_COUNT];
+        BoundingBox right_bounds;
+        int running_count = 0;
+        for (int bin = BVH_BIN_COUNT - 1; bin > 0; bin--) {
+            right_bounds.expand(bin_bounds[bin]);
+            running_count += bin_counts[bin];
+            right_area[bin] = right_bounds.getSurfaceArea();
+            right_count[bin] = running_count;
+        }
+        
+        BoundingBox left_bounds;
+        running_count = 0;
+        for (int bin = 1; bin < BVH_BIN_COUNT; bin++) {
+            left_bounds.expand(bin_bounds[bin - 1]);
+            running_count += bin_counts[bin - 1];
+            if(running_count == 0 || right_count[bin] == 0){
+                continue;
+            }
+            double cost = left_bounds.getSurfaceArea() * running_count + right_area[bin] * right_count[bin];
+            if(cost < best_cost){
+                best_cost = cost;
+                best_axis = axis;
+                best_bin = bin;
+            }
+        }
+    }
+    
+    double leaf_cost = count;
+    double split_cost = BVH_TRAVERSAL_COST + best_cost / bounds.getSurfaceArea();
+    if(best_axis < 0 || split_cost >= leaf_cost){
+        if(count <= BVH_MAX_LEAF_SIZE){
+            return node_index;
+        }
+    }
+    
+    int middle;
+    if(best_axis >= 0){
+        BvhBinPartition partition;
+        partition.axis = best_axis;
+        partition.split_bin = best_bin;
+        partition.min_center = getAxis(center_bounds.getMin(), best_axis);
+        partition.bin_scale = BVH_BIN_COUNT / (getAxis(center_bounds.getMax(), best_axis) - partition.min_center);
+        middle = std::partition(primitives->begin() + begin, primitives->begin() + end, partition) - primitives->begin();
+    } else {
+        //Every center is in the same place, so split the range in half
+        middle = (begin + end) / 2;
+    }
+    
+    buildNode(primitives, begin, middle, depth + 1);
+    int second_child_index = buildNode(primitives, middle, end, depth + 1);
+    
+    //The node list may have been reallocated while building the children
+    this->nodes_[node_index].geometry_count = 0;
+    this->nodes_[node_index].second_child_index = second_child_index;
+    
+    return node_index;
+}
+
+/**
+ * Cuts the subtree of a node into the subtrees found the given number of 
+ * levels below it, which can be refit independently. Each subtree is stored
+ * as the range of its nodes, and the nodes above them are listed in order.
+ *
+ * @param node_index Index of the root of the subtree
+ * @param end_index Index after the last node of the subtree
+ * @param split_depth Number of levels to descend
+ * @param subtree_bounds Resulting first and end index of each subtree
+ * @param top_nodes Resulting nodes above the subtrees
+ */
+void Bvh::collectSubtrees(int node_index, int end_index, int split_depth, std::vector<int>* subtree_bounds, std::vector<int>* top_nodes){
+    BvhNode* node = &this->nodes_[node_index];
+    if(split_depth == 0 || node->geometry_count > 0){
+        subtree_bounds->push_back(node_index);
+        subtree_bounds->push_back(end_index);
+        return;
+    }
+    top_nodes->push_back(node_index);
+    int second_child_index = node->second_child_index;
+    collectSubtrees(node_index + 1, second_child_index, split_depth - 1, subtree_bounds, top_nodes);
+    collectSubtrees(second_child_index, end_index, split_depth - 1, subtree_bounds, top_nodes);
+}
+
+/**
+ * Refits a range of nodes holding whole subtrees, from last to first
+ *
+ * @param first_index Index of the first node of the range
+ * @param end_index Index after the last node of the range
+ * @param cost Resulting sum of the costs of the nodes, scaled by surface area
+ */
+void Bvh::refitRange(int first_index, int end_index, double* cost){
+    double range_cost = 0.0;
+    for (int i = end_index - 1; i >= first_index; i--) {
+        range_cost += refitNode(i);
+    }
+    *cost = range_cost;
+}
+
+/**
+ * Updates the box of a node to enclose its geometry, or the boxes of its 
+ * children, which must be up to date
+ *
+ * @param node_index Index of the node to refit
+ * @return Cost of the node, scaled by its surface area
+ */
+double Bvh::refitNode(int node_index){
+    BvhNode* node = &this->nodes_[node_index];
+    BoundingBox bounds;
+    if(node->geometry_count > 0){
+        for (int j = node->first_geometry_index; j < node->first_geometry_index + node->geometry_count; j++) {
+            bounds.expand(this->geometry_[j]->getBounds());
+        }
+        node->bounds = bounds;
+        return bounds.getSurfaceArea() * node->geometry_count;
+    }
+    bounds.expand(this->nodes_[node_index + 1].bounds);
+    bounds.expand(this->nodes_[node->second_child_index].bounds);
+    node->bounds = bounds;
+    return bounds.getSurfaceArea() * BVH_TRAVERSAL_COST;
+}
+
+/**
+ * Computes the Surface Area Heuristic cost of the hierarchy. Each node costs
+ * its traversal, or the tests of its geometry for a leaf, weighted by the 
+ * chance that a ray crossing the root box also crosses the box of the node.
+ *
+ * @return Cost of the hierarchy
+ */
+double Bvh::computeCost(){
+    if(this->nodes_.empty()){
+        return 0.0;
+    }
+    double cost = 0.0;
+    for (unsigned int i = 0; i < this->nodes_.size(); i++) {
+        BvhNode* node = &this->nodes_[i];
+        cost += node->bounds.getSurfaceArea() * (node->geometry_count > 0 ? node->geometry_count : BVH_TRAVERSAL_COST);
+    }
+    double root_area = this->nodes_[0].bounds.getSurfaceArea();
+    return root_area > 0 ? cost / root_area : 0.0;
+}
+
+/**
+ * Intersects a ray with the box of a node using the slab method, limited to
+ * the part of the ray closer than the given distance
+ *
+ * @param node Node whose box to intersect
+ * @param origin Origin of the ray
+ * @param inverse_direction Inverse of each component of the ray's direction
+ * @param max_distance Distance beyond which intersections are ignored
+ * @param entry_distance Resulting distance at which the ray enters the box
+ * @return Flag indicating whether the ray crosses the box
+ */
+bool Bvh::intersectBounds(BvhNode* node, double origin[3], double inverse_direction[3], double max_distance, double &entry_distance){
+    Point3D min_corner = node->bounds.getMin();
+    Point3D max_corner = node->bounds.getMax();
+    double near_distance = 0.0;
+    double far_distance = max_distance;
+    for (int axis = 0; axis < 3; axis++) {
+        double near_plane = (getAxis(min_corner, axis) - origin[axis]) * inverse_direction[axis];
+        double far_plane = (getAxis(max_corner, axis) - origin[axis]) * inverse_direction[axis];
+        if(near_plane > far_plane){
+            std::swap(near_plane, far_plane);
+        }
+        //Written so that NaN (a ray parallel to and on a slab) keeps the interval open
+        near_distance = near_plane > near_distance ? near_plane : near_distance;
+        far_distance = far_plane < far_distance ? far_plane : far_distance;
+        if(near_distance > far_distance){
+            return false;
+        }
+    }
+    entry_distance = near_distance;
+    return true;
+}
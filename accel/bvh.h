@@ -0,0 +1,113 @@
+// Ray Tracer: bvh.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Bounding Volume Hierarchy sorts the geometry of the scene 
+//                  into a tree of boxes, so a ray only has to be tested 
+//                  against the geometry inside the boxes it crosses. The 
+//                  tree is split using the Surface Area Heuristic, and can 
+//                  be refit to geometry that moved without rebuilding it.
+//                  Refitting runs on several threads for large trees, and 
+//                  the tree is rebuilt once refitting has made it too slow.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef BVH_H
+#define BVH_H
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "acceleration_structure.h"
+
+#include "../ray.h"
+
+#include "../geo/geometry.h"
+
+#include "../math/bounding_box.h"
+#include "../math/point3d.h"
+#include "../math/vector3d.h"
+
+class Scene;
+
+#define BVH_BIN_COUNT 12
+#define BVH_MAX_LEAF_SIZE 8
+#define BVH_TRAVERSAL_COST 0.125
+#define BVH_STACK_SIZE 64
+#define BVH_MEDIAN_SPLIT_DEPTH 32
+#define BVH_PARALLEL_REFIT_MIN_NODES 4096
+#define DEFAULT_BVH_REBUILD_THRESHOLD 0.25
+
+//A node of the flattened hierarchy. The first child of an interior node 
+//directly follows it, the second child is found at second_child_index.
+struct BvhNode {
+    BoundingBox bounds;
+    int first_geometry_index;
+    int geometry_count;
+    int second_child_index;
+};
+
+//Geometry being sorted into the hierarchy, with its box computed once
+struct BvhPrimitive {
+    Geometry* geometry;
+    BoundingBox bounds;
+    Point3D center;
+};
+
+class Bvh: public AccelerationStructure {
+public:
+    Bvh(Scene* scene);
+    Bvh(std::vector<Geometry*> geometry);
+    virtual ~Bvh();
+    
+    void build();
+    bool refit();
+    
+    Geometry* computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point);
+    bool hasIntersection(Ray* ray);
+    
+    int getGeometryCount();
+    int getNodeCount();
+    BvhNode* getNodeAt(int index);
+    Geometry* getGeometryAt(int index);
+    long long getMemoryUsage();
+    int getType();
+    double getCost();
+    double getBuildCost();
+    void setRebuildThreshold(double rebuild_threshold);
+    double getRebuildThreshold();
+    
+private:
+    int buildNode(std::vector<BvhPrimitive>* primitives, int begin, int end, int depth);
+    void collectSubtrees(int node_index, int end_index, int split_depth, std::vector<int>* subtree_bounds, std::vector<int>* top_nodes);
+    void refitRange(int first_index, int end_index, double* cost);
+    double refitNode(int node_index);
+    double computeCost();
+    bool intersectBounds(BvhNode* node, double origin[3], double inverse_direction[3], double max_distance, double &entry_distance);
+    
+    Scene* scene_;
+    std::vector<Geometry*> source_geometry_;
+    std::vector<Geometry*> geometry_;
+    std::vector<BvhNode> nodes_;
+    double cost_;
+    double build_cost_;
+    double rebuild_threshold_;
+};
+
+#endif /* BVH_H */
@@ -0,0 +1,430 @@
+// Ray Tracer: bvh4.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: A 4-wide Bounding Volume Hierarchy gives each node up to four
+//                  children, whose boxes are stored axis by axis so a ray 
+//                  is tested against all four boxes at once with SSE 
+//                  instructions. The tree is made by collapsing the levels 
+//                  of a binary Bvh.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "bvh4.h"
+
+#include "../scene.h"
+
+//Widens the far distance of box tests to cover the rounding of float math
+#define BVH4_ROBUST_SCALE 1.0000004f
+
+//Gets one coordinate of a point by axis (0: X, 1: Y, 2: Z)
+static double getAxis(Point3D point, int axis){
+    switch(axis){
+        case 0: return point.getX();
+        case 1: return point.getY();
+        default: return point.getZ();
+    }
+}
+
+//Converts to the nearest float that is not above the value
+static float roundDown(double value){
+    float result = (float)value;
+    return (result > value) ? nextafterf(result, -INFINITY) : result;
+}
+
+//Converts to the nearest float that is not below the value
+static float roundUp(double value){
+    float result = (float)value;
+    return (result < value) ? nextafterf(result, INFINITY) : result;
+}
+
+/**
+ * Builds the 4-wide hierarchy over the geometry of the scene. The hierarchy 
+ * does not take ownership of the geometry.
+ *
+ * @param scene Scene containing the geometry
+ */
+Bvh4::Bvh4(Scene* scene){
+    this->scene_ = scene;
+    this->nodes_ = NULL;
+    build();
+}
+
+Bvh4::~Bvh4(){}
+
+/**
+ * Builds the hierarchy from scratch over the geometry currently in the scene.
+ * The binary tree of a Bvh is built first, then collapsed.
+ */
+void Bvh4::build(){
+    Bvh* bvh = new Bvh(this->scene_);
+    
+    this->geometry_.resize(bvh->getGeometryCount());
+    for (int i = 0; i < bvh->getGeometryCount(); i++) {
+        this->geometry_[i] = bvh->getGeometryAt(i);
+    }
+    
+    std::vector<Bvh4Node> nodes;
+    this->root_reference_ = 0;
+    if(bvh->getNodeCount() > 0){
+        nodes.reserve(bvh->getNodeCount() / 3 + 1);
+        if(bvh->getNodeAt(0)->geometry_count > 0){
+            //A root leaf still needs a node to hold its box
+            nodes.push_back(Bvh4Node());
+            this->root_reference_ = 0;
+            nodes[0].child_count = 1;
+            BoundingBox bounds = bvh->getNodeAt(0)->bounds;
+            for (int axis = 0; axis < 3; axis++) {
+                for (int child = 0; child < BVH4_WIDTH; child++) {
+                    nodes[0].bounds[axis][child] = roundDown(getAxis(bounds.getMin(), axis));
+                    nodes[0].bounds[axis + 3][child] = roundUp(getAxis(bounds.getMax(), axis));
+                }
+            }
+            nodes[0].child_reference[0] = collapseNode(bvh, 0, &nodes, 1);
+        } else {
+            this->root_reference_ = collapseNode(bvh, 0, &nodes, 0);
+        }
+    }
+    delete bvh;
+    
+    //Align the nodes to the start of a cache line
+    this->node_count_ = nodes.size();
+    this->node_storage_.assign(nodes.size() * sizeof(Bvh4Node) + BVH4_NODE_ALIGNMENT, 0);
+    uintptr_t address = (uintptr_t)&this->node_storage_[0];
+    this->nodes_ = (Bvh4Node*)((address + BVH4_NODE_ALIGNMENT - 1) & ~(uintptr_t)(BVH4_NODE_ALIGNMENT - 1));
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        this->nodes_[i] = nodes[i];
+    }
+}
+
+/**
+ * Updates the hierarchy after geometry moved. The hierarchy is rebuilt, as 
+ * the binary tree it is collapsed from is not kept.
+ *
+ * @return Flag indicating whether the tree was rebuilt (always true)
+ */
+bool Bvh4::refit(){
+    build();
+    return true;
+}
+
+/**
+ * Finds the geometry nearest to the origin of the ray that the ray intersects.
+ * The ray is tested against the four children of a node at once, and the 
+ * children it hits are visited from nearest to furthest. Nodes further away
+ * than the nearest intersection found so far are skipped.
+ *
+ * @param ray Ray to compute intersections with
+ * @param nearest_point Resulting point of the nearest intersection
+ * @param normal_at_nearest_point Resulting normal at the nearest intersection
+ * @return Geometry nearest to the origin of the ray (NULL if none is hit)
+ */
+Geometry* Bvh4::computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point){
+    Geometry* nearest_geometry = NULL;
+    if(this->node_count_ == 0){
+        return nearest_geometry;
+    }
+    
+    float nearest_intersection_distance = INFINITY;
+    float origin[3] = {(float)ray->getOrigin()->getX(), (float)ray->getOrigin()->getY(), (float)ray->getOrigin()->getZ()};
+    float inverse_direction[3] = {(float)(1.0 / ray->getDirection()->getX()), (float)(1.0 / ray->getDirection()->getY()), (float)(1.0 / ray->getDirection()->getZ())};
+    float max_distance = (float)ray->getMaxDistance();
+    
+    Point3D point_hit (0,0,0);
+    Vector3D normal_hit (1,1,1);
+    
+    Bvh4StackEntry stack[BVH4_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size].reference = this->root_reference_;
+    stack[stack_size].entry_distance = 0;
+    stack_size++;
+    
+    while(stack_size > 0){
+        Bvh4StackEntry entry = stack[--stack_size];
+        if(entry.entry_distance > nearest_intersection_distance){
+            continue;
+        }
+        
+        if(entry.reference & BVH4_LEAF_FLAG){
+            int first = entry.reference & ((1u << BVH4_COUNT_SHIFT) - 1);
+            int count = ((entry.reference & ~BVH4_LEAF_FLAG) >> BVH4_COUNT_SHIFT) + 1;
+            for (int i = first; i < first + count; i++) {
+                Geometry* geometry_hit = this->geometry_[i]->computeNearestIntersection(ray, &point_hit, &normal_hit);
+                if (geometry_hit != NULL) {
+                    float distance = ray->getOrigin()->computeDistance(&point_hit);
+                    if (distance < nearest_intersection_distance) {
+                        nearest_geometry = geometry_hit;
+                        nearest_intersection_distance = distance;
+                        *nearest_point = point_hit;
+                        *normal_at_nearest_point = normal_hit;
+                    }
+                }
+            }
+            continue;
+        }
+        
+        Bvh4Node* node = &this->nodes_[entry.reference];
+        float entry_distances[BVH4_WIDTH];
+        int hit_mask = intersectChildren(node, origin, inverse_direction, std::min(nearest_intersection_distance, max_distance), entry_distances);
+        
+        //Sort the children hit from furthest to nearest, then push them in that order
+        int hit_children[BVH4_WIDTH];
+        int hit_count = 0;
+        for (int child = 0; child < node->child_count; child++) {
+            if(!(hit_mask & (1 << child))){
+                continue;
+            }
+            int position = hit_count++;
+            while(position > 0 && entry_distances[hit_children[position - 1]] < entry_distances[child]){
+                hit_children[position] = hit_children[position - 1];
+                position--;
+            }
+            hit_children[position] = child;
+        }
+        for (int i = 0; i < hit_count; i++) {
+            stack[stack_size].reference = node->child_reference[hit_children[i]];
+            stack[stack_size].entry_distance = entry_distances[hit_children[i]];
+            stack_size++;
+        }
+    }
+    
+    return nearest_geometry;
+}
+
+/**
+ * Determines if the ray intersects any geometry within its interval. The 
+ * search stops at the first intersection found.
+ *
+ * @param ray Ray to compute intersections with
+ * @return Result of the check
+ */
+bool Bvh4::hasIntersection(Ray* ray){
+    if(this->node_count_ == 0){
+        return false;
+    }
+    
+    float origin[3] = {(float)ray->getOrigin()->getX(), (float)ray->getOrigin()->getY(), (float)ray->getOrigin()->getZ()};
+    float inverse_direction[3] = {(float)(1.0 / ray->getDirection()->getX()), (float)(1.0 / ray->getDirection()->getY()), (float)(1.0 / ray->getDirection()->getZ())};
+    float max_distance = (float)ray->getMaxDistance();
+    
+    Point3D point_hit_noop (0,0,0);
+    Vector3D normal_hit_noop (1,1,1);
+    
+    uint32_t stack[BVH4_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = this->root_reference_;
+    
+    while(stack_size > 0){
+        uint32_t reference = stack[--stack_size];
+        
+        if(reference & BVH4_LEAF_FLAG){
+            int first = reference & ((1u << BVH4_COUNT_SHIFT) - 1);
+            int count = ((reference & ~BVH4_LEAF_FLAG) >> BVH4_COUNT_SHIFT) + 1;
+            for (int i = first; i < first + count; i++) {
+                if (this->geometry_[i]->hasIntersection(ray, &point_hit_noop, &normal_hit_noop)) {
+                    return true;
+                }
+            }
+            continue;
+        }
+        
+        Bvh4Node* node = &this->nodes_[reference];
+        float entry_distances[BVH4_WIDTH];
+        int hit_mask = intersectChildren(node, origin, inverse_direction, max_distance, entry_distances);
+        for (int child = node->child_count - 1; child >= 0; child--) {
+            if(hit_mask & (1 << child)){
+                stack[stack_size++] = node->child_reference[child];
+            }
+        }
+    }
+    
+    return false;
+}
+
+/**
+ * Gets the amount of geometry sorted into the hierarchy
+ *
+ * @return Amount of geometry in the hierarchy
+ */
+int Bvh4::getGeometryCount(){
+    return this->geometry_.size();
+}
+
+/**
+ * Gets the amount of nodes in the hierarchy. Leaves are stored in their 
+ * parent.
+ *
+ * @return Amount of nodes in the hierarchy
+ */
+int Bvh4::getNodeCount(){
+    return this->node_count_;
+}
+
+/**
+ * Computes the memory held by the nodes and geometry list of the hierarchy
+ *
+ * @return Size of the hierarchy in bytes
+ */
+long long Bvh4::getMemoryUsage(){
+    return (long long)this->node_storage_.capacity() + 
+           (long long)this->geometry_.capacity() * sizeof(Geometry*);
+}
+
+/**
+ * Returns the type of Acceleration Structure
+ * 
+ * Acceleration Structure Flag List (10/19/2016)
+ * 
+ * 0: Bounding Volume Hierarchy
+ * 1: Compressed Bounding Volume Hierarchy
+ * 2: 4-wide Bounding Volume Hierarchy
+ * 3: Uniform Grid
+ * 4: Two-Level Grid
+ * 
+ * @return The flag defining the structure as a 4-wide bounding volume hierarchy (2)
+ */
+int Bvh4::getType(){
+    return 2;
+}
+
+/**
+ * Recursively collapses a node of a binary Bvh into a 4-wide node. Starting 
+ * from the two children of the node, the interior child with the largest 
+ * box is replaced by its own two children until there are four children or 
+ * only leaves remain, which removes every other level of the binary tree.
+ * 
+ * While a node at depth d is visited, the traversal stack holds at most 
+ * three siblings from each level above it, then its own four children. The
+ * binary hierarchy is at most 60 levels deep, so this stays well within 
+ * BVH4_STACK_SIZE, but it is checked here rather than during traversal.
+ *
+ * @param bvh Binary hierarchy being collapsed
+ * @param bvh_index Index of the node of the binary hierarchy to collapse
+ * @param nodes 4-wide nodes built so far
+ * @param depth Depth of the 4-wide node (0 for the root)
+ * @return Reference to the 4-wide node or leaf
+ */
+uint32_t Bvh4::collapseNode(Bvh* bvh, int bvh_index, std::vector<Bvh4Node>* nodes, int depth){
+    BvhNode* bvh_node = bvh->getNodeAt(bvh_index);
+    if(bvh_node->geometry_count > 0){
+        if(bvh_node->geometry_count > BVH4_MAX_LEAF_SIZE || bvh_node->first_geometry_index >= (1 << BVH4_COUNT_SHIFT)){
+            throw std::length_error("Leaf of the hierarchy is too large for a 4-wide node.");
+        }
+        return BVH4_LEAF_FLAG | ((uint32_t)(bvh_node->geometry_count - 1) << BVH4_COUNT_SHIFT) | bvh_node->first_geometry_index;
+    }
+    if((BVH4_WIDTH - 1) * depth + BVH4_WIDTH > BVH4_STACK_SIZE){
+        throw std::length_error("Hierarchy is too deep for the 4-wide traversal stack.");
+    }
+    
+    int children[BVH4_WIDTH] = {bvh_index + 1, bvh_node->second_child_index, 0, 0};
+    int child_count = 2;
+    while(child_count < BVH4_WIDTH){
+        int largest_child = -1;
+        double largest_area = -1;
+        for (int i = 0; i < child_count; i++) {
+            BvhNode* child_node = bvh->getNodeAt(children[i]);
+            if(child_node->geometry_count == 0 && child_node->bounds.getSurfaceArea() > largest_area){
+                largest_child = i;
+                largest_area = child_node->bounds.getSurfaceArea();
+            }
+        }
+        if(largest_child < 0){
+            break;
+        }
+        int opened_index = children[largest_child];
+        children[largest_child] = opened_index + 1;
+        children[child_count++] = bvh->getNodeAt(opened_index)->second_child_index;
+    }
+    
+    int node_index = nodes->size();
+    nodes->push_back(Bvh4Node());
+    Bvh4Node* node = &(*nodes)[node_index];
+    node->child_count = child_count;
+    for (int child = 0; child < BVH4_WIDTH; child++) {
+        node->child_reference[child] = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            //Unused slots hold an inverted box, and are masked out by the child count
+            node->bounds[axis][child] = INFINITY;
+            node->bounds[axis + 3][child] = -INFINITY;
+        }
+    }
+    for (int child = 0; child < child_count; child++) {
+        BoundingBox bounds = bvh->getNodeAt(children[child])->bounds;
+        for (int axis = 0; axis < 3; axis++) {
+            node->bounds[axis][child] = roundDown(getAxis(bounds.getMin(), axis));
+            node->bounds[axis + 3][child] = roundUp(getAxis(bounds.getMax(), axis));
+        }
+    }
+    
+    for (int child = 0; child < child_count; child++) {
+        uint32_t reference = collapseNode(bvh, children[child], nodes, depth + 1);
+        (*nodes)[node_index].child_reference[child] = reference;
+    }
+    return node_index;
+}
+
+/**
+ * Intersects a ray with the boxes of the children of a node using the slab 
+ * method. With SSE, the four boxes are tested at once. The far distance is 
+ * widened slightly so rounding never causes a box to be missed.
+ *
+ * @param node Node whose children to intersect
+ * @param origin Origin of the ray
+ * @param inverse_direction Inverse of each component of the ray's direction
+ * @param max_distance Distance beyond which intersections are ignored
+ * @param entry_distances Resulting distance at which the ray enters each box
+ * @return Mask with a bit set for each child whose box the ray crosses
+ */
+int Bvh4::intersectChildren(Bvh4Node* node, float origin[3], float inverse_direction[3], float max_distance, float entry_distances[BVH4_WIDTH]){
+    int valid_mask = (1 << node->child_count) - 1;
+#ifdef __SSE__
+    __m128 near_distance = _mm_setzero_ps();
+    __m128 far_distance = _mm_set1_ps(max_distance);
+    for (int axis = 0; axis < 3; axis++) {
+        __m128 ray_origin = _mm_set1_ps(origin[axis]);
+        __m128 ray_inverse_direction = _mm_set1_ps(inverse_direction[axis]);
+        __m128 near_plane = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node->bounds[axis]), ray_origin), ray_inverse_direction);
+        __m128 far_plane = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node->bounds[axis + 3]), ray_origin), ray_inverse_direction);
+        //min and max return their second operand when either is NaN (a ray parallel to and on a slab), 
+        //which keeps the interval open
+        near_distance = _mm_max_ps(_mm_min_ps(near_plane, far_plane), near_distance);
+        far_distance = _mm_min_ps(_mm_max_ps(near_plane, far_plane), far_distance);
+    }
+    far_distance = _mm_mul_ps(far_distance, _mm_set1_ps(BVH4_ROBUST_SCALE));
+    _mm_storeu_ps(entry_distances, near_distance);
+    return _mm_movemask_ps(_mm_cmple_ps(near_distance, far_distance)) & valid_mask;
+#else
+    int hit_mask = 0;
+    for (int child = 0; child < BVH4_WIDTH; child++) {
+        float near_distance = 0.0f;
+        float far_distance = max_distance;
+        for (int axis = 0; axis < 3; axis++) {
+            float near_plane = (node->bounds[axis][child] - origin[axis]) * inverse_direction[axis];
+            float far_plane = (node->bounds[axis + 3][child] - origin[axis]) * inverse_direction[axis];
+            float min_plane = near_plane < far_plane ? near_plane : far_plane;
+            float max_plane = near_plane > far_plane ? near_plane : far_plane;
+            near_distance = min_plane > near_distance ? min_plane : near_distance;
+            far_distance = max_plane < far_distance ? max_plane : far_distance;
+        }
+        entry_distances[child] = near_distance;
+        if(near_distance <= far_distance * BVH4_ROBUST_SCALE){
+            hit_mask |= 1 << child;
+        }
+    }
+    return hit_mask & valid_mask;
+#endif
+}
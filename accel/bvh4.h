@@ -0,0 +1,107 @@
+// Ray Tracer: bvh4.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: A 4-wide Bounding Volume Hierarchy gives each node up to four
+//                  children, whose boxes are stored axis by axis so a ray 
+//                  is tested against all four boxes at once with SSE 
+//                  instructions. The tree is made by collapsing the levels 
+//                  of a binary Bvh.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef BVH4_H
+#define BVH4_H
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <stdint.h>
+#include <vector>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "acceleration_structure.h"
+#include "bvh.h"
+
+#include "../ray.h"
+
+#include "../geo/geometry.h"
+
+#include "../math/bounding_box.h"
+#include "../math/point3d.h"
+#include "../math/vector3d.h"
+
+class Scene;
+
+#define BVH4_WIDTH 4
+#define BVH4_LEAF_FLAG 0x80000000u
+#define BVH4_COUNT_SHIFT 27
+#define BVH4_MAX_LEAF_SIZE 16
+#define BVH4_NODE_ALIGNMENT 64
+#define BVH4_STACK_SIZE (BVH_STACK_SIZE * BVH4_WIDTH)
+
+//A node of the 4-wide hierarchy. The boxes of the children are stored 
+//component by component (minimum X of all four children, then minimum Y,
+//and so on), rounded outward to float. A child reference with the leaf flag
+//set holds the size of the leaf less one (4 bits) and its first geometry 
+//(27 bits), otherwise it is the index of the child node. The node is padded
+//to two cache lines.
+struct Bvh4Node {
+    float bounds[6][BVH4_WIDTH];
+    uint32_t child_reference[BVH4_WIDTH];
+    int child_count;
+    int padding[3];
+};
+
+//A node waiting to be visited, with the distance at which the ray enters it
+struct Bvh4StackEntry {
+    uint32_t reference;
+    float entry_distance;
+};
+
+class Bvh4: public AccelerationStructure {
+public:
+    Bvh4(Scene* scene);
+    virtual ~Bvh4();
+    
+    void build();
+    bool refit();
+    
+    Geometry* computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point);
+    bool hasIntersection(Ray* ray);
+    
+    int getGeometryCount();
+    int getNodeCount();
+    long long getMemoryUsage();
+    int getType();
+    
+private:
+    uint32_t collapseNode(Bvh* bvh, int bvh_index, std::vector<Bvh4Node>* nodes, int depth);
+    static int intersectChildren(Bvh4Node* node, float origin[3], float inverse_direction[3], float max_distance, float entry_distances[BVH4_WIDTH]);
+    
+    Scene* scene_;
+    std::vector<Geometry*> geometry_;
+    std::vector<unsigned char> node_storage_;
+    Bvh4Node* nodes_;
+    int node_count_;
+    uint32_t root_reference_;
+};
+
+#endif /* BVH4_H */
@@ -0,0 +1,445 @@
+// Ray Tracer: compressed_bvh.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Compressed Bounding Volume Hierarchy has the same tree as 
+//                  a Bvh, but stores the boxes of the children of each node
+//                  in 16-bit steps across the box of the node, so a node 
+//                  fits in 32 bytes and two nodes share a cache line. The 
+//                  steps are rounded outward, so a decoded box always 
+//                  encloses the real box and no intersection is missed.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "compressed_bvh.h"
+
+#include "../scene.h"
+
+//Gets one coordinate of a point by axis (0: X, 1: Y, 2: Z)
+static double getAxis(Point3D point, int axis){
+    switch(axis){
+        case 0: return point.getX();
+        case 1: return point.getY();
+        default: return point.getZ();
+    }
+}
+
+/**
+ * Builds the compressed hierarchy over the geometry of the scene. The 
+ * hierarchy does not take ownership of the geometry.
+ *
+ * @param scene Scene containing the geometry
+ */
+CompressedBvh::CompressedBvh(Scene* scene){
+    this->scene_ = scene;
+    this->nodes_ = NULL;
+    build();
+}
+
+CompressedBvh::~CompressedBvh(){}
+
+/**
+ * Builds the hierarchy from scratch over the geometry currently in the scene.
+ * The tree is built as a Bvh, then each node is compressed in the order of 
+ * the Bvh, so a node and its first child are usually in the same cache line.
+ */
+void CompressedBvh::build(){
+    Bvh* bvh = new Bvh(this->scene_);
+    
+    this->geometry_.resize(bvh->getGeometryCount());
+    for (int i = 0; i < bvh->getGeometryCount(); i++) {
+        this->geometry_[i] = bvh->getGeometryAt(i);
+    }
+    
+    std::vector<CompressedBvhNode> nodes;
+    this->root_reference_ = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        this->root_min_[axis] = 0;
+        this->root_max_[axis] = 0;
+    }
+    if(bvh->getNodeCount() > 0){
+        BoundingBox root_bounds = bvh->getNodeAt(0)->bounds;
+        for (int axis = 0; axis < 3; axis++) {
+            this->root_min_[axis] = getAxis(root_bounds.getMin(), axis);
+            this->root_max_[axis] = getAxis(root_bounds.getMax(), axis);
+        }
+        nodes.reserve(bvh->getNodeCount() / 2);
+        this->root_reference_ = compressNode(bvh, 0, &nodes, this->root_min_, this->root_max_);
+    }
+    delete bvh;
+    
+    //Align the nodes to the start of a cache line
+    this->node_count_ = nodes.size();
+    this->node_storage_.assign(nodes.size() * sizeof(CompressedBvhNode) + CACHE_LINE_SIZE, 0);
+    uintptr_t address = (uintptr_t)&this->node_storage_[0];
+    this->nodes_ = (CompressedBvhNode*)((address + CACHE_LINE_SIZE - 1) & ~(uintptr_t)(CACHE_LINE_SIZE - 1));
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        this->nodes_[i] = nodes[i];
+    }
+}
+
+/**
+ * Updates the hierarchy after geometry moved. Refitting compressed boxes 
+ * would change the boxes the children are stored relative to, so the 
+ * hierarchy is rebuilt instead.
+ *
+ * @return Flag indicating whether the tree was rebuilt (always true)
+ */
+bool CompressedBvh::refit(){
+    build();
+    return true;
+}
+
+/**
+ * Finds the geometry nearest to the origin of the ray that the ray intersects.
+ * Boxes further away than the nearest intersection found so far are skipped, 
+ * and the nearer child of each node is visited first.
+ * 
+ * The stack holds only a reference to each waiting node. The decoded boxes 
+ * of the nodes on the path from the root are kept by depth: when a node is 
+ * visited, only descendants of its sibling have been visited since it was 
+ * pushed, so the box of its parent is still at the depth above it.
+ *
+ * @param ray Ray to compute intersections with
+ * @param nearest_point Resulting point of the nearest intersection
+ * @param normal_at_nearest_point Resulting normal at the nearest intersection
+ * @return Geometry nearest to the origin of the ray (NULL if none is hit)
+ */
+Geometry* CompressedBvh::computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point){
+    Geometry* nearest_geometry = NULL;
+    if(this->geometry_.empty()){
+        return nearest_geometry;
+    }
+    
+    float nearest_intersection_distance = INFINITY;
+    double origin[3] = {ray->getOrigin()->getX(), ray->getOrigin()->getY(), ray->getOrigin()->getZ()};
+    double inverse_direction[3] = {1.0 / ray->getDirection()->getX(), 1.0 / ray->getDirection()->getY(), 1.0 / ray->getDirection()->getZ()};
+    
+    Point3D point_hit (0,0,0);
+    Vector3D normal_hit (1,1,1);
+    
+    double box_min[BVH_STACK_SIZE][3];
+    double box_max[BVH_STACK_SIZE][3];
+    CompressedBvhStackEntry stack[BVH_STACK_SIZE];
+    int stack_size = 0;
+    if(!intersectBox(this->root_min_, this->root_max_, origin, inverse_direction, ray->getMaxDistance(), stack[0].entry_distance)){
+        return nearest_geometry;
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        box_min[0][axis] = this->root_min_[axis];
+        box_max[0][axis] = this->root_max_[axis];
+    }
+    stack[0].depth = 0;
+    stack_size++;
+    
+    while(stack_size > 0){
+        CompressedBvhStackEntry entry = stack[--stack_size];
+        if(entry.entry_distance > nearest_intersection_distance){
+            continue;
+        }
+        
+        uint32_t reference = this->root_reference_;
+        CompressedBvhNode* parent = NULL;
+        if(entry.depth > 0){
+            parent = &this->nodes_[entry.parent_index];
+            reference = parent->child_reference[entry.child];
+        }
+        
+        if(reference & COMPRESSED_BVH_LEAF_FLAG){
+            int first = reference & ((1u << COMPRESSED_BVH_COUNT_SHIFT) - 1);
+            int count = ((reference & ~COMPRESSED_BVH_LEAF_FLAG) >> COMPRESSED_BVH_COUNT_SHIFT) + 1;
+            for (int i = first; i < first + count; i++) {
+                Geometry* geometry_hit = this->geometry_[i]->computeNearestIntersection(ray, &point_hit, &normal_hit);
+                if (geometry_hit != NULL) {
+                    float distance = ray->getOrigin()->computeDistance(&point_hit);
+                    if (distance < nearest_intersection_distance) {
+                        nearest_geometry = geometry_hit;
+                        nearest_intersection_distance = distance;
+                        *nearest_point = point_hit;
+                        *normal_at_nearest_point = normal_hit;
+                    }
+                }
+            }
+            continue;
+        }
+        
+        int depth = entry.depth;
+        if(parent != NULL){
+            decodeChild(parent, entry.child, box_min[depth - 1], box_max[depth - 1], box_min[depth], box_max[depth]);
+        }
+        
+        CompressedBvhNode* node = &this->nodes_[reference];
+        double distances[2];
+        bool hits[2];
+        for (int child = 0; child < 2; child++) {
+            double child_min[3], child_max[3];
+            decodeChild(node, child, box_min[depth], box_max[depth], child_min, child_max);
+            hits[child] = intersectBox(child_min, child_max, origin, inverse_direction, 
+                                       std::min((double)nearest_intersection_distance, ray->getMaxDistance()), distances[child]);
+        }
+        
+        //Push the further child first so the nearer child is visited first
+        int further_child = distances[0] <= distances[1] ? 1 : 0;
+        int order[2] = {further_child, 1 - further_child};
+        for (int i = 0; i < 2; i++) {
+            int child = order[i];
+            if(hits[child]){
+                CompressedBvhStackEntry* child_entry = &stack[stack_size++];
+                child_entry->parent_index = reference;
+                child_entry->child = child;
+                child_entry->depth = depth + 1;
+                child_entry->entry_distance = distances[child];
+            }
+        }
+    }
+    
+    return nearest_geometry;
+}
+
+/**
+ * Determines if the ray intersects any geometry within its interval. The 
+ * search stops at the first intersection found. Boxes are decoded along the
+ * path from the root as in computeNearestIntersection.
+ *
+ * @param ray Ray to compute intersections with
+ * @return Result of the check
+ */
+bool CompressedBvh::hasIntersection(Ray* ray){
+    if(this->geometry_.empty()){
+        return false;
+    }
+    
+    double origin[3] = {ray->getOrigin()->getX(), ray->getOrigin()->getY(), ray->getOrigin()->getZ()};
+    double inverse_direction[3] = {1.0 / ray->getDirection()->getX(), 1.0 / ray->getDirection()->getY(), 1.0 / ray->getDirection()->getZ()};
+    
+    Point3D point_hit_noop (0,0,0);
+    Vector3D normal_hit_noop (1,1,1);
+    
+    double box_min[BVH_STACK_SIZE][3];
+    double box_max[BVH_STACK_SIZE][3];
+    CompressedBvhStackEntry stack[BVH_STACK_SIZE];
+    int stack_size = 0;
+    if(!intersectBox(this->root_min_, this->root_max_, origin, inverse_direction, ray->getMaxDistance(), stack[0].entry_distance)){
+        return false;
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        box_min[0][axis] = this->root_min_[axis];
+        box_max[0][axis] = this->root_max_[axis];
+    }
+    stack[0].depth = 0;
+    stack_size++;
+    
+    while(stack_size > 0){
+        CompressedBvhStackEntry entry = stack[--stack_size];
+        
+        uint32_t reference = this->root_reference_;
+        CompressedBvhNode* parent = NULL;
+        if(entry.depth > 0){
+            parent = &this->nodes_[entry.parent_index];
+            reference = parent->child_reference[entry.child];
+        }
+        
+        if(reference & COMPRESSED_BVH_LEAF_FLAG){
+            int first = reference & ((1u << COMPRESSED_BVH_COUNT_SHIFT) - 1);
+            int count = ((reference & ~COMPRESSED_BVH_LEAF_FLAG) >> COMPRESSED_BVH_COUNT_SHIFT) + 1;
+            for (int i = first; i < first + count; i++) {
+                if (this->geometry_[i]->hasIntersection(ray, &point_hit_noop, &normal_hit_noop)) {
+                    return true;
+                }
+            }
+            continue;
+        }
+        
+        int depth = entry.depth;
+        if(parent != NULL){
+            decodeChild(parent, entry.child, box_min[depth - 1], box_max[depth - 1], box_min[depth], box_max[depth]);
+        }
+        
+        CompressedBvhNode* node = &this->nodes_[reference];
+        for (int child = 1; child >= 0; child--) {
+            double child_min[3], child_max[3];
+            decodeChild(node, child, box_min[depth], box_max[depth], child_min, child_max);
+            CompressedBvhStackEntry* child_entry = &stack[stack_size];
+            if(intersectBox(child_min, child_max, origin, inverse_direction, ray->getMaxDistance(), child_entry->entry_distance)){
+                child_entry->parent_index = reference;
+                child_entry->child = child;
+                child_entry->depth = depth + 1;
+                stack_size++;
+            }
+        }
+    }
+    
+    return false;
+}
+
+/**
+ * Gets the amount of geometry sorted into the hierarchy
+ *
+ * @return Amount of geometry in the hierarchy
+ */
+int CompressedBvh::getGeometryCount(){
+    return this->geometry_.size();
+}
+
+/**
+ * Gets the amount of compressed nodes in the hierarchy. Leaves are stored in
+ * their parent, so there is one node fewer than there are leaves.
+ *
+ * @return Amount of nodes in the hierarchy
+ */
+int CompressedBvh::getNodeCount(){
+    return this->node_count_;
+}
+
+/**
+ * Computes the memory held by the nodes and geometry list of the hierarchy
+ *
+ * @return Size of the hierarchy in bytes
+ */
+long long CompressedBvh::getMemoryUsage(){
+    return (long long)this->node_storage_.capacity() + 
+           (long long)this->geometry_.capacity() * sizeof(Geometry*);
+}
+
+/**
+ * Returns the type of Acceleration Structure
+ * 
+ * Acceleration Structure Flag List (10/19/2016)
+ * 
+ * 0: Bounding Volume Hierarchy
+ * 1: Compressed Bounding Volume Hierarchy
+ * 2: 4-wide Bounding Volume Hierarchy
+ * 3: Uniform Grid
+ * 4: Two-Level Grid
+ * 
+ * @return The flag defining the structure as a compressed bounding volume hierarchy (1)
+ */
+int CompressedBvh::getType(){
+    return 1;
+}
+
+/**
+ * Recursively compresses the node of a Bvh. The boxes of its children are 
+ * quantized to steps across the decoded box of the node, rather than its 
+ * real box, so decoding during traversal repeats exactly what is done here.
+ * Each step count is rounded outward, then moved further out until the 
+ * decoded box encloses the real box despite rounding. This always ends, 
+ * since zero steps decode to the edge of the node's box exactly.
+ *
+ * @param bvh Hierarchy being compressed
+ * @param bvh_index Index of the node of the hierarchy to compress
+ * @param nodes Compressed nodes built so far
+ * @param box_min Minimum corner of the decoded box of the node
+ * @param box_max Maximum corner of the decoded box of the node
+ * @return Reference to the compressed node or leaf
+ */
+uint32_t CompressedBvh::compressNode(Bvh* bvh, int bvh_index, std::vector<CompressedBvhNode>* nodes, double box_min[3], double box_max[3]){
+    BvhNode* bvh_node = bvh->getNodeAt(bvh_index);
+    if(bvh_node->geometry_count > 0){
+        if(bvh_node->geometry_count > COMPRESSED_BVH_MAX_LEAF_SIZE || bvh_node->first_geometry_index >= (1 << COMPRESSED_BVH_COUNT_SHIFT)){
+            throw std::length_error("Leaf of the hierarchy is too large to compress.");
+        }
+        return COMPRESSED_BVH_LEAF_FLAG | ((uint32_t)(bvh_node->geometry_count - 1) << COMPRESSED_BVH_COUNT_SHIFT) | bvh_node->first_geometry_index;
+    }
+    
+    int node_index = nodes->size();
+    nodes->push_back(CompressedBvhNode());
+    
+    int child_indices[2] = {bvh_index + 1, bvh_node->second_child_index};
+    double child_boxes[2][6];
+    for (int child = 0; child < 2; child++) {
+        BoundingBox child_bounds = bvh->getNodeAt(child_indices[child])->bounds;
+        CompressedBvhNode* node = &(*nodes)[node_index];
+        for (int axis = 0; axis < 3; axis++) {
+            double step = (box_max[axis] - box_min[axis]) / COMPRESSED_BVH_STEP_COUNT;
+            double child_min = getAxis(child_bounds.getMin(), axis);
+            double child_max = getAxis(child_bounds.getMax(), axis);
+            
+            int min_steps = 0;
+            int max_steps = 0;
+            if(step > 0){
+                min_steps = std::max(0, std::min(COMPRESSED_BVH_STEP_COUNT, (int)floor((child_min - box_min[axis]) / step)));
+                max_steps = std::max(0, std::min(COMPRESSED_BVH_STEP_COUNT, (int)floor((box_max[axis] - child_max) / step)));
+                while(min_steps > 0 && box_min[axis] + min_steps * step > child_min){
+                    min_steps--;
+                }
+                while(max_steps > 0 && box_max[axis] - max_steps * step < child_max){
+                    max_steps--;
+                }
+            }
+            node->child_min_steps[child][axis] = min_steps;
+            node->child_max_steps[child][axis] = max_steps;
+        }
+        decodeChild(node, child, box_min, box_max, &child_boxes[child][0], &child_boxes[child][3]);
+    }
+    
+    for (int child = 0; child < 2; child++) {
+        uint32_t reference = compressNode(bvh, child_indices[child], nodes, &child_boxes[child][0], &child_boxes[child][3]);
+        (*nodes)[node_index].child_reference[child] = reference;
+    }
+    return node_index;
+}
+
+/**
+ * Decodes the box of a child of a node
+ *
+ * @param node Node holding the child
+ * @param child Which child to decode (0 or 1)
+ * @param box_min Minimum corner of the decoded box of the node
+ * @param box_max Maximum corner of the decoded box of the node
+ * @param child_min Resulting minimum corner of the box of the child
+ * @param child_max Resulting maximum corner of the box of the child
+ */
+void CompressedBvh::decodeChild(CompressedBvhNode* node, int child, double box_min[3], double box_max[3], double child_min[3], double child_max[3]){
+    for (int axis = 0; axis < 3; axis++) {
+        double step = (box_max[axis] - box_min[axis]) / COMPRESSED_BVH_STEP_COUNT;
+        child_min[axis] = box_min[axis] + node->child_min_steps[child][axis] * step;
+        child_max[axis] = box_max[axis] - node->child_max_steps[child][axis] * step;
+    }
+}
+
+/**
+ * Intersects a ray with a box using the slab method, limited to the part of 
+ * the ray closer than the given distance
+ *
+ * @param box_min Minimum corner of the box
+ * @param box_max Maximum corner of the box
+ * @param origin Origin of the ray
+ * @param inverse_direction Inverse of each component of the ray's direction
+ * @param max_distance Distance beyond which intersections are ignored
+ * @param entry_distance Resulting distance at which the ray enters the box
+ * @return Flag indicating whether the ray crosses the box
+ */
+bool CompressedBvh::intersectBox(double box_min[3], double box_max[3], double origin[3], double inverse_direction[3], double max_distance, double &entry_distance){
+    double near_distance = 0.0;
+    double far_distance = max_distance;
+    for (int axis = 0; axis < 3; axis++) {
+        double near_plane = (box_min[axis] - origin[axis]) * inverse_direction[axis];
+        double far_plane = (box_max[axis] - origin[axis]) * inverse_direction[axis];
+        if(near_plane > far_plane){
+            std::swap(near_plane, far_plane);
+        }
+        //Written so that NaN (a ray parallel to and on a slab) keeps the interval open
+        near_distance = near_plane > near_distance ? near_plane : near_distance;
+        far_distance = far_plane < far_distance ? far_plane : far_distance;
+        if(near_distance > far_distance){
+            return false;
+        }
+    }
+    entry_distance = near_distance;
+    return true;
+}
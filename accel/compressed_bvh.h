@@ -0,0 +1,106 @@
+// Ray Tracer: compressed_bvh.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Compressed Bounding Volume Hierarchy has the same tree as 
+//                  a Bvh, but stores the boxes of the children of each node
+//                  in 16-bit steps across the box of the node, so a node 
+//                  fits in 32 bytes and two nodes share a cache line. The 
+//                  steps are rounded outward, so a decoded box always 
+//                  encloses the real box and no intersection is missed.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef COMPRESSED_BVH_H
+#define COMPRESSED_BVH_H
+
+#include <cmath>
+#include <stdexcept>
+#include <stdint.h>
+#include <vector>
+
+#include "acceleration_structure.h"
+#include "bvh.h"
+
+#include "../ray.h"
+
+#include "../geo/geometry.h"
+
+#include "../math/bounding_box.h"
+#include "../math/point3d.h"
+#include "../math/vector3d.h"
+
+class Scene;
+
+#define COMPRESSED_BVH_STEP_COUNT 65535
+#define COMPRESSED_BVH_LEAF_FLAG 0x80000000u
+#define COMPRESSED_BVH_COUNT_SHIFT 27
+#define COMPRESSED_BVH_MAX_LEAF_SIZE 16
+#define CACHE_LINE_SIZE 64
+
+//A node of the compressed hierarchy. The box of each child is stored as the
+//number of steps its minimum lies above the minimum of this node's box, and 
+//its maximum below the maximum. A child reference with the leaf flag set 
+//holds the size of the leaf less one (4 bits) and its first geometry 
+//(27 bits), otherwise it is the index of the child node.
+struct CompressedBvhNode {
+    uint16_t child_min_steps[2][3];
+    uint16_t child_max_steps[2][3];
+    uint32_t child_reference[2];
+};
+
+//A node waiting to be visited, as a child of a node on the path from the 
+//root. Its box is decoded from its parent's when it is visited.
+struct CompressedBvhStackEntry {
+    uint32_t parent_index;
+    uint16_t child;
+    uint16_t depth;
+    double entry_distance;
+};
+
+class CompressedBvh: public AccelerationStructure {
+public:
+    CompressedBvh(Scene* scene);
+    virtual ~CompressedBvh();
+    
+    void build();
+    bool refit();
+    
+    Geometry* computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point);
+    bool hasIntersection(Ray* ray);
+    
+    int getGeometryCount();
+    int getNodeCount();
+    long long getMemoryUsage();
+    int getType();
+    
+private:
+    uint32_t compressNode(Bvh* bvh, int bvh_index, std::vector<CompressedBvhNode>* nodes, double box_min[3], double box_max[3]);
+    static void decodeChild(CompressedBvhNode* node, int child, double box_min[3], double box_max[3], double child_min[3], double child_max[3]);
+    static bool intersectBox(double box_min[3], double box_max[3], double origin[3], double inverse_direction[3], double max_distance, double &entry_distance);
+    
+    Scene* scene_;
+    std::vector<Geometry*> geometry_;
+    std::vector<unsigned char> node_storage_;
+    CompressedBvhNode* nodes_;
+    int node_count_;
+    uint32_t root_reference_;
+    double root_min_[3];
+    double root_max_[3];
+};
+
+#endif /* COMPRESSED_BVH_H */
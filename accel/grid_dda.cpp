@@ -0,0 +1,136 @@
+// Ray Tracer: grid_dda.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Grid DDA steps a ray through the cells of a uniform grid 
+//                  in the order the ray crosses them (the 3D Digital 
+//                  Differential Analyzer of Amanatides and Woo). Each step 
+//                  moves into the neighboring cell across the nearest cell 
+//                  wall, so no cell is skipped or visited twice.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "grid_dda.h"
+
+/**
+ * Starts stepping a ray through a grid at the given distance along the ray,
+ * which must be inside the grid (see UniformGrid::clipRay)
+ * 
+ * @param grid_min Minimum corner of the grid
+ * @param cell_size Size of a cell along each axis
+ * @param resolution Number of cells along each axis
+ * @param origin Origin of the ray
+ * @param direction Normalized direction of the ray
+ * @param start_distance Distance along the ray to start at
+ * @param end_distance Distance along the ray to stop at
+ */
+GridDda::GridDda(double grid_min[3], double cell_size[3], int resolution[3], double origin[3], double direction[3], double start_distance, double end_distance){
+    this->cell_entry_ = start_distance;
+    this->end_distance_ = end_distance;
+    this->done_ = start_distance > end_distance;
+    
+    for (int axis = 0; axis < 3; axis++) {
+        this->resolution_[axis] = resolution[axis];
+        
+        double position = origin[axis] + direction[axis] * start_distance;
+        int cell = (int)floor((position - grid_min[axis]) / cell_size[axis]);
+        this->cell_[axis] = std::max(0, std::min(resolution[axis] - 1, cell));
+        
+        if(direction[axis] > 0){
+            this->step_[axis] = 1;
+            this->next_crossing_[axis] = (grid_min[axis] + (this->cell_[axis] + 1) * cell_size[axis] - origin[axis]) / direction[axis];
+            this->crossing_delta_[axis] = cell_size[axis] / direction[axis];
+        } else if(direction[axis] < 0){
+            this->step_[axis] = -1;
+            this->next_crossing_[axis] = (grid_min[axis] + this->cell_[axis] * cell_size[axis] - origin[axis]) / direction[axis];
+            this->crossing_delta_[axis] = -cell_size[axis] / direction[axis];
+        } else {
+            this->step_[axis] = 0;
+            this->next_crossing_[axis] = INFINITY;
+            this->crossing_delta_[axis] = INFINITY;
+        }
+    }
+}
+
+/**
+ * Checks whether the ray has left the grid or passed its end distance
+ * 
+ * @return Flag indicating whether stepping is done
+ */
+bool GridDda::isDone(){
+    return this->done_;
+}
+
+/**
+ * Gets the index of the current cell, counting along X, then Y, then Z
+ * 
+ * @return Index of the current cell
+ */
+int GridDda::getCellIndex(){
+    return (this->cell_[2] * this->resolution_[1] + this->cell_[1]) * this->resolution_[0] + this->cell_[0];
+}
+
+/**
+ * Gets the coordinates of the current cell
+ * 
+ * @param cell Resulting coordinates of the current cell along each axis
+ */
+void GridDda::getCell(int cell[3]){
+    for (int axis = 0; axis < 3; axis++) {
+        cell[axis] = this->cell_[axis];
+    }
+}
+
+/**
+ * Gets the distance along the ray at which it enters the current cell
+ * 
+ * @return Distance at which the ray enters the current cell
+ */
+double GridDda::getCellEntry(){
+    return this->cell_entry_;
+}
+
+/**
+ * Gets the distance along the ray at which it leaves the current cell 
+ * (or reaches its end distance, if sooner)
+ * 
+ * @return Distance at which the ray leaves the current cell
+ */
+double GridDda::getCellExit(){
+    double exit_distance = std::min(this->next_crossing_[0], std::min(this->next_crossing_[1], this->next_crossing_[2]));
+    return std::min(exit_distance, this->end_distance_);
+}
+
+/**
+ * Steps into the next cell crossed by the ray
+ */
+void GridDda::advance(){
+    int axis = 0;
+    if(this->next_crossing_[1] < this->next_crossing_[axis]){
+        axis = 1;
+    }
+    if(this->next_crossing_[2] < this->next_crossing_[axis]){
+        axis = 2;
+    }
+    
+    this->cell_entry_ = this->next_crossing_[axis];
+    this->cell_[axis] += this->step_[axis];
+    this->next_crossing_[axis] += this->crossing_delta_[axis];
+    if(this->cell_[axis] < 0 || this->cell_[axis] >= this->resolution_[axis] || this->cell_entry_ > this->end_distance_){
+        this->done_ = true;
+    }
+}
@@ -0,0 +1,55 @@
+// Ray Tracer: grid_dda.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Grid DDA steps a ray through the cells of a uniform grid 
+//                  in the order the ray crosses them (the 3D Digital 
+//                  Differential Analyzer of Amanatides and Woo). Each step 
+//                  moves into the neighboring cell across the nearest cell 
+//                  wall, so no cell is skipped or visited twice.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef GRID_DDA_H
+#define GRID_DDA_H
+
+#include <algorithm>
+#include <cmath>
+
+class GridDda {
+public:
+    GridDda(double grid_min[3], double cell_size[3], int resolution[3], double origin[3], double direction[3], double start_distance, double end_distance);
+    
+    bool isDone();
+    int getCellIndex();
+    void getCell(int cell[3]);
+    double getCellEntry();
+    double getCellExit();
+    void advance();
+    
+private:
+    int resolution_[3];
+    int cell_[3];
+    int step_[3];
+    double next_crossing_[3];
+    double crossing_delta_[3];
+    double cell_entry_;
+    double end_distance_;
+    bool done_;
+};
+
+#endif /* GRID_DDA_H */
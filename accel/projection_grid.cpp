@@ -0,0 +1,147 @@
+// Ray Tracer: projection_grid.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Projection Grid speeds up the primary rays of an orthographic
+//                 camera. Because every orthographic ray travels in the same
+//                 direction, each geometry covers a fixed rectangle of pixels.
+//                 The image is divided into square bins of pixels and each bin
+//                 lists only the geometry whose projected bounds overlap it, so
+//                 a primary ray is tested against the few candidates of its bin.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "projection_grid.h"
+
+/**
+ * Projects the bounds of every geometry in the scene onto the image plane of
+ * the scene's orthographic camera and sorts the geometry into bins of pixels.
+ * The bins are stored contiguously, with bin_start_ holding the offset of 
+ * each bin's list of geometry.
+ *
+ * @param scene Scene containing the geometry and the orthographic camera
+ * @param bin_size Width and height of a bin in pixels
+ */
+ProjectionGrid::ProjectionGrid(Scene* scene, int bin_size){
+    this->camera_ = scene->getCamera();
+    this->bin_size_ = bin_size;
+    this->bin_count_x_ = (scene->getWidthResolution() + bin_size - 1) / bin_size;
+    this->bin_count_y_ = (scene->getHeightResolution() + bin_size - 1) / bin_size;
+
+    int bin_total = this->bin_count_x_ * this->bin_count_y_;
+    std::vector<int> first_bin(scene->getGeoListSize() * 4, 0);
+    std::vector<int> bin_counts(bin_total, 0);
+
+    //1. Find the range of bins covered by the projected bounds of each geometry
+    for (int i = 0; i < scene->getGeoListSize(); i++) {
+        BoundingBox bounds = scene->getGeoAt(i)->getBounds();
+        double min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+        for (int corner = 0; corner < 8; corner++) {
+            Point3D corner_point = bounds.getCorner(corner);
+            double x, y;
+            this->camera_->projectOrthographic(&corner_point, x, y);
+            min_x = std::min(min_x, x);
+            min_y = std::min(min_y, y);
+            max_x = std::max(max_x, x);
+            max_y = std::max(max_y, y);
+        }
+
+        //Rays are cast between -0.5 and resolution - 0.5 pixels, so geometry beyond can be dropped
+        if(max_x < -1 || max_y < -1 || min_x > scene->getWidthResolution() || min_y > scene->getHeightResolution()){
+            first_bin[i * 4] = 0;
+            first_bin[i * 4 + 1] = -1;
+            continue;
+        }
+
+        //Rays outside of the grid are looked up in the nearest bin, so the range is clamped the same way
+        first_bin[i * 4] = std::min(this->bin_count_x_ - 1, std::max(0, (int) floor(min_x / bin_size)));
+        first_bin[i * 4 + 1] = std::min(this->bin_count_x_ - 1, std::max(0, (int) floor(max_x / bin_size)));
+        first_bin[i * 4 + 2] = std::min(this->bin_count_y_ - 1, std::max(0, (int) floor(min_y / bin_size)));
+        first_bin[i * 4 + 3] = std::min(this->bin_count_y_ - 1, std::max(0, (int) floor(max_y / bin_size)));
+
+        for (int bin_y = first_bin[i * 4 + 2]; bin_y <= first_bin[i * 4 + 3]; bin_y++) {
+            for (int bin_x = first_bin[i * 4]; bin_x <= first_bin[i * 4 + 1]; bin_x++) {
+                bin_counts[bin_y * this->bin_count_x_ + bin_x]++;
+            }
+        }
+    }
+
+    //2. Lay the bins out one after another
+    this->bin_start_.assign(bin_total + 1, 0);
+    for (int bin = 0; bin < bin_total; bin++) {
+        this->bin_start_[bin + 1] = this->bin_start_[bin] + bin_counts[bin];
+    }
+
+    //3. Fill each bin with its geometry
+    this->bin_geometry_.assign(this->bin_start_[bin_total], NULL);
+    std::vector<int> fill_position(this->bin_start_.begin(), this->bin_start_.end() - 1);
+    for (int i = 0; i < scene->getGeoListSize(); i++) {
+        for (int bin_y = first_bin[i * 4 + 2]; bin_y <= first_bin[i * 4 + 3]; bin_y++) {
+            for (int bin_x = first_bin[i * 4]; bin_x <= first_bin[i * 4 + 1]; bin_x++) {
+                int bin = bin_y * this->bin_count_x_ + bin_x;
+                this->bin_geometry_[fill_position[bin]++] = scene->getGeoAt(i);
+            }
+        }
+    }
+}
+
+ProjectionGrid::~ProjectionGrid(){}
+
+/**
+ * Computes the geometry closest to the camera that an orthographic primary ray
+ * has collided with, testing only the geometry in the bin the ray passes through.
+ * Also computes the point in 3D space that was collided with and the normal at that point.
+ *
+ * @param ray Orthographic primary ray to compute intersections with
+ * @param nearest_point Point in 3D space that was collided with
+ * @param normal_at_nearest_point Normal at the point collided with
+ * @return Pointer to the Geometry object intersected
+ */
+Geometry* ProjectionGrid::computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point){
+    double x, y;
+    this->camera_->projectOrthographic(ray->getOrigin(), x, y);
+    int bin_x = std::min(this->bin_count_x_ - 1, std::max(0, (int) floor(x / this->bin_size_)));
+    int bin_y = std::min(this->bin_count_y_ - 1, std::max(0, (int) floor(y / this->bin_size_)));
+    int bin = bin_y * this->bin_count_x_ + bin_x;
+
+    Geometry* nearest_geometry = NULL;
+    float nearest_intersection_distance = INFINITY;
+
+    Point3D point_hit (0,0,0);
+    Vector3D normal_hit (1,1,1);
+
+    for (int i = this->bin_start_[bin]; i < this->bin_start_[bin + 1]; i++) {
+        Geometry* geometry_hit = this->bin_geometry_[i]->computeNearestIntersection(ray, &point_hit, &normal_hit);
+        if (geometry_hit != NULL) {
+            float distance = ray->getOrigin()->computeDistance(&point_hit);
+            if (distance < nearest_intersection_distance) {
+                nearest_geometry = geometry_hit;
+                nearest_intersection_distance = distance;
+
+                nearest_point->setX(point_hit.getX());
+                nearest_point->setY(point_hit.getY());
+                nearest_point->setZ(point_hit.getZ());
+
+                normal_at_nearest_point->setX(normal_hit.getX());
+                normal_at_nearest_point->setY(normal_hit.getY());
+                normal_at_nearest_point->setZ(normal_hit.getZ());
+            }
+        }
+    }
+
+    return nearest_geometry;
+}
@@ -0,0 +1,60 @@
+// Ray Tracer: projection_grid.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Projection Grid speeds up the primary rays of an orthographic
+//                 camera. Because every orthographic ray travels in the same
+//                 direction, each geometry covers a fixed rectangle of pixels.
+//                 The image is divided into square bins of pixels and each bin
+//                 lists only the geometry whose projected bounds overlap it, so
+//                 a primary ray is tested against the few candidates of its bin.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef PROJECTION_GRID_H
+#define PROJECTION_GRID_H
+
+#include <cmath>
+#include <vector>
+
+#include "../camera.h"
+#include "../ray.h"
+#include "../scene.h"
+
+#include "../geo/geometry.h"
+
+#include "../math/bounding_box.h"
+#include "../math/point3d.h"
+#include "../math/vector3d.h"
+
+class ProjectionGrid {
+public:
+    ProjectionGrid(Scene* scene, int bin_size);
+    virtual ~ProjectionGrid();
+
+    Geometry* computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point);
+
+private:
+    Camera* camera_;
+    int bin_size_;
+    int bin_count_x_;
+    int bin_count_y_;
+    std::vector<int> bin_start_;
+    std::vector<Geometry*> bin_geometry_;
+};
+
+#endif /* PROJECTION_GRID_H */
@@ -0,0 +1,280 @@
+// Ray Tracer: two_level_grid.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Two-Level Grid is a coarse grid whose crowded cells hold 
+//                  a finer Uniform Grid of their own. It keeps the fast 
+//                  build and traversal of a grid on scenes where geometry
+//                  gathers in clusters, which leave most cells of a single 
+//                  grid empty and a few of them overfull.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "two_level_grid.h"
+
+#include "../scene.h"
+
+/**
+ * Builds the grid over the geometry of the scene. The grid does not take 
+ * ownership of the geometry.
+ *
+ * @param scene Scene containing the geometry
+ */
+TwoLevelGrid::TwoLevelGrid(Scene* scene){
+    this->scene_ = scene;
+    build();
+}
+
+TwoLevelGrid::~TwoLevelGrid(){
+    clearSubgrids();
+}
+
+/**
+ * Builds the grid from scratch over the geometry currently in the scene.
+ * 
+ * 1. The top level has about one cell for every few pieces of geometry
+ * 2. Each top cell listing more than TWO_LEVEL_GRID_SUBGRID_THRESHOLD pieces
+ *       of geometry gets a Uniform Grid covering the cell, sized for the 
+ *       geometry it lists, unless that geometry is too large for the cell 
+ *       to be split into smaller cells
+ */
+void TwoLevelGrid::build(){
+    clearSubgrids();
+    this->geometry_.resize(this->scene_->getGeoListSize());
+    for (int i = 0; i < this->scene_->getGeoListSize(); i++) {
+        this->geometry_[i] = this->scene_->getGeoAt(i);
+    }
+    
+    UniformGrid::computeGridShape(this->scene_->getBounds(), this->geometry_.size(), TWO_LEVEL_GRID_TOP_DENSITY, UniformGrid::computeMeanExtent(&this->geometry_), this->grid_min_, this->grid_max_, this->cell_size_, this->resolution_);
+    UniformGrid::fillCells(&this->geometry_, this->grid_min_, this->cell_size_, this->resolution_, &this->cell_start_, &this->cell_geometry_);
+    
+    this->subgrids_.assign(getCellCount(), NULL);
+    for (int z = 0; z < this->resolution_[2]; z++) {
+        for (int y = 0; y < this->resolution_[1]; y++) {
+            for (int x = 0; x < this->resolution_[0]; x++) {
+                int cell = (z * this->resolution_[1] + y) * this->resolution_[0] + x;
+                if(this->cell_start_[cell + 1] - this->cell_start_[cell] <= TWO_LEVEL_GRID_SUBGRID_THRESHOLD){
+                    continue;
+                }
+                
+                std::vector<Geometry*> cell_geometry;
+                for (int i = this->cell_start_[cell]; i < this->cell_start_[cell + 1]; i++) {
+                    cell_geometry.push_back(this->geometry_[this->cell_geometry_[i]]);
+                }
+                double min_cell_size = std::min(this->cell_size_[0], std::min(this->cell_size_[1], this->cell_size_[2]));
+                if(2 * UniformGrid::computeMeanExtent(&cell_geometry) > min_cell_size){
+                    continue;
+                }
+                BoundingBox cell_bounds (Point3D(this->grid_min_[0] + x * this->cell_size_[0], this->grid_min_[1] + y * this->cell_size_[1], this->grid_min_[2] + z * this->cell_size_[2]),
+                                         Point3D(this->grid_min_[0] + (x + 1) * this->cell_size_[0], this->grid_min_[1] + (y + 1) * this->cell_size_[1], this->grid_min_[2] + (z + 1) * this->cell_size_[2]));
+                this->subgrids_[cell] = new UniformGrid(cell_geometry, cell_bounds, DEFAULT_GRID_DENSITY);
+            }
+        }
+    }
+}
+
+/**
+ * Updates the grid after geometry moved. A grid is cheap to build, so it is
+ * rebuilt.
+ *
+ * @return Flag indicating whether the grid was rebuilt (always true)
+ */
+bool TwoLevelGrid::refit(){
+    build();
+    return true;
+}
+
+/**
+ * Finds the geometry nearest to the origin of the ray that the ray intersects.
+ * Cells with a finer grid pass the part of the ray inside the cell on to it.
+ * All geometry tested, in either level, shares one mailbox.
+ *
+ * @param ray Ray to compute intersections with
+ * @param nearest_point Resulting point of the nearest intersection
+ * @param normal_at_nearest_point Resulting normal at the nearest intersection
+ * @return Geometry nearest to the origin of the ray (NULL if none is hit)
+ */
+Geometry* TwoLevelGrid::computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point){
+    double origin[3] = {ray->getOrigin()->getX(), ray->getOrigin()->getY(), ray->getOrigin()->getZ()};
+    double direction[3] = {ray->getDirection()->getX(), ray->getDirection()->getY(), ray->getDirection()->getZ()};
+    double start_distance = 0;
+    double end_distance = ray->getMaxDistance();
+    if(this->geometry_.empty() || !UniformGrid::clipToBox(this->grid_min_, this->grid_max_, origin, direction, start_distance, end_distance)){
+        return NULL;
+    }
+    
+    GridMailbox mailbox;
+    UniformGrid::clearMailbox(&mailbox);
+    Geometry* nearest_geometry = NULL;
+    float nearest_distance = INFINITY;
+    
+    Point3D point_hit (0,0,0);
+    Vector3D normal_hit (1,1,1);
+    
+    GridDda dda(this->grid_min_, this->cell_size_, this->resolution_, origin, direction, start_distance, end_distance);
+    while(!dda.isDone()){
+        int cell = dda.getCellIndex();
+        UniformGrid* subgrid = this->subgrids_[cell];
+        if(subgrid != NULL){
+            Geometry* geometry_hit = subgrid->traverseNearest(ray, origin, direction, dda.getCellEntry(), dda.getCellExit(), &mailbox, nearest_distance, nearest_point, normal_at_nearest_point);
+            if(geometry_hit != NULL){
+                nearest_geometry = geometry_hit;
+            }
+        } else {
+            for (int i = this->cell_start_[cell]; i < this->cell_start_[cell + 1]; i++) {
+                Geometry* geometry = this->geometry_[this->cell_geometry_[i]];
+                if(UniformGrid::checkMailbox(&mailbox, geometry)){
+                    continue;
+                }
+                Geometry* geometry_hit = geometry->computeNearestIntersection(ray, &point_hit, &normal_hit);
+                if (geometry_hit != NULL) {
+                    float distance = ray->getOrigin()->computeDistance(&point_hit);
+                    if (distance < nearest_distance) {
+                        nearest_geometry = geometry_hit;
+                        nearest_distance = distance;
+                        *nearest_point = point_hit;
+                        *normal_at_nearest_point = normal_hit;
+                    }
+                }
+            }
+        }
+        if(nearest_distance <= dda.getCellExit()){
+            break;
+        }
+        dda.advance();
+    }
+    
+    return nearest_geometry;
+}
+
+/**
+ * Determines if the ray intersects any geometry within its interval. The 
+ * search stops at the first intersection found.
+ *
+ * @param ray Ray to compute intersections with
+ * @return Result of the check
+ */
+bool TwoLevelGrid::hasIntersection(Ray* ray){
+    double origin[3] = {ray->getOrigin()->getX(), ray->getOrigin()->getY(), ray->getOrigin()->getZ()};
+    double direction[3] = {ray->getDirection()->getX(), ray->getDirection()->getY(), ray->getDirection()->getZ()};
+    double start_distance = 0;
+    double end_distance = ray->getMaxDistance();
+    if(this->geometry_.empty() || !UniformGrid::clipToBox(this->grid_min_, this->grid_max_, origin, direction, start_distance, end_distance)){
+        return false;
+    }
+    
+    GridMailbox mailbox;
+    UniformGrid::clearMailbox(&mailbox);
+    
+    Point3D point_hit_noop (0,0,0);
+    Vector3D normal_hit_noop (1,1,1);
+    
+    GridDda dda(this->grid_min_, this->cell_size_, this->resolution_, origin, direction, start_distance, end_distance);
+    while(!dda.isDone()){
+        int cell = dda.getCellIndex();
+        UniformGrid* subgrid = this->subgrids_[cell];
+        if(subgrid != NULL){
+            if(subgrid->traverseAny(ray, origin, direction, dda.getCellEntry(), dda.getCellExit(), &mailbox)){
+                return true;
+            }
+        } else {
+            for (int i = this->cell_start_[cell]; i < this->cell_start_[cell + 1]; i++) {
+                Geometry* geometry = this->geometry_[this->cell_geometry_[i]];
+                if(!UniformGrid::checkMailbox(&mailbox, geometry) && geometry->hasIntersection(ray, &point_hit_noop, &normal_hit_noop)){
+                    return true;
+                }
+            }
+        }
+        dda.advance();
+    }
+    
+    return false;
+}
+
+/**
+ * Gets the amount of geometry sorted into the grid
+ *
+ * @return Amount of geometry in the grid
+ */
+int TwoLevelGrid::getGeometryCount(){
+    return this->geometry_.size();
+}
+
+/**
+ * Gets the amount of cells in the top level of the grid
+ *
+ * @return Amount of top-level cells
+ */
+int TwoLevelGrid::getCellCount(){
+    return this->resolution_[0] * this->resolution_[1] * this->resolution_[2];
+}
+
+/**
+ * Gets the amount of top-level cells holding a finer grid
+ *
+ * @return Amount of finer grids
+ */
+int TwoLevelGrid::getSubgridCount(){
+    int subgrid_count = 0;
+    for (unsigned int i = 0; i < this->subgrids_.size(); i++) {
+        if(this->subgrids_[i] != NULL){
+            subgrid_count++;
+        }
+    }
+    return subgrid_count;
+}
+
+/**
+ * Computes the memory held by both levels of the grid
+ *
+ * @return Size of the grid in bytes
+ */
+long long TwoLevelGrid::getMemoryUsage(){
+    long long memory_usage = (long long)(this->cell_start_.capacity() + this->cell_geometry_.capacity()) * sizeof(int) + 
+                             (long long)(this->geometry_.capacity() + this->subgrids_.capacity()) * sizeof(void*);
+    for (unsigned int i = 0; i < this->subgrids_.size(); i++) {
+        if(this->subgrids_[i] != NULL){
+            memory_usage += sizeof(UniformGrid) + this->subgrids_[i]->getMemoryUsage();
+        }
+    }
+    return memory_usage;
+}
+
+/**
+ * Returns the type of Acceleration Structure
+ * 
+ * Acceleration Structure Flag List (10/19/2016)
+ * 
+ * 0: Bounding Volume Hierarchy
+ * 1: Compressed Bounding Volume Hierarchy
+ * 2: 4-wide Bounding Volume Hierarchy
+ * 3: Uniform Grid
+ * 4: Two-Level Grid
+ * 
+ * @return The flag defining the structure as a two-level grid (4)
+ */
+int TwoLevelGrid::getType(){
+    return 4;
+}
+
+//Deletes the finer grids of all cells
+void TwoLevelGrid::clearSubgrids(){
+    for (unsigned int i = 0; i < this->subgrids_.size(); i++) {
+        delete this->subgrids_[i];
+    }
+    this->subgrids_.clear();
+}
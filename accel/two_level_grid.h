@@ -0,0 +1,81 @@
+// Ray Tracer: two_level_grid.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Two-Level Grid is a coarse grid whose crowded cells hold 
+//                  a finer Uniform Grid of their own. It keeps the fast 
+//                  build and traversal of a grid on scenes where geometry
+//                  gathers in clusters, which leave most cells of a single 
+//                  grid empty and a few of them overfull.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef TWO_LEVEL_GRID_H
+#define TWO_LEVEL_GRID_H
+
+#include <cmath>
+#include <vector>
+
+#include "acceleration_structure.h"
+#include "grid_dda.h"
+#include "uniform_grid.h"
+
+#include "../ray.h"
+
+#include "../geo/geometry.h"
+
+#include "../math/bounding_box.h"
+#include "../math/point3d.h"
+#include "../math/vector3d.h"
+
+class Scene;
+
+#define TWO_LEVEL_GRID_TOP_DENSITY 0.125
+#define TWO_LEVEL_GRID_SUBGRID_THRESHOLD 4
+
+class TwoLevelGrid: public AccelerationStructure {
+public:
+    TwoLevelGrid(Scene* scene);
+    virtual ~TwoLevelGrid();
+    
+    void build();
+    bool refit();
+    
+    Geometry* computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point);
+    bool hasIntersection(Ray* ray);
+    
+    int getGeometryCount();
+    int getCellCount();
+    int getSubgridCount();
+    long long getMemoryUsage();
+    int getType();
+    
+private:
+    void clearSubgrids();
+    
+    Scene* scene_;
+    std::vector<Geometry*> geometry_;
+    double grid_min_[3];
+    double grid_max_[3];
+    double cell_size_[3];
+    int resolution_[3];
+    std::vector<int> cell_start_;
+    std::vector<int> cell_geometry_;
+    std::vector<UniformGrid*> subgrids_;
+};
+
+#endif /* TWO_LEVEL_GRID_H */
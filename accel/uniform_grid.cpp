@@ -0,0 +1,471 @@
+// Ray Tracer: uniform_grid.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Uniform Grid splits the box of the scene into cells of 
+//                  equal size and lists the geometry overlapping each cell.
+//                  A ray steps through the cells it crosses, nearest first,
+//                  and stops at the first cell containing a hit. It builds 
+//                  much faster than a tree, and traces as fast when the 
+//                  geometry is small, similar in size, and evenly spread.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "uniform_grid.h"
+
+#include "../scene.h"
+
+//Gets one coordinate of a point by axis (0: X, 1: Y, 2: Z)
+static double getAxis(Point3D point, int axis){
+    switch(axis){
+        case 0: return point.getX();
+        case 1: return point.getY();
+        default: return point.getZ();
+    }
+}
+
+/**
+ * Builds the grid over the geometry of the scene. The grid does not take 
+ * ownership of the geometry.
+ *
+ * @param scene Scene containing the geometry
+ */
+UniformGrid::UniformGrid(Scene* scene){
+    this->scene_ = scene;
+    this->density_ = DEFAULT_GRID_DENSITY;
+    build();
+}
+
+/**
+ * Builds a grid over a fixed list of geometry, covering only the given box 
+ * (used for the cells of a TwoLevelGrid). Geometry outside the box is 
+ * listed in the cells at its edge.
+ *
+ * @param geometry Geometry to sort into the grid
+ * @param bounds Box covered by the grid
+ * @param density Average number of cells per geometry
+ */
+UniformGrid::UniformGrid(std::vector<Geometry*> geometry, BoundingBox bounds, double density){
+    this->scene_ = NULL;
+    this->geometry_ = geometry;
+    this->source_bounds_ = bounds;
+    this->density_ = density;
+    build();
+}
+
+UniformGrid::~UniformGrid(){}
+
+/**
+ * Builds the grid from scratch over the geometry currently in the scene (or 
+ * the fixed list of geometry it was created with)
+ */
+void UniformGrid::build(){
+    BoundingBox bounds = this->source_bounds_;
+    if(this->scene_ != NULL){
+        this->geometry_.resize(this->scene_->getGeoListSize());
+        for (int i = 0; i < this->scene_->getGeoListSize(); i++) {
+            this->geometry_[i] = this->scene_->getGeoAt(i);
+        }
+        bounds = this->scene_->getBounds();
+    }
+    
+    computeGridShape(bounds, this->geometry_.size(), this->density_, computeMeanExtent(&this->geometry_), this->grid_min_, this->grid_max_, this->cell_size_, this->resolution_);
+    fillCells(&this->geometry_, this->grid_min_, this->cell_size_, this->resolution_, &this->cell_start_, &this->cell_geometry_);
+}
+
+/**
+ * Updates the grid after geometry moved. A grid is cheap to build, so it is
+ * rebuilt.
+ *
+ * @return Flag indicating whether the grid was rebuilt (always true)
+ */
+bool UniformGrid::refit(){
+    build();
+    return true;
+}
+
+/**
+ * Finds the geometry nearest to the origin of the ray that the ray intersects
+ *
+ * @param ray Ray to compute intersections with
+ * @param nearest_point Resulting point of the nearest intersection
+ * @param normal_at_nearest_point Resulting normal at the nearest intersection
+ * @return Geometry nearest to the origin of the ray (NULL if none is hit)
+ */
+Geometry* UniformGrid::computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point){
+    double origin[3] = {ray->getOrigin()->getX(), ray->getOrigin()->getY(), ray->getOrigin()->getZ()};
+    double direction[3] = {ray->getDirection()->getX(), ray->getDirection()->getY(), ray->getDirection()->getZ()};
+    double start_distance = 0;
+    double end_distance = ray->getMaxDistance();
+    if(this->geometry_.empty() || !clipRay(origin, direction, start_distance, end_distance)){
+        return NULL;
+    }
+    
+    GridMailbox mailbox;
+    clearMailbox(&mailbox);
+    float nearest_distance = INFINITY;
+    return traverseNearest(ray, origin, direction, start_distance, end_distance, &mailbox, nearest_distance, nearest_point, normal_at_nearest_point);
+}
+
+/**
+ * Determines if the ray intersects any geometry within its interval. The 
+ * search stops at the first intersection found.
+ *
+ * @param ray Ray to compute intersections with
+ * @return Result of the check
+ */
+bool UniformGrid::hasIntersection(Ray* ray){
+    double origin[3] = {ray->getOrigin()->getX(), ray->getOrigin()->getY(), ray->getOrigin()->getZ()};
+    double direction[3] = {ray->getDirection()->getX(), ray->getDirection()->getY(), ray->getDirection()->getZ()};
+    double start_distance = 0;
+    double end_distance = ray->getMaxDistance();
+    if(this->geometry_.empty() || !clipRay(origin, direction, start_distance, end_distance)){
+        return false;
+    }
+    
+    GridMailbox mailbox;
+    clearMailbox(&mailbox);
+    return traverseAny(ray, origin, direction, start_distance, end_distance, &mailbox);
+}
+
+/**
+ * Steps the ray through the cells it crosses between two distances, testing
+ * the geometry of each cell. Geometry overlapping several cells may be hit 
+ * beyond the current cell, so the walk only stops once the nearest hit found
+ * lies before the ray leaves the current cell.
+ *
+ * @param ray Ray to compute intersections with
+ * @param origin Origin of the ray
+ * @param direction Normalized direction of the ray
+ * @param start_distance Distance along the ray to start at (inside the grid)
+ * @param end_distance Distance along the ray to stop at
+ * @param mailbox Geometry already tested by the ray
+ * @param nearest_distance Distance to the nearest hit found so far, updated with any nearer hit
+ * @param nearest_point Resulting point of the nearest intersection, if nearer
+ * @param normal_at_nearest_point Resulting normal at the nearest intersection, if nearer
+ * @return Geometry hit nearer than the given nearest distance (NULL if none)
+ */
+Geometry* UniformGrid::traverseNearest(Ray* ray, double origin[3], double direction[3], double start_distance, double end_distance, GridMailbox* mailbox, float &nearest_distance, Point3D* nearest_point, Vector3D* normal_at_nearest_point){
+    Geometry* nearest_geometry = NULL;
+    
+    Point3D point_hit (0,0,0);
+    Vector3D normal_hit (1,1,1);
+    
+    GridDda dda(this->grid_min_, this->cell_size_, this->resolution_, origin, direction, start_distance, end_distance);
+    while(!dda.isDone()){
+        int cell = dda.getCellIndex();
+        for (int i = this->cell_start_[cell]; i < this->cell_start_[cell + 1]; i++) {
+            Geometry* geometry = this->geometry_[this->cell_geometry_[i]];
+            if(checkMailbox(mailbox, geometry)){
+                continue;
+            }
+            Geometry* geometry_hit = geometry->computeNearestIntersection(ray, &point_hit, &normal_hit);
+            if (geometry_hit != NULL) {
+                float distance = ray->getOrigin()->computeDistance(&point_hit);
+                if (distance < nearest_distance) {
+                    nearest_geometry = geometry_hit;
+                    nearest_distance = distance;
+                    *nearest_point = point_hit;
+                    *normal_at_nearest_point = normal_hit;
+                }
+            }
+        }
+        if(nearest_distance <= dda.getCellExit()){
+            break;
+        }
+        dda.advance();
+    }
+    
+    return nearest_geometry;
+}
+
+/**
+ * Steps the ray through the cells it crosses between two distances, until 
+ * any geometry is hit
+ *
+ * @param ray Ray to compute intersections with
+ * @param origin Origin of the ray
+ * @param direction Normalized direction of the ray
+ * @param start_distance Distance along the ray to start at (inside the grid)
+ * @param end_distance Distance along the ray to stop at
+ * @param mailbox Geometry already tested by the ray
+ * @return Flag indicating whether any geometry was hit
+ */
+bool UniformGrid::traverseAny(Ray* ray, double origin[3], double direction[3], double start_distance, double end_distance, GridMailbox* mailbox){
+    Point3D point_hit_noop (0,0,0);
+    Vector3D normal_hit_noop (1,1,1);
+    
+    GridDda dda(this->grid_min_, this->cell_size_, this->resolution_, origin, direction, start_distance, end_distance);
+    while(!dda.isDone()){
+        int cell = dda.getCellIndex();
+        for (int i = this->cell_start_[cell]; i < this->cell_start_[cell + 1]; i++) {
+            Geometry* geometry = this->geometry_[this->cell_geometry_[i]];
+            if(!checkMailbox(mailbox, geometry) && geometry->hasIntersection(ray, &point_hit_noop, &normal_hit_noop)){
+                return true;
+            }
+        }
+        dda.advance();
+    }
+    
+    return false;
+}
+
+/**
+ * Limits an interval along a ray to the part inside the grid
+ *
+ * @param origin Origin of the ray
+ * @param direction Normalized direction of the ray
+ * @param start_distance Start of the interval, raised to where the ray enters the grid
+ * @param end_distance End of the interval, lowered to where the ray leaves the grid
+ * @return Flag indicating whether any of the interval is inside the grid
+ */
+bool UniformGrid::clipRay(double origin[3], double direction[3], double &start_distance, double &end_distance){
+    return clipToBox(this->grid_min_, this->grid_max_, origin, direction, start_distance, end_distance);
+}
+
+/**
+ * Gets the amount of geometry sorted into the grid
+ *
+ * @return Amount of geometry in the grid
+ */
+int UniformGrid::getGeometryCount(){
+    return this->geometry_.size();
+}
+
+/**
+ * Gets the amount of cells in the grid
+ *
+ * @return Amount of cells in the grid
+ */
+int UniformGrid::getCellCount(){
+    return this->resolution_[0] * this->resolution_[1] * this->resolution_[2];
+}
+
+/**
+ * Computes the memory held by the cells and geometry list of the grid
+ *
+ * @return Size of the grid in bytes
+ */
+long long UniformGrid::getMemoryUsage(){
+    return (long long)(this->cell_start_.capacity() + this->cell_geometry_.capacity()) * sizeof(int) + 
+           (long long)this->geometry_.capacity() * sizeof(Geometry*);
+}
+
+/**
+ * Returns the type of Acceleration Structure
+ * 
+ * Acceleration Structure Flag List (10/19/2016)
+ * 
+ * 0: Bounding Volume Hierarchy
+ * 1: Compressed Bounding Volume Hierarchy
+ * 2: 4-wide Bounding Volume Hierarchy
+ * 3: Uniform Grid
+ * 4: Two-Level Grid
+ * 
+ * @return The flag defining the structure as a uniform grid (3)
+ */
+int UniformGrid::getType(){
+    return 3;
+}
+
+/**
+ * Computes the mean size of the geometry, each piece measured along the 
+ * longest side of its bounding box
+ *
+ * @param geometry Geometry to measure
+ * @return Mean size of the geometry (0 if there is none)
+ */
+double UniformGrid::computeMeanExtent(std::vector<Geometry*>* geometry){
+    if(geometry->empty()){
+        return 0;
+    }
+    double extent_sum = 0;
+    for (unsigned int i = 0; i < geometry->size(); i++) {
+        BoundingBox bounds = (*geometry)[i]->getBounds();
+        double extent = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            extent = std::max(extent, getAxis(bounds.getMax(), axis) - getAxis(bounds.getMin(), axis));
+        }
+        extent_sum += extent;
+    }
+    return extent_sum / geometry->size();
+}
+
+/**
+ * Chooses the cells of a grid over a box. The cells are as close to cubes as
+ * possible, with about the given number of cells per geometry. Cells are no
+ * smaller than the given size, so geometry larger than the cells the density
+ * asks for does not get listed in a number of cells growing with the amount 
+ * of geometry. Flat boxes are padded so every cell has a size.
+ *
+ * @param bounds Box to cover
+ * @param count Amount of geometry in the grid
+ * @param density Average number of cells per geometry
+ * @param min_cell_size Smallest size of a cell, usually the mean size of the geometry (0 for no limit)
+ * @param grid_min Resulting minimum corner of the grid
+ * @param grid_max Resulting maximum corner of the grid
+ * @param cell_size Resulting size of a cell along each axis
+ * @param resolution Resulting number of cells along each axis
+ */
+void UniformGrid::computeGridShape(BoundingBox bounds, int count, double density, double min_cell_size, double grid_min[3], double grid_max[3], double cell_size[3], int resolution[3]){
+    double extent[3];
+    double max_extent = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        grid_min[axis] = bounds.isEmpty() ? 0 : getAxis(bounds.getMin(), axis);
+        grid_max[axis] = bounds.isEmpty() ? 0 : getAxis(bounds.getMax(), axis);
+        max_extent = std::max(max_extent, grid_max[axis] - grid_min[axis]);
+    }
+    
+    double padding = std::max(max_extent * GRID_EPSILON, GRID_EPSILON);
+    double volume = 1;
+    for (int axis = 0; axis < 3; axis++) {
+        if(grid_max[axis] - grid_min[axis] < 2 * padding){
+            grid_min[axis] -= padding;
+            grid_max[axis] += padding;
+        }
+        extent[axis] = grid_max[axis] - grid_min[axis];
+        volume *= extent[axis];
+    }
+    
+    double cells_per_length = cbrt(density * std::max(count, 1) / volume);
+    if(min_cell_size > 0){
+        cells_per_length = std::min(cells_per_length, 1 / min_cell_size);
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        resolution[axis] = std::max(1, std::min(GRID_MAX_RESOLUTION, (int)floor(extent[axis] * cells_per_length + 0.5)));
+        cell_size[axis] = extent[axis] / resolution[axis];
+    }
+}
+
+/**
+ * Lists the geometry overlapping each cell of a grid. The lists of all cells
+ * are stored one after another, with the start of each list kept separately.
+ * Boxes are grown slightly, so geometry touching a cell wall is listed on 
+ * both sides.
+ *
+ * @param geometry Geometry to sort into the cells
+ * @param grid_min Minimum corner of the grid
+ * @param cell_size Size of a cell along each axis
+ * @param resolution Number of cells along each axis
+ * @param cell_start Resulting start of the list of each cell, followed by the end of the last list
+ * @param cell_geometry Resulting lists of the indices of the geometry overlapping each cell
+ */
+void UniformGrid::fillCells(std::vector<Geometry*>* geometry, double grid_min[3], double cell_size[3], int resolution[3], std::vector<int>* cell_start, std::vector<int>* cell_geometry){
+    int cell_count = resolution[0] * resolution[1] * resolution[2];
+    std::vector<int> geometry_cells(6 * geometry->size());
+    for (unsigned int i = 0; i < geometry->size(); i++) {
+        BoundingBox bounds = (*geometry)[i]->getBounds();
+        for (int axis = 0; axis < 3; axis++) {
+            double padding = cell_size[axis] * GRID_EPSILON;
+            int first_cell = (int)floor((getAxis(bounds.getMin(), axis) - padding - grid_min[axis]) / cell_size[axis]);
+            int last_cell = (int)floor((getAxis(bounds.getMax(), axis) + padding - grid_min[axis]) / cell_size[axis]);
+            geometry_cells[6 * i + axis] = std::max(0, std::min(resolution[axis] - 1, first_cell));
+            geometry_cells[6 * i + axis + 3] = std::max(0, std::min(resolution[axis] - 1, last_cell));
+        }
+    }
+    
+    //Count the geometry of each cell, then place each list after the previous one
+    cell_start->assign(cell_count + 1, 0);
+    for (unsigned int i = 0; i < geometry->size(); i++) {
+        int* cells = &geometry_cells[6 * i];
+        for (int z = cells[2]; z <= cells[5]; z++) {
+            for (int y = cells[1]; y <= cells[4]; y++) {
+                for (int x = cells[0]; x <= cells[3]; x++) {
+                    (*cell_start)[(z * resolution[1] + y) * resolution[0] + x + 1]++;
+                }
+            }
+        }
+    }
+    for (int cell = 0; cell < cell_count; cell++) {
+        (*cell_start)[cell + 1] += (*cell_start)[cell];
+    }
+    
+    cell_geometry->assign((*cell_start)[cell_count], 0);
+    std::vector<int> cell_fill(cell_start->begin(), cell_start->end() - 1);
+    for (unsigned int i = 0; i < geometry->size(); i++) {
+        int* cells = &geometry_cells[6 * i];
+        for (int z = cells[2]; z <= cells[5]; z++) {
+            for (int y = cells[1]; y <= cells[4]; y++) {
+                for (int x = cells[0]; x <= cells[3]; x++) {
+                    (*cell_geometry)[cell_fill[(z * resolution[1] + y) * resolution[0] + x]++] = i;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Empties a mailbox before a new ray is traced
+ *
+ * @param mailbox Mailbox to empty
+ */
+void UniformGrid::clearMailbox(GridMailbox* mailbox){
+    for (int i = 0; i < GRID_MAILBOX_SIZE; i++) {
+        mailbox->entries[i] = NULL;
+    }
+}
+
+/**
+ * Checks whether geometry was already tested by the ray, and records it as 
+ * tested otherwise
+ *
+ * @param mailbox Geometry already tested by the ray
+ * @param geometry Geometry about to be tested
+ * @return Flag indicating whether the geometry was already tested
+ */
+bool UniformGrid::checkMailbox(GridMailbox* mailbox, Geometry* geometry){
+    int slot = (int)(((uintptr_t)geometry / sizeof(void*)) & (GRID_MAILBOX_SIZE - 1));
+    if(mailbox->entries[slot] == geometry){
+        return true;
+    }
+    mailbox->entries[slot] = geometry;
+    return false;
+}
+
+/**
+ * Limits an interval along a ray to the part inside a box
+ *
+ * @param box_min Minimum corner of the box
+ * @param box_max Maximum corner of the box
+ * @param origin Origin of the ray
+ * @param direction Normalized direction of the ray
+ * @param start_distance Start of the interval, raised to where the ray enters the box
+ * @param end_distance End of the interval, lowered to where the ray leaves the box
+ * @return Flag indicating whether any of the interval is inside the box
+ */
+bool UniformGrid::clipToBox(double box_min[3], double box_max[3], double origin[3], double direction[3], double &start_distance, double &end_distance){
+    for (int axis = 0; axis < 3; axis++) {
+        if(direction[axis] == 0){
+            if(origin[axis] < box_min[axis] || origin[axis] > box_max[axis]){
+                return false;
+            }
+            continue;
+        }
+        double inverse_direction = 1.0 / direction[axis];
+        double near_plane = (box_min[axis] - origin[axis]) * inverse_direction;
+        double far_plane = (box_max[axis] - origin[axis]) * inverse_direction;
+        if(near_plane > far_plane){
+            std::swap(near_plane, far_plane);
+        }
+        start_distance = std::max(start_distance, near_plane);
+        end_distance = std::min(end_distance, far_plane);
+        if(start_distance > end_distance){
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,103 @@
+// Ray Tracer: uniform_grid.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Uniform Grid splits the box of the scene into cells of 
+//                  equal size and lists the geometry overlapping each cell.
+//                  A ray steps through the cells it crosses, nearest first,
+//                  and stops at the first cell containing a hit. It builds 
+//                  much faster than a tree, and traces as fast when the 
+//                  geometry is small, similar in size, and evenly spread.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef UNIFORM_GRID_H
+#define UNIFORM_GRID_H
+
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+
+#include "acceleration_structure.h"
+#include "grid_dda.h"
+
+#include "../ray.h"
+
+#include "../geo/geometry.h"
+
+#include "../math/bounding_box.h"
+#include "../math/point3d.h"
+#include "../math/vector3d.h"
+
+class Scene;
+
+#define DEFAULT_GRID_DENSITY 4.0
+#define GRID_MAX_RESOLUTION 512
+#define GRID_MAILBOX_SIZE 64
+#define GRID_EPSILON 1e-9
+
+//Geometry recently tested by one ray, so geometry overlapping several cells
+//is only tested once. Entries are found by hashing the address of the 
+//geometry, and a newer entry replaces an older one in the same slot. The 
+//mailbox belongs to the ray rather than the grid, so several threads can
+//trace through the same grid.
+struct GridMailbox {
+    Geometry* entries[GRID_MAILBOX_SIZE];
+};
+
+class UniformGrid: public AccelerationStructure {
+public:
+    UniformGrid(Scene* scene);
+    UniformGrid(std::vector<Geometry*> geometry, BoundingBox bounds, double density);
+    virtual ~UniformGrid();
+    
+    void build();
+    bool refit();
+    
+    Geometry* computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point);
+    bool hasIntersection(Ray* ray);
+    Geometry* traverseNearest(Ray* ray, double origin[3], double direction[3], double start_distance, double end_distance, GridMailbox* mailbox, float &nearest_distance, Point3D* nearest_point, Vector3D* normal_at_nearest_point);
+    bool traverseAny(Ray* ray, double origin[3], double direction[3], double start_distance, double end_distance, GridMailbox* mailbox);
+    bool clipRay(double origin[3], double direction[3], double &start_distance, double &end_distance);
+    
+    int getGeometryCount();
+    int getCellCount();
+    long long getMemoryUsage();
+    int getType();
+    
+    static double computeMeanExtent(std::vector<Geometry*>* geometry);
+    static void computeGridShape(BoundingBox bounds, int count, double density, double min_cell_size, double grid_min[3], double grid_max[3], double cell_size[3], int resolution[3]);
+    static void fillCells(std::vector<Geometry*>* geometry, double grid_min[3], double cell_size[3], int resolution[3], std::vector<int>* cell_start, std::vector<int>* cell_geometry);
+    static void clearMailbox(GridMailbox* mailbox);
+    static bool checkMailbox(GridMailbox* mailbox, Geometry* geometry);
+    static bool clipToBox(double box_min[3], double box_max[3], double origin[3], double direction[3], double &start_distance, double &end_distance);
+    
+private:
+    Scene* scene_;
+    BoundingBox source_bounds_;
+    double density_;
+    std::vector<Geometry*> geometry_;
+    double grid_min_[3];
+    double grid_max_[3];
+    double cell_size_[3];
+    int resolution_[3];
+    std::vector<int> cell_start_;
+    std::vector<int> cell_geometry_;
+};
+
+#endif /* UNIFORM_GRID_H */
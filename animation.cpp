@@ -0,0 +1,163 @@
+// Ray Tracer: animation.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: An Animation moves the camera and the spheres of a scene over
+//                  a sequence of frames. Positions are given at key frames 
+//                  and linearly interpolated between them. Before the first
+//                  key and after the last, the nearest key is held.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "animation.h"
+
+Animation::Animation(){}
+
+Animation::~Animation(){}
+
+/**
+ * Adds a key frame for the camera. A key at the same frame as an existing 
+ * key replaces it.
+ * 
+ * @param frame Frame of the key
+ * @param origin Position of the camera at the frame
+ * @param look_at Point the camera is aimed at at the frame
+ */
+void Animation::addCameraKey(int frame, Point3D origin, Point3D look_at){
+    CameraKey key;
+    key.frame = frame;
+    key.origin = origin;
+    key.look_at = look_at;
+    
+    unsigned int i = 0;
+    while(i < this->camera_keys_.size() && this->camera_keys_[i].frame < frame){
+        i++;
+    }
+    if(i < this->camera_keys_.size() && this->camera_keys_[i].frame == frame){
+        this->camera_keys_[i] = key;
+    } else {
+        this->camera_keys_.insert(this->camera_keys_.begin() + i, key);
+    }
+}
+
+/**
+ * Adds a key frame for the center of a sphere. A key at the same frame as an
+ * existing key of the sphere replaces it. The sphere must stay in the scene
+ * for as long as the animation is used.
+ * 
+ * @param sphere Sphere to move
+ * @param frame Frame of the key
+ * @param center Center of the sphere at the frame
+ */
+void Animation::addCenterKey(Sphere* sphere, int frame, Point3D center){
+    unsigned int track = 0;
+    while(track < this->sphere_tracks_.size() && this->sphere_tracks_[track].sphere != sphere){
+        track++;
+    }
+    if(track == this->sphere_tracks_.size()){
+        SphereTrack new_track;
+        new_track.sphere = sphere;
+        this->sphere_tracks_.push_back(new_track);
+    }
+    
+    CenterKey key;
+    key.frame = frame;
+    key.center = center;
+    
+    std::vector<CenterKey>* keys = &this->sphere_tracks_[track].keys;
+    unsigned int i = 0;
+    while(i < keys->size() && (*keys)[i].frame < frame){
+        i++;
+    }
+    if(i < keys->size() && (*keys)[i].frame == frame){
+        (*keys)[i] = key;
+    } else {
+        keys->insert(keys->begin() + i, key);
+    }
+}
+
+/**
+ * Moves the camera and spheres of the scene to where they are at the given 
+ * frame. Spheres that are already in place are left untouched, so they are 
+ * not marked as edited.
+ * 
+ * @param scene Scene to update
+ * @param frame Frame to move to
+ */
+void Animation::applyFrame(Scene* scene, int frame){
+    if(!this->camera_keys_.empty()){
+        unsigned int next = 0;
+        while(next < this->camera_keys_.size() && this->camera_keys_[next].frame <= frame){
+            next++;
+        }
+        Point3D origin, look_at;
+        if(next == 0){
+            origin = this->camera_keys_[0].origin;
+            look_at = this->camera_keys_[0].look_at;
+        } else if(next == this->camera_keys_.size()){
+            origin = this->camera_keys_[next - 1].origin;
+            look_at = this->camera_keys_[next - 1].look_at;
+        } else {
+            CameraKey* previous_key = &this->camera_keys_[next - 1];
+            CameraKey* next_key = &this->camera_keys_[next];
+            double t = (double)(frame - previous_key->frame) / (next_key->frame - previous_key->frame);
+            origin = interpolate(previous_key->origin, next_key->origin, t);
+            look_at = interpolate(previous_key->look_at, next_key->look_at, t);
+        }
+        scene->getCamera()->setOrigin(new Point3D(origin.getX(), origin.getY(), origin.getZ()));
+        scene->getCamera()->setLookAt(new Point3D(look_at.getX(), look_at.getY(), look_at.getZ()));
+    }
+    
+    for (unsigned int track = 0; track < this->sphere_tracks_.size(); track++) {
+        std::vector<CenterKey>* keys = &this->sphere_tracks_[track].keys;
+        unsigned int next = 0;
+        while(next < keys->size() && (*keys)[next].frame <= frame){
+            next++;
+        }
+        Point3D center;
+        if(next == 0){
+            center = (*keys)[0].center;
+        } else if(next == keys->size()){
+            center = (*keys)[next - 1].center;
+        } else {
+            CenterKey* previous_key = &(*keys)[next - 1];
+            CenterKey* next_key = &(*keys)[next];
+            double t = (double)(frame - previous_key->frame) / (next_key->frame - previous_key->frame);
+            center = interpolate(previous_key->center, next_key->center, t);
+        }
+        
+        Sphere* sphere = this->sphere_tracks_[track].sphere;
+        Point3D* current_center = sphere->getCenter();
+        if(current_center->getX() != center.getX() || current_center->getY() != center.getY() || current_center->getZ() != center.getZ()){
+            sphere->setCenter(new Point3D(center.getX(), center.getY(), center.getZ()));
+        }
+    }
+}
+
+/**
+ * Linearly interpolates between two points
+ * 
+ * @param start Point at t = 0
+ * @param end Point at t = 1
+ * @param t Position between the points
+ * @return Interpolated point
+ */
+Point3D Animation::interpolate(Point3D start, Point3D end, double t){
+    return Point3D(start.getX() + (end.getX() - start.getX()) * t,
+                   start.getY() + (end.getY() - start.getY()) * t,
+                   start.getZ() + (end.getZ() - start.getZ()) * t);
+}
@@ -0,0 +1,71 @@
+// Ray Tracer: animation.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: An Animation moves the camera and the spheres of a scene over
+//                  a sequence of frames. Positions are given at key frames 
+//                  and linearly interpolated between them. Before the first
+//                  key and after the last, the nearest key is held.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <vector>
+
+#include "scene.h"
+#include "camera.h"
+
+#include "geo/sphere.h"
+
+#include "math/point3d.h"
+
+struct CameraKey {
+    int frame;
+    Point3D origin;
+    Point3D look_at;
+};
+
+struct CenterKey {
+    int frame;
+    Point3D center;
+};
+
+//Key frames of the center of one sphere, in order of frame
+struct SphereTrack {
+    Sphere* sphere;
+    std::vector<CenterKey> keys;
+};
+
+class Animation {
+public:
+    Animation();
+    virtual ~Animation();
+    
+    void addCameraKey(int frame, Point3D origin, Point3D look_at);
+    void addCenterKey(Sphere* sphere, int frame, Point3D center);
+    void applyFrame(Scene* scene, int frame);
+    
+private:
+    static Point3D interpolate(Point3D start, Point3D end, double t);
+    
+    std::vector<CameraKey> camera_keys_;
+    std::vector<SphereTrack> sphere_tracks_;
+};
+
+#endif /* ANIMATION_H */
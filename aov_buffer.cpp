@@ -0,0 +1,139 @@
+// Ray Tracer: aov_buffer.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: An AOV Buffer keeps arbitrary output variables of every pixel
+//                  next to its color: the depth, normal and object id of 
+//                  the surface hit by the first primary ray, for 
+//                  compositing. Each channel enabled is stored as its own
+//                  planar buffer of floats, row by row.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "aov_buffer.h"
+
+AovBuffer::AovBuffer(int width, int height){
+    this->width_ = width;
+    this->height_ = height;
+}
+
+AovBuffer::~AovBuffer(){
+}
+
+/**
+ * Gets the width of the buffer
+ * 
+ * @return Width in pixels
+ */
+int AovBuffer::getWidth(){
+    return this->width_;
+}
+
+/**
+ * Gets the height of the buffer
+ * 
+ * @return Height in pixels
+ */
+int AovBuffer::getHeight(){
+    return this->height_;
+}
+
+/**
+ * Allocates the buffer of a channel, filled as if every ray missed
+ * 
+ * @param channel Flag of the channel (see the Output Channel List)
+ */
+void AovBuffer::enableChannel(int channel){
+    if(hasChannel(channel)){
+        return;
+    }
+    float empty_value = channel == 0 ? INFINITY : 0.0f;
+    this->channels_[channel].assign((size_t)this->width_ * this->height_ * getComponentCount(channel), empty_value);
+}
+
+/**
+ * Checks whether the buffer of a channel is allocated
+ * 
+ * @param channel Flag of the channel
+ * @return Boolean indicating whether the channel is kept
+ */
+bool AovBuffer::hasChannel(int channel){
+    return !this->channels_[channel].empty();
+}
+
+/**
+ * Gets the planar buffer of a channel, with the components of each pixel in
+ * turn, row by row
+ * 
+ * @param channel Flag of the channel
+ * @return Buffer of the channel (NULL if the channel is not kept)
+ */
+float* AovBuffer::getChannel(int channel){
+    return hasChannel(channel) ? &this->channels_[channel][0] : NULL;
+}
+
+/**
+ * Stores the output variables of a pixel in every channel kept
+ * 
+ * @param x X-coordinate of the pixel
+ * @param y Y-coordinate of the pixel
+ * @param sample Output variables of the pixel
+ */
+void AovBuffer::setSample(int x, int y, AovSample* sample){
+    size_t pixel = (size_t)y * this->width_ + x;
+    if(!this->channels_[0].empty()){
+        this->channels_[0][pixel] = sample->depth;
+    }
+    if(!this->channels_[1].empty()){
+        float* normal = &this->channels_[1][3 * pixel];
+        normal[0] = sample->normal[0];
+        normal[1] = sample->normal[1];
+        normal[2] = sample->normal[2];
+    }
+    if(!this->channels_[2].empty()){
+        this->channels_[2][pixel] = sample->object_id;
+    }
+}
+
+/**
+ * Gets the amount of floats stored for each pixel of a channel
+ * 
+ * @param channel Flag of the channel
+ * @return Amount of components of the channel (1 or 3)
+ */
+int AovBuffer::getComponentCount(int channel){
+    return channel == 1 ? 3 : 1;
+}
+
+/**
+ * Gets the name of a channel, as used in the names of the files it is 
+ * written to
+ * 
+ * @param channel Flag of the channel
+ * @return Name of the channel
+ */
+std::string AovBuffer::getChannelName(int channel){
+    switch(channel){
+        case 0:
+            return "depth";
+        case 1:
+            return "normal";
+        case 2:
+            return "object_id";
+    }
+    return "";
+}
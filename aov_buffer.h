@@ -0,0 +1,68 @@
+// Ray Tracer: aov_buffer.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: An AOV Buffer keeps arbitrary output variables of every pixel
+//                  next to its color: the depth, normal and object id of 
+//                  the surface hit by the first primary ray, for 
+//                  compositing. Each channel enabled is stored as its own
+//                  planar buffer of floats, row by row.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef AOV_BUFFER_H
+#define AOV_BUFFER_H
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+//Output Channel List (10/19/2016)
+//0: Depth (distance along the primary ray, infinite where it missed)
+//1: Normal (x, y and z of the surface normal, 0 where the ray missed)
+//2: Object Id (object id of the geometry hit, 0 where the ray missed)
+#define AOV_CHANNEL_COUNT 3
+
+//Output variables of the surface hit by the first primary ray of a pixel
+struct AovSample {
+    float depth;
+    float normal[3];
+    float object_id;
+};
+
+class AovBuffer {
+public:
+    AovBuffer(int width, int height);
+    virtual ~AovBuffer();
+    
+    int getWidth();
+    int getHeight();
+    void enableChannel(int channel);
+    bool hasChannel(int channel);
+    float* getChannel(int channel);
+    void setSample(int x, int y, AovSample* sample);
+    
+    static int getComponentCount(int channel);
+    static std::string getChannelName(int channel);
+    
+private:
+    int width_;
+    int height_;
+    std::vector<float> channels_[AOV_CHANNEL_COUNT];
+};
+
+#endif /* AOV_BUFFER_H */
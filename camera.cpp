@@ -3,7 +3,9 @@
 // Author: Wesley Hauwiller
 //
 // Description: The camera defines the parameters for projecting the 
-//                3D scene onto an image plane
+//                3D scene onto an image plane. The projection is precomputed
+//                as an orthonormal basis and per-pixel step vectors whenever
+//                a parameter changes, so generating a ray needs no trigonometry.
 //
 // Copyright (C) 2016  whauwiller.blogspot.com
 //
@@ -26,12 +28,16 @@
 Camera::Camera() {
     this->type_ = 0;
     this->origin_ = new Point3D(0,0,0);
+    this->look_at_ = new Point3D(0,0,-1);
+    this->up_ = new Vector3D(0,1,0);
     this->image_width_ = 512;
     this->image_height_ = 512;
     this->field_of_view_ = 22.5 * (M_PI/180);
     this->distance_to_image_plane_ = 1;
     this->near_clip_plane_ = 0.1;
     this->far_clip_plane_ = 10000;
+    this->aperture_radius_ = 0;
+    computeProjection();
 }
 
 Camera::Camera(const Camera& orig) {
@@ -40,10 +46,14 @@ Camera::Camera(const Camera& orig) {
 
 Camera::~Camera() {
     delete this->origin_;
+    delete this->look_at_;
+    delete this->up_;
 }
 
 /**
- * Sets a flag determining the type of camera
+ * Sets a flag determining the type of camera. An orthographic camera casts
+ * parallel rays along the viewing direction from a plane through the origin,
+ * covering the same area as the perspective image plane.
  * 
  * Current Available Flags (2/2/2016)
  * 0: Perspective
@@ -61,7 +71,38 @@ void Camera::setType(int type){
  * @param origin Pointer to the point the camera is positioned at
  */
 void Camera::setOrigin(Point3D* origin){
+    if(origin != this->origin_){
+        delete this->origin_;
+    }
     this->origin_ = origin;
+    computeProjection();
+}
+
+/**
+ * Sets the point in 3D space the camera is aimed at
+ * 
+ * @param look_at Pointer to the point the camera is aimed at
+ */
+void Camera::setLookAt(Point3D* look_at){
+    if(look_at != this->look_at_){
+        delete this->look_at_;
+    }
+    this->look_at_ = look_at;
+    computeProjection();
+}
+
+/**
+ * Sets the direction that is considered up for the camera. The vector does
+ * not need to be perpendicular to the viewing direction, only not parallel to it.
+ * 
+ * @param up Pointer to the up direction of the camera
+ */
+void Camera::setUpVector(Vector3D* up){
+    if(up != this->up_){
+        delete this->up_;
+    }
+    this->up_ = up;
+    computeProjection();
 }
 
 /**
@@ -73,6 +114,7 @@ void Camera::setOrigin(Point3D* origin){
 void Camera::setResolution(int image_width, int image_height){
     this->image_width_ = image_width;
     this->image_height_ = image_height;
+    computeProjection();
 }
 
 /**
@@ -91,21 +133,25 @@ void Camera::setFocalParams(double field_of_view, bool radians){
     } else {
         this->field_of_view_ = field_of_view;
     }
+    computeProjection();
 }
 
 /**
  * Sets the distance between the origin of the camera and the point 
- * where the camera will be focused for generating the image
+ * where the camera will be focused for generating the image. With an 
+ * aperture, geometry on the image plane is in perfect focus.
  * 
  * @param distance Distance between the origin and image plane
  */
 void Camera::setDistToImagePlane(double distance){
     this->distance_to_image_plane_ = distance;
+    computeProjection();
 }
 
 /**
  * Sets the plane positions in defining the front and back of 
- * the camera frustum for culling geometry
+ * the camera frustum for culling geometry. Both are measured as
+ * distances from the camera along the viewing direction.
  * 
  * @param near_plane Geometry in front of this position will be culled
  * @param far_plane Geometry behind this position will be culled
@@ -115,6 +161,27 @@ void Camera::setClipPlanes(float near_plane, float far_plane){
     this->far_clip_plane_ = far_plane;
 }
 
+/**
+ * Gets the flag determining the type of camera
+ * 
+ * @return Flag determining the type of camera (0: Perspective, 1: Orthographic)
+ */
+int Camera::getType(){
+    return this->type_;
+}
+
+/**
+ * Sets the radius of the camera lens (thin lens model). Rays leave from random
+ * points on the lens and converge on the image plane, so geometry away from the 
+ * image plane is blurred. A radius of zero gives a pinhole camera with every 
+ * point in focus. The aperture is ignored by an orthographic camera.
+ * 
+ * @param aperture_radius Radius of the lens in scene units
+ */
+void Camera::setApertureRadius(double aperture_radius){
+    this->aperture_radius_ = aperture_radius;
+}
+
 /**
  * Gets the camera position in 3D space
  * 
@@ -124,6 +191,24 @@ Point3D* Camera::getOrigin(){
     return this->origin_;
 }
 
+/**
+ * Gets the point in 3D space the camera is aimed at
+ * 
+ * @return Pointer to the point the camera is aimed at
+ */
+Point3D* Camera::getLookAt(){
+    return this->look_at_;
+}
+
+/**
+ * Gets the direction that is considered up for the camera
+ * 
+ * @return Pointer to the up direction of the camera
+ */
+Vector3D* Camera::getUpVector(){
+    return this->up_;
+}
+
 /**
  * Gets the width resolution of the resulting image 
  * 
@@ -159,4 +244,194 @@ double Camera::getDistToImagePlane(){
  */
 double Camera::getFieldOfView(){
     return this->field_of_view_;
-}
\ No newline at end of file
+}
+
+/**
+ * Gets the distance from the camera to the near clip plane
+ * 
+ * @return Distance to the near clip plane
+ */
+float Camera::getNearClipPlane(){
+    return this->near_clip_plane_;
+}
+
+/**
+ * Gets the distance from the camera to the far clip plane
+ * 
+ * @return Distance to the far clip plane
+ */
+float Camera::getFarClipPlane(){
+    return this->far_clip_plane_;
+}
+
+/**
+ * Gets the radius of the camera lens
+ * 
+ * @return Radius of the lens in scene units
+ */
+double Camera::getApertureRadius(){
+    return this->aperture_radius_;
+}
+
+/**
+ * Determines whether rays need to be spread over a lens, which is only the
+ * case for a perspective camera with a non-zero aperture
+ * 
+ * @return Result of the check
+ */
+bool Camera::hasAperture(){
+    return this->type_ == 0 && this->aperture_radius_ > 0;
+}
+
+/**
+ * Generates the ray cast from the center of the lens through the given position 
+ * on the image plane
+ * 
+ * @param x X-coordinate on the image plane in pixels
+ * @param y Y-coordinate on the image plane in pixels
+ * @return Resulting ray
+ */
+Ray* Camera::generateRay(double x, double y){
+    return generateRay(x, y, 0.5, 0.5);
+}
+
+/**
+ * Generates the ray cast from the camera through the given position on the
+ * image plane. Pixel coordinates are measured from the top-left corner of 
+ * the image, with the center of a pixel at its integer coordinate.
+ * The lens coordinates pick the point on the lens the ray leaves from.
+ * The ray is limited to the segment between the clip planes.
+ * 
+ * @param x X-coordinate on the image plane in pixels
+ * @param y Y-coordinate on the image plane in pixels
+ * @param lens_u First coordinate of the sample on the lens (0-1)
+ * @param lens_v Second coordinate of the sample on the lens (0-1)
+ * @return Resulting ray
+ */
+Ray* Camera::generateRay(double x, double y, double lens_u, double lens_v){
+    if(this->type_ == 1){
+        Point3D* ray_origin = new Point3D(this->origin_->getX() + this->orthographic_first_pixel_offset_.getX() + this->column_step_.getX() * x + this->row_step_.getX() * y,
+                                          this->origin_->getY() + this->orthographic_first_pixel_offset_.getY() + this->column_step_.getY() * x + this->row_step_.getY() * y,
+                                          this->origin_->getZ() + this->orthographic_first_pixel_offset_.getZ() + this->column_step_.getZ() * x + this->row_step_.getZ() * y);
+        Ray* ray = new Ray(ray_origin, new Vector3D(-this->basis_w_.getX(), -this->basis_w_.getY(), -this->basis_w_.getZ()));
+        ray->setInterval(this->near_clip_plane_, this->far_clip_plane_);
+        return ray;
+    }
+    
+    double direction_x = this->first_pixel_offset_.getX() + this->column_step_.getX() * x + this->row_step_.getX() * y;
+    double direction_y = this->first_pixel_offset_.getY() + this->column_step_.getY() * x + this->row_step_.getY() * y;
+    double direction_z = this->first_pixel_offset_.getZ() + this->column_step_.getZ() * x + this->row_step_.getZ() * y;
+    
+    Point3D* ray_origin = new Point3D(this->origin_->getX(), this->origin_->getY(), this->origin_->getZ());
+    
+    //Thin lens: move the origin onto the lens and aim at the same point on the image plane
+    if(this->type_ == 0 && this->aperture_radius_ > 0){
+        double disk_x, disk_y;
+        Sampler::mapToDisk(lens_u, lens_v, disk_x, disk_y);
+        double lens_x = disk_x * this->aperture_radius_;
+        double lens_y = disk_y * this->aperture_radius_;
+        
+        double offset_x = this->basis_u_.getX() * lens_x + this->basis_v_.getX() * lens_y;
+        double offset_y = this->basis_u_.getY() * lens_x + this->basis_v_.getY() * lens_y;
+        double offset_z = this->basis_u_.getZ() * lens_x + this->basis_v_.getZ() * lens_y;
+        
+        ray_origin->setX(ray_origin->getX() + offset_x);
+        ray_origin->setY(ray_origin->getY() + offset_y);
+        ray_origin->setZ(ray_origin->getZ() + offset_z);
+        direction_x -= offset_x;
+        direction_y -= offset_y;
+        direction_z -= offset_z;
+    }
+    
+    Vector3D* direction = new Vector3D(direction_x, direction_y, direction_z);
+    direction->normalize();
+    
+    //The clip planes are perpendicular to the viewing direction, so the distance
+    //along the ray grows as the ray moves away from the center of the image
+    double cos_to_view_axis = -direction->dot(&this->basis_w_);
+    
+    Ray* ray = new Ray(ray_origin, direction);
+    ray->setInterval(this->near_clip_plane_ / cos_to_view_axis, this->far_clip_plane_ / cos_to_view_axis);
+    return ray;
+}
+
+/**
+ * Precomputes the projection of the image plane. Builds an orthonormal basis 
+ * (u: right, v: up, w: backwards) from the origin, look-at point and up vector,
+ * then the offset from the origin to the center of the top-left pixel and the 
+ * steps between neighboring columns and rows of pixels on the image plane.
+ */
+void Camera::computeProjection(){
+    this->basis_w_ = this->look_at_->computeDirection(this->origin_, false);
+    if(this->basis_w_.magnitude() == 0){
+        //No viewing direction can be derived, so look down the negative Z-axis
+        this->basis_w_ = Vector3D(0,0,1);
+    }
+    this->basis_w_.normalize();
+    
+    this->basis_u_ = this->up_->crossProd(&this->basis_w_);
+    if(this->basis_u_.magnitude() == 0){
+        //Up vector is parallel to the viewing direction, so pick any perpendicular vector
+        Vector3D fallback_up = std::abs(this->basis_w_.getY()) < 0.9 ? Vector3D(0,1,0) : Vector3D(1,0,0);
+        this->basis_u_ = fallback_up.crossProd(&this->basis_w_);
+    }
+    this->basis_u_.normalize();
+    this->basis_v_ = this->basis_w_.crossProd(&this->basis_u_);
+    
+    double aspect_ratio = (double) this->image_width_ / this->image_height_;
+    double half_height = tan(this->field_of_view_) * this->distance_to_image_plane_;
+    double half_width = half_height * aspect_ratio;
+    
+    this->column_step_ = this->basis_u_ * (2 * half_width / this->image_width_);
+    this->row_step_ = this->basis_v_ * (-2 * half_height / this->image_height_);
+    
+    Vector3D image_plane_center = this->basis_w_ * -this->distance_to_image_plane_;
+    Vector3D top_left_corner = image_plane_center - (this->basis_u_ * half_width) + (this->basis_v_ * half_height);
+    this->first_pixel_offset_ = top_left_corner + (this->column_step_ * 0.5) + (this->row_step_ * 0.5);
+    this->orthographic_first_pixel_offset_ = this->first_pixel_offset_ - image_plane_center;
+}
+
+/**
+ * Finds the pixel coordinates of the orthographic ray passing through the given
+ * point. This is the inverse of the ray origin computed by generateRay for an 
+ * orthographic camera, so it can be used to find which pixels a point covers.
+ * 
+ * @param point Point in 3D space to project
+ * @param x X-coordinate of the point on the image plane in pixels
+ * @param y Y-coordinate of the point on the image plane in pixels
+ */
+void Camera::projectOrthographic(Point3D* point, double &x, double &y){
+    Vector3D offset(point->getX() - this->origin_->getX() - this->orthographic_first_pixel_offset_.getX(),
+                    point->getY() - this->origin_->getY() - this->orthographic_first_pixel_offset_.getY(),
+                    point->getZ() - this->origin_->getZ() - this->orthographic_first_pixel_offset_.getZ());
+    x = offset.dot(&this->column_step_) / this->column_step_.dot(&this->column_step_);
+    y = offset.dot(&this->row_step_) / this->row_step_.dot(&this->row_step_);
+}
+
+/**
+ * Finds the pixel coordinates of the primary ray (through the center of the 
+ * lens) passing through the given point. Points level with or behind the 
+ * camera cannot be projected by a perspective camera.
+ * 
+ * @param point Point in 3D space to project
+ * @param x X-coordinate of the point on the image plane in pixels
+ * @param y Y-coordinate of the point on the image plane in pixels
+ * @return Flag indicating whether the point could be projected
+ */
+bool Camera::projectPoint(Point3D* point, double &x, double &y){
+    if(this->type_ == 1){
+        projectOrthographic(point, x, y);
+        return true;
+    }
+    
+    Vector3D direction = this->origin_->computeDirection(point, false);
+    double depth = -direction.dot(&this->basis_w_);
+    if(depth <= 0){
+        return false;
+    }
+    
+    Vector3D offset = (direction * (this->distance_to_image_plane_ / depth)) - this->first_pixel_offset_;
+    x = offset.dot(&this->column_step_) / this->column_step_.dot(&this->column_step_);
+    y = offset.dot(&this->row_step_) / this->row_step_.dot(&this->row_step_);
+    return true;
+}
@@ -3,7 +3,9 @@
 // Author: Wesley Hauwiller
 //
 // Description: The camera defines the parameters for projecting the 
-//                3D scene onto an image plane
+//                3D scene onto an image plane. The projection is precomputed
+//                as an orthonormal basis and per-pixel step vectors whenever
+//                a parameter changes, so generating a ray needs no trigonometry.
 //
 // Copyright (C) 2016  whauwiller.blogspot.com
 //
@@ -26,7 +28,11 @@
 
 #include <cmath>
 
+#include "ray.h"
+
 #include "math/point3d.h"
+#include "math/sampler.h"
+#include "math/vector3d.h"
 
 class Camera {
 public:
@@ -36,25 +42,54 @@ public:
     
     void setType(int type);
     void setOrigin(Point3D* origin);
+    void setLookAt(Point3D* look_at);
+    void setUpVector(Vector3D* up);
     void setResolution(int image_width, int image_height);
     void setDistToImagePlane(double distance);
     void setFocalParams(double field_of_view, bool radians);
     void setClipPlanes(float near_plane, float far_plane);
+    void setApertureRadius(double aperture_radius);
     
+    int getType();
     Point3D* getOrigin();
+    Point3D* getLookAt();
+    Vector3D* getUpVector();
     int getWidthResolution();
     int getHeightResolution();
     double getDistToImagePlane();
     double getFieldOfView();
+    float getNearClipPlane();
+    float getFarClipPlane();
+    double getApertureRadius();
+    bool hasAperture();
+    
+    Ray* generateRay(double x, double y);
+    Ray* generateRay(double x, double y, double lens_u, double lens_v);
+    void projectOrthographic(Point3D* point, double &x, double &y);
+    bool projectPoint(Point3D* point, double &x, double &y);
 private:
+    void computeProjection();
+    
     int type_;
     Point3D* origin_;
+    Point3D* look_at_;
+    Vector3D* up_;
     int image_width_;
     int image_height_;
     double field_of_view_;
     double distance_to_image_plane_;
     float near_clip_plane_;
     float far_clip_plane_;
+    double aperture_radius_;
+    
+    //Precomputed projection
+    Vector3D basis_u_;
+    Vector3D basis_v_;
+    Vector3D basis_w_;
+    Vector3D first_pixel_offset_;
+    Vector3D orthographic_first_pixel_offset_;
+    Vector3D column_step_;
+    Vector3D row_step_;
 };
 
 #endif /* CAMERA_H */
@@ -0,0 +1,128 @@
+// Ray Tracer: binary_ppm_writer.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Binary PPM Writer generates a binary Portable Pixel Map 
+//                  file (.ppm) straight from a frame buffer, with 8-bit
+//                  samples, or 16-bit samples (most significant byte first)
+//                  when the maximum color value is above 255. The layout is
+//                  described with the Mapped PPM Writer.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "binary_ppm_writer.h"
+
+BinaryPpmWriter::BinaryPpmWriter(){
+    this->filename_ = "PPM_File.ppm";
+    this->max_color_ = 255;
+}
+
+BinaryPpmWriter::BinaryPpmWriter(std::string filename){
+    this->filename_ = filename;
+    this->max_color_ = 255;
+}
+
+BinaryPpmWriter::~BinaryPpmWriter(){}
+
+/**
+ * Create the PPM file with the filename assigned in the constructor (or 
+ * setFilename), replacing any earlier file
+ */
+void BinaryPpmWriter::init(){
+    std::ofstream output_file;
+    output_file.open(this->filename_.c_str(), std::ios_base::binary);
+    output_file.close();
+}
+
+/**
+ * Set the headers identifying the file as a binary PPM file, with the image 
+ * width, image height, and maximum color value. Maximum color value must be 
+ * less than 65536 and more than zero; above 255, samples take two bytes.
+ * 
+ * @param image_width Image width in pixels
+ * @param image_height Image height in pixels
+ * @param max_color Maximum color value (1-65535)
+ */
+void BinaryPpmWriter::defineHeaders(int image_width, int image_height, int max_color){
+    
+    //Keep the maximum color within bounds
+    if(max_color <= 0 || max_color >= 65536){
+        throw std::invalid_argument("Maximum color value must be less than 65536 and more than zero.");
+    }
+    this->max_color_ = max_color;
+    
+    std::ofstream output_file;
+    output_file.open(this->filename_.c_str(), std::ios_base::app | std::ios_base::binary);
+    output_file << "P6" << '\n'; //A binary PPM image's magic number is "P6"
+    output_file << image_width << " " << image_height << '\n';
+    output_file << max_color << '\n'; //A single whitespace character before the binary samples
+    output_file.close();
+}
+
+/**
+ * Text cannot be placed in a binary image: pixels are added with 
+ * addFrameBuffer.
+ * 
+ * @param content Text that would be added to the file
+ */
+void BinaryPpmWriter::addContent(std::string content){
+    throw std::logic_error("Pixels of a binary PPM file are added with addFrameBuffer.");
+}
+
+/**
+ * Implementation of the close function. 
+ * PPM does not have specifications for footers, so this function is a No-Op
+ */
+void BinaryPpmWriter::close(){
+    return;
+}
+
+/**
+ * Returns the type of File Writer
+ * 
+ * File Writer Flag List (10/19/2016)
+ * 
+ * 0: ASCII PPM Writer
+ * 1: Mapped Binary PPM Writer
+ * 2: PFM Writer
+ * 3: Binary PPM Writer
+ * 4: Stream Writer
+ * 
+ * @return The flag defining the writer as a binary PPM writer (3)
+ */
+int BinaryPpmWriter::getType(){
+    return 3;
+}
+
+/**
+ * Adds every pixel of a frame buffer to the file, converted a row at a time
+ * 
+ * @param frame_buffer Frame buffer matching the headers of the file
+ */
+void BinaryPpmWriter::addFrameBuffer(FrameBuffer* frame_buffer){
+    int width = frame_buffer->getWidth();
+    int sample_size = this->max_color_ < 256 ? 1 : 2;
+    std::vector<unsigned char> row(3 * width * sample_size);
+    
+    std::ofstream output_file;
+    output_file.open(this->filename_.c_str(), std::ios_base::app | std::ios_base::binary);
+    for (int y = 0; y < frame_buffer->getHeight(); y++) {
+        SampleQuantizer::quantize(frame_buffer->getRow(y), 3 * width, this->max_color_, &row[0]);
+        output_file.write((char*)&row[0], row.size());
+    }
+    output_file.close();
+}
@@ -0,0 +1,56 @@
+// Ray Tracer: binary_ppm_writer.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Binary PPM Writer generates a binary Portable Pixel Map 
+//                  file (.ppm) straight from a frame buffer, with 8-bit
+//                  samples, or 16-bit samples (most significant byte first)
+//                  when the maximum color value is above 255. The layout is
+//                  described with the Mapped PPM Writer.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef BINARY_PPM_WRITER_H
+#define	BINARY_PPM_WRITER_H
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "file_writer.h"
+#include "sample_quantizer.h"
+
+#include "../frame_buffer.h"
+
+class BinaryPpmWriter: public FileWriter{
+public:
+    BinaryPpmWriter();
+    BinaryPpmWriter(std::string filename);
+    virtual ~BinaryPpmWriter();
+    void init();
+    void defineHeaders(int image_width, int image_height, int max_color);
+    void addContent(std::string content);
+    void close();
+    int getType();
+    
+    void addFrameBuffer(FrameBuffer* frame_buffer);
+private:
+    int max_color_;
+};
+
+#endif	/* BINARY_PPM_WRITER_H */
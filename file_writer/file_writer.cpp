@@ -3,8 +3,9 @@
 // Author: Wesley Hauwiller
 //
 // Description: A File Writer provides a template for all possible file output
-//                  formats. Contains a method to initialize the file, add 
-//                  content to the file, and to close the file.
+//                  formats. Contains a method to initialize the file, define
+//                  its headers, add content to the file, and to close the 
+//                  file.
 //
 // Copyright (C) 2016  whauwiller.blogspot.com
 //
@@ -25,3 +26,22 @@
 #include "file_writer.h"
 
 FileWriter::~FileWriter(){}
+
+/**
+ * Sets the name of the file to write. Takes effect at the next init, so one 
+ * writer can write a sequence of files.
+ * 
+ * @param filename Name of the file to write
+ */
+void FileWriter::setFilename(std::string filename){
+    this->filename_ = filename;
+}
+
+/**
+ * Gets the name of the file being written
+ * 
+ * @return Name of the file being written
+ */
+std::string FileWriter::getFilename(){
+    return this->filename_;
+}
@@ -3,8 +3,9 @@
 // Author: Wesley Hauwiller
 //
 // Description: A File Writer provides a template for all possible file output
-//                  formats. Contains a method to initialize the file, add 
-//                  content to the file, and to close the file.
+//                  formats. Contains a method to initialize the file, define
+//                  its headers, add content to the file, and to close the 
+//                  file.
 //
 // Copyright (C) 2016  whauwiller.blogspot.com
 //
@@ -26,13 +27,19 @@
 #define	FILE_WRITER_H
 
 #include <fstream>
+#include <string>
 
 class FileWriter{
 public:
     virtual ~FileWriter();
     virtual void init() =0;
+    virtual void defineHeaders(int image_width, int image_height, int max_color) =0;
     virtual void addContent(std::string content) =0;
     virtual void close() =0;
+    virtual int getType() =0;
+    
+    void setFilename(std::string filename);
+    std::string getFilename();
 protected:
     std::string filename_;
 };
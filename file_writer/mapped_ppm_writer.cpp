@@ -0,0 +1,321 @@
+// Ray Tracer: mapped_ppm_writer.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Mapped PPM Writer generates a binary Portable Pixel Map file
+//                  (.ppm) that is sized in full when its headers are defined
+//                  and mapped into memory. Pixels are written straight into 
+//                  the file by any number of threads, and finished rows are 
+//                  handed back to the operating system, so images far larger
+//                  than memory can be written. In asynchronous mode tiles are
+//                  queued and encoded by a writer thread of their own, so 
+//                  the threads tracing never wait on the file.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "mapped_ppm_writer.h"
+
+MappedPpmWriter::MappedPpmWriter(){
+    this->filename_ = "PPM_File.ppm";
+    this->file_descriptor_ = -1;
+    this->mapping_ = NULL;
+    this->mapping_size_ = 0;
+    this->header_size_ = 0;
+    this->width_ = 0;
+    this->height_ = 0;
+    this->max_color_ = 255;
+    this->sample_size_ = 1;
+    this->asynchronous_ = false;
+    this->write_queue_ = NULL;
+}
+
+MappedPpmWriter::MappedPpmWriter(std::string filename){
+    this->filename_ = filename;
+    this->file_descriptor_ = -1;
+    this->mapping_ = NULL;
+    this->mapping_size_ = 0;
+    this->header_size_ = 0;
+    this->width_ = 0;
+    this->height_ = 0;
+    this->max_color_ = 255;
+    this->sample_size_ = 1;
+    this->asynchronous_ = false;
+    this->write_queue_ = NULL;
+}
+
+MappedPpmWriter::~MappedPpmWriter(){
+    close();
+}
+
+/**
+ * Create the PPM file with the filename assigned in the constructor (or 
+ * setFilename), replacing any earlier file. A file still open from an earlier
+ * init is closed first.
+ */
+void MappedPpmWriter::init(){
+    close();
+    this->file_descriptor_ = open(this->filename_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(this->file_descriptor_ < 0){
+        throw std::runtime_error("Could not create " + this->filename_ + ".");
+    }
+}
+
+/**
+ * Writes the headers of the binary PPM file, grows the file to hold every 
+ * pixel and maps it into memory. Maximum color value must be less than 65536 
+ * and more than zero. Pixels not written stay black. In asynchronous mode the
+ * writer thread is started.
+ * 
+ * @param image_width Image width in pixels
+ * @param image_height Image height in pixels
+ * @param max_color Maximum color value (1-65535)
+ */
+void MappedPpmWriter::defineHeaders(int image_width, int image_height, int max_color){
+    
+    //Keep the maximum color within bounds
+    if(max_color <= 0 || max_color >= 65536){
+        throw std::invalid_argument("Maximum color value must be less than 65536 and more than zero.");
+    }
+    if(this->file_descriptor_ < 0 || this->mapping_ != NULL){
+        throw std::logic_error("Headers must be defined once after init.");
+    }
+    
+    char header[64];
+    this->header_size_ = snprintf(header, sizeof(header), "P6\n%d %d\n%d\n", image_width, image_height, max_color);
+    this->width_ = image_width;
+    this->height_ = image_height;
+    this->max_color_ = max_color;
+    this->sample_size_ = max_color < 256 ? 1 : 2;
+    this->mapping_size_ = this->header_size_ + (size_t)image_width * image_height * 3 * this->sample_size_;
+    
+    if(ftruncate(this->file_descriptor_, this->mapping_size_) != 0){
+        throw std::runtime_error("Could not size " + this->filename_ + ".");
+    }
+    void* mapping = mmap(NULL, this->mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, this->file_descriptor_, 0);
+    if(mapping == MAP_FAILED){
+        throw std::runtime_error("Could not map " + this->filename_ + " into memory.");
+    }
+    this->mapping_ = (unsigned char*)mapping;
+    std::copy(header, header + this->header_size_, this->mapping_);
+    
+    if(this->asynchronous_){
+        this->write_queue_ = new WriteQueue(MAPPED_WRITE_QUEUE_CAPACITY);
+        this->writer_thread_ = std::thread(&MappedPpmWriter::runWriterThread, this);
+    }
+}
+
+/**
+ * Text cannot be placed in a binary image: pixels are written with setPixel
+ * or writeTile.
+ * 
+ * @param content Text that would be added to the file
+ */
+void MappedPpmWriter::addContent(std::string content){
+    throw std::logic_error("Pixels of a mapped PPM file are written with setPixel or writeTile.");
+}
+
+/**
+ * Waits for the writer thread to write every queued tile, then writes every 
+ * pixel still in memory to the file and closes it
+ */
+void MappedPpmWriter::close(){
+    if(this->write_queue_ != NULL){
+        WriteRequest stop_request = {2, 0, 0, 0, 0, NULL};
+        this->write_queue_->push(stop_request);
+        this->writer_thread_.join();
+        delete this->write_queue_;
+        this->write_queue_ = NULL;
+    }
+    if(this->mapping_ != NULL){
+        msync(this->mapping_, this->mapping_size_, MS_SYNC);
+        munmap(this->mapping_, this->mapping_size_);
+        this->mapping_ = NULL;
+    }
+    if(this->file_descriptor_ >= 0){
+        ::close(this->file_descriptor_);
+        this->file_descriptor_ = -1;
+    }
+}
+
+/**
+ * Returns the type of File Writer
+ * 
+ * File Writer Flag List (10/19/2016)
+ * 
+ * 0: ASCII PPM Writer
+ * 1: Mapped Binary PPM Writer
+ * 2: PFM Writer
+ * 3: Binary PPM Writer
+ * 4: Stream Writer
+ * 
+ * @return The flag defining the writer as a mapped binary PPM writer (1)
+ */
+int MappedPpmWriter::getType(){
+    return 1;
+}
+
+/**
+ * Writes the color of one pixel into the file. The color is clamped to the 
+ * range of the file and rounded. Threads may write different pixels at the 
+ * same time. The pixel is written at once, even in asynchronous mode.
+ * 
+ * @param x X-coordinate of the pixel
+ * @param y Y-coordinate of the pixel
+ * @param color Color of the pixel (0 to 255)
+ */
+void MappedPpmWriter::setPixel(int x, int y, RgbColor color){
+    float samples[3] = {(float)color.getRed(), (float)color.getGreen(), (float)color.getBlue()};
+    unsigned char* pixel = this->mapping_ + this->header_size_ + ((size_t)y * this->width_ + x) * 3 * this->sample_size_;
+    SampleQuantizer::quantize(samples, 3, this->max_color_, pixel);
+}
+
+/**
+ * Writes a finished tile of pixels into the file. In asynchronous mode the 
+ * tile is copied and queued for the writer thread, waiting while the queue 
+ * is full.
+ * 
+ * @param first_x X-coordinate of the top-left pixel of the tile
+ * @param first_y Y-coordinate of the top-left pixel of the tile
+ * @param tile_width Width of the tile in pixels
+ * @param tile_height Height of the tile in pixels
+ * @param samples Red, green and blue samples of the pixels of the tile, row by row
+ */
+void MappedPpmWriter::writeTile(int first_x, int first_y, int tile_width, int tile_height, float* samples){
+    if(this->write_queue_ == NULL){
+        encodeTile(first_x, first_y, tile_width, tile_height, samples);
+        return;
+    }
+    
+    float* queued_samples = new float[3 * tile_width * tile_height];
+    std::copy(samples, samples + 3 * tile_width * tile_height, queued_samples);
+    WriteRequest tile_request = {0, first_x, first_y, tile_width, tile_height, queued_samples};
+    this->write_queue_->push(tile_request);
+}
+
+/**
+ * Writes finished rows to the file and drops them from memory. In 
+ * asynchronous mode this is queued behind the tiles already queued, so it 
+ * happens once they are written.
+ * 
+ * @param first_row First finished row
+ * @param row_count Amount of finished rows
+ */
+void MappedPpmWriter::releaseRows(int first_row, int row_count){
+    if(this->write_queue_ == NULL){
+        releaseMappedRows(first_row, row_count);
+        return;
+    }
+    
+    WriteRequest release_request = {1, 0, first_row, 0, row_count, NULL};
+    this->write_queue_->push(release_request);
+}
+
+/**
+ * Gets the width of the image in pixels, as defined by the headers
+ * 
+ * @return Width of the image
+ */
+int MappedPpmWriter::getWidth(){
+    return this->width_;
+}
+
+/**
+ * Gets the height of the image in pixels, as defined by the headers
+ * 
+ * @return Height of the image
+ */
+int MappedPpmWriter::getHeight(){
+    return this->height_;
+}
+
+/**
+ * Sets whether tiles are written by a writer thread of their own. Takes 
+ * effect when the headers are next defined.
+ * 
+ * @param asynchronous Flag enabling the writer thread
+ */
+void MappedPpmWriter::setAsynchronous(bool asynchronous){
+    this->asynchronous_ = asynchronous;
+}
+
+/**
+ * Gets whether tiles are written by a writer thread of their own
+ * 
+ * @return Flag indicating whether the writer thread is enabled
+ */
+bool MappedPpmWriter::isAsynchronous(){
+    return this->asynchronous_;
+}
+
+/**
+ * Converts the colors of a tile into the samples of the file, a row at a time
+ * 
+ * @param first_x X-coordinate of the top-left pixel of the tile
+ * @param first_y Y-coordinate of the top-left pixel of the tile
+ * @param tile_width Width of the tile in pixels
+ * @param tile_height Height of the tile in pixels
+ * @param samples Red, green and blue samples of the pixels of the tile, row by row
+ */
+void MappedPpmWriter::encodeTile(int first_x, int first_y, int tile_width, int tile_height, float* samples){
+    for (int y = 0; y < tile_height; y++) {
+        unsigned char* row = this->mapping_ + this->header_size_ + ((size_t)(first_y + y) * this->width_ + first_x) * 3 * this->sample_size_;
+        SampleQuantizer::quantize(samples + 3 * y * tile_width, 3 * tile_width, this->max_color_, row);
+    }
+}
+
+/**
+ * Writes finished rows to the file and drops them from memory. Only pages 
+ * lying wholly inside the rows are released, so the rows next to them can 
+ * still be written; pages are read back from the file if written again.
+ * 
+ * @param first_row First finished row
+ * @param row_count Amount of finished rows
+ */
+void MappedPpmWriter::releaseMappedRows(int first_row, int row_count){
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t row_size = (size_t)this->width_ * 3 * this->sample_size_;
+    size_t start = this->header_size_ + first_row * row_size;
+    size_t end = start + row_count * row_size;
+    start = (start + page_size - 1) / page_size * page_size;
+    end = end / page_size * page_size;
+    if(start >= end){
+        return;
+    }
+    msync(this->mapping_ + start, end - start, MS_SYNC);
+    madvise(this->mapping_ + start, end - start, MADV_DONTNEED);
+}
+
+/**
+ * Writes the requests of the queue in order until told to stop
+ */
+void MappedPpmWriter::runWriterThread(){
+    WriteRequest request;
+    while(true){
+        this->write_queue_->pop(&request);
+        switch(request.type){
+            case 0: //Tile
+                encodeTile(request.first_x, request.first_y, request.width, request.height, request.samples);
+                delete[] request.samples;
+                break;
+            case 1: //Release Rows
+                releaseMappedRows(request.first_y, request.height);
+                break;
+            default: //Stop
+                return;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+// Ray Tracer: mapped_ppm_writer.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Mapped PPM Writer generates a binary Portable Pixel Map file
+//                  (.ppm) that is sized in full when its headers are defined
+//                  and mapped into memory. Pixels are written straight into 
+//                  the file by any number of threads, and finished rows are 
+//                  handed back to the operating system, so images far larger
+//                  than memory can be written. In asynchronous mode tiles are
+//                  queued and encoded by a writer thread of their own, so 
+//                  the threads tracing never wait on the file. Conforms to the following 
+//                  specification (see <http://netpbm.sourceforge.net/doc/ppm.html>
+//                  for details):
+//              
+//              - A "magic number" for identifying the file type. 
+//                  (A binary PPM file's magic number is the two characters "P6")
+//              - NEW LINE.
+//              - A width, formatted as ASCII characters in decimal.
+//              - Whitespace.
+//              - A height, again in ASCII decimal.
+//              - NEW LINE.
+//              - The maximum color-component value, again in ASCII decimal.
+//              - NEW LINE.
+//              - Width * height pixels, each three binary values between 0 and
+//                   the specified maximum value (one byte each if the maximum
+//                   is below 256, otherwise two bytes, most significant first),
+//                   in the same order as an ASCII PPM file.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef MAPPED_PPM_WRITER_H
+#define	MAPPED_PPM_WRITER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "file_writer.h"
+#include "sample_quantizer.h"
+#include "write_queue.h"
+
+#include "../math/rgb_color.h"
+
+#define MAPPED_WRITE_QUEUE_CAPACITY 64
+
+class MappedPpmWriter: public FileWriter{
+public:
+    MappedPpmWriter();
+    MappedPpmWriter(std::string filename);
+    virtual ~MappedPpmWriter();
+    void init();
+    void defineHeaders(int image_width, int image_height, int max_color);
+    void addContent(std::string content);
+    void close();
+    int getType();
+    
+    void setPixel(int x, int y, RgbColor color);
+    void writeTile(int first_x, int first_y, int tile_width, int tile_height, float* samples);
+    void releaseRows(int first_row, int row_count);
+    int getWidth();
+    int getHeight();
+    void setAsynchronous(bool asynchronous);
+    bool isAsynchronous();
+private:
+    void encodeTile(int first_x, int first_y, int tile_width, int tile_height, float* samples);
+    void releaseMappedRows(int first_row, int row_count);
+    void runWriterThread();
+    
+    int file_descriptor_;
+    unsigned char* mapping_;
+    size_t mapping_size_;
+    size_t header_size_;
+    int width_;
+    int height_;
+    int max_color_;
+    int sample_size_;
+    bool asynchronous_;
+    WriteQueue* write_queue_;
+    std::thread writer_thread_;
+};
+
+#endif	/* MAPPED_PPM_WRITER_H */
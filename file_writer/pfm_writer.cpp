@@ -0,0 +1,166 @@
+// Ray Tracer: pfm_writer.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A PFM Writer generates a Portable Float Map file (.pfm), 
+//                  which keeps colors as 32-bit floats without clamping, so
+//                  an image can be exposed or composited again without 
+//                  tracing it again. A color of 255 is stored as 1.0.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "pfm_writer.h"
+
+PfmWriter::PfmWriter(){
+    this->filename_ = "PFM_File.pfm";
+    this->channel_count_ = 3;
+}
+
+PfmWriter::PfmWriter(std::string filename){
+    this->filename_ = filename;
+    this->channel_count_ = 3;
+}
+
+PfmWriter::~PfmWriter(){}
+
+/**
+ * Create the PFM file with the filename assigned in the constructor (or 
+ * setFilename), replacing any earlier file
+ */
+void PfmWriter::init(){
+    std::ofstream output_file;
+    output_file.open(this->filename_.c_str(), std::ios_base::binary);
+    output_file.close();
+}
+
+/**
+ * Set the headers identifying the file as a color (or grayscale) PFM file, 
+ * with the image width and height. The scale is written as -1 or 1 to match the byte order
+ * of this machine, which the floats are written in.
+ * 
+ * @param image_width Image width in pixels
+ * @param image_height Image height in pixels
+ * @param max_color Unused, since floats are not clamped to a maximum
+ */
+void PfmWriter::defineHeaders(int image_width, int image_height, int max_color){
+    int byte_order_test = 1;
+    bool little_endian = *(char*)&byte_order_test == 1;
+    
+    std::ofstream output_file;
+    output_file.open(this->filename_.c_str(), std::ios_base::app | std::ios_base::binary);
+    output_file << (this->channel_count_ == 1 ? "Pf" : "PF") << '\n';
+    output_file << image_width << " " << image_height << '\n';
+    output_file << (little_endian ? "-1.0" : "1.0") << '\n';
+    output_file.close();
+}
+
+/**
+ * Text cannot be placed in a float image: pixels are added with 
+ * addFrameBuffer.
+ * 
+ * @param content Text that would be added to the file
+ */
+void PfmWriter::addContent(std::string content){
+    throw std::logic_error("Pixels of a PFM file are added with addFrameBuffer.");
+}
+
+/**
+ * Implementation of the close function. 
+ * PFM does not have specifications for footers, so this function is a No-Op
+ */
+void PfmWriter::close(){
+    return;
+}
+
+/**
+ * Returns the type of File Writer
+ * 
+ * File Writer Flag List (10/19/2016)
+ * 
+ * 0: ASCII PPM Writer
+ * 1: Mapped Binary PPM Writer
+ * 2: PFM Writer
+ * 3: Binary PPM Writer
+ * 4: Stream Writer
+ * 
+ * @return The flag defining the writer as a PFM writer (2)
+ */
+int PfmWriter::getType(){
+    return 2;
+}
+
+/**
+ * Sets the amount of floats stored for each pixel, which must be set before
+ * the headers are defined
+ * 
+ * @param channel_count 3 for a color image, 1 for a grayscale image
+ */
+void PfmWriter::setChannelCount(int channel_count){
+    if(channel_count != 1 && channel_count != 3){
+        throw std::invalid_argument("A PFM file has 1 or 3 channels.");
+    }
+    this->channel_count_ = channel_count;
+}
+
+/**
+ * Gets the amount of floats stored for each pixel
+ * 
+ * @return 3 for a color image, 1 for a grayscale image
+ */
+int PfmWriter::getChannelCount(){
+    return this->channel_count_;
+}
+
+/**
+ * Adds every pixel of a frame buffer to the file, bottom row first
+ * 
+ * @param frame_buffer Frame buffer matching the headers of the file
+ */
+void PfmWriter::addFrameBuffer(FrameBuffer* frame_buffer){
+    int width = frame_buffer->getWidth();
+    std::vector<float> row(3 * width);
+    
+    std::ofstream output_file;
+    output_file.open(this->filename_.c_str(), std::ios_base::app | std::ios_base::binary);
+    for (int y = frame_buffer->getHeight() - 1; y >= 0; y--) {
+        float* samples = frame_buffer->getRow(y);
+        for (int i = 0; i < 3 * width; i++) {
+            row[i] = samples[i] * (1.0f / 255.0f);
+        }
+        output_file.write((char*)&row[0], row.size() * sizeof(float));
+    }
+    output_file.close();
+}
+
+/**
+ * Adds a planar buffer of floats to the file as they are, bottom row first.
+ * Used for output channels, whose values are not colors.
+ * 
+ * @param samples Floats of every pixel (as many per pixel as the channel count), row by row
+ * @param width Width of the buffer, matching the headers of the file
+ * @param height Height of the buffer, matching the headers of the file
+ */
+void PfmWriter::addPlane(float* samples, int width, int height){
+    size_t row_size = (size_t)width * this->channel_count_;
+    
+    std::ofstream output_file;
+    output_file.open(this->filename_.c_str(), std::ios_base::app | std::ios_base::binary);
+    for (int y = height - 1; y >= 0; y--) {
+        output_file.write((char*)(samples + y * row_size), row_size * sizeof(float));
+    }
+    output_file.close();
+}
@@ -0,0 +1,70 @@
+// Ray Tracer: pfm_writer.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A PFM Writer generates a Portable Float Map file (.pfm), 
+//                  which keeps colors as 32-bit floats without clamping, so
+//                  an image can be exposed or composited again without 
+//                  tracing it again. A color of 255 is stored as 1.0. 
+//                  Conforms to the following specification:
+//              
+//              - The identifier "PF" (a color image), or "Pf" (a grayscale
+//                   image, used for single-channel output variables).
+//              - NEW LINE.
+//              - A width and a height in ASCII decimal, separated by a space.
+//              - NEW LINE.
+//              - A scale, whose sign gives the byte order of the floats 
+//                   (negative: least significant byte first).
+//              - NEW LINE.
+//              - Width * height pixels, each three floats for red, green, and
+//                   blue (or one float for grayscale), starting at the BOTTOM-left corner of the image and 
+//                   proceeding left to right, then upwards.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef PFM_WRITER_H
+#define	PFM_WRITER_H
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "file_writer.h"
+
+#include "../frame_buffer.h"
+
+class PfmWriter: public FileWriter{
+public:
+    PfmWriter();
+    PfmWriter(std::string filename);
+    virtual ~PfmWriter();
+    void init();
+    void defineHeaders(int image_width, int image_height, int max_color);
+    void addContent(std::string content);
+    void close();
+    int getType();
+    
+    void setChannelCount(int channel_count);
+    int getChannelCount();
+    void addFrameBuffer(FrameBuffer* frame_buffer);
+    void addPlane(float* samples, int width, int height);
+private:
+    int channel_count_;
+};
+
+#endif	/* PFM_WRITER_H */
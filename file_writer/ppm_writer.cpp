@@ -115,3 +115,20 @@ void PpmWriter::addContent(std::string content){
 void PpmWriter::close(){
     return;
 }
+
+/**
+ * Returns the type of File Writer
+ * 
+ * File Writer Flag List (10/19/2016)
+ * 
+ * 0: ASCII PPM Writer
+ * 1: Mapped Binary PPM Writer
+ * 2: PFM Writer
+ * 3: Binary PPM Writer
+ * 4: Stream Writer
+ * 
+ * @return The flag defining the writer as an ASCII PPM writer (0)
+ */
+int PpmWriter::getType(){
+    return 0;
+}
@@ -65,6 +65,7 @@ public:
     void defineHeaders(int image_width, int image_height, int max_color);
     void addContent(std::string content);
     void close();
+    int getType();
 private:
             
 };
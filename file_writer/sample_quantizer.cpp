@@ -0,0 +1,98 @@
+// Ray Tracer: sample_quantizer.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: The Sample Quantizer converts color samples (0 to 255, as 
+//                  traced) into the 8-bit or 16-bit integers of binary image
+//                  files, clamping and rounding them to the nearest value. 
+//                  Eight samples are converted at a time with SSE2 where the
+//                  processor has it.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "sample_quantizer.h"
+
+/**
+ * Converts samples into the integers of a binary image file. Samples are 
+ * scaled so 255 becomes the maximum color, clamped and rounded. A maximum 
+ * color below 256 gives one byte per sample, otherwise two bytes, most 
+ * significant first.
+ * 
+ * With SSE2, eight samples are scaled, clamped and rounded as two sets of 
+ * four floats, then packed into integers of the output size. Adding a half and 
+ * truncating rounds the same way as the scalar path, since the samples are
+ * clamped to be positive first.
+ * 
+ * @param samples Samples to convert (0 to 255)
+ * @param sample_count Amount of samples
+ * @param max_color Maximum color value of the file (1-65535)
+ * @param output Resulting integers
+ */
+void SampleQuantizer::quantize(float* samples, int sample_count, int max_color, unsigned char* output){
+    float scale = max_color / 255.0f;
+    int i = 0;
+    
+#ifdef __SSE2__
+    __m128 scale_vector = _mm_set1_ps(scale);
+    __m128 zero_vector = _mm_setzero_ps();
+    __m128 max_vector = _mm_set1_ps(max_color);
+    __m128 half_vector = _mm_set1_ps(0.5f);
+    for (; i + 8 <= sample_count; i += 8) {
+        __m128i values[2];
+        for (int j = 0; j < 2; j++) {
+            __m128 value = _mm_mul_ps(_mm_loadu_ps(samples + i + 4 * j), scale_vector);
+            value = _mm_add_ps(_mm_min_ps(_mm_max_ps(value, zero_vector), max_vector), half_vector);
+            values[j] = _mm_cvttps_epi32(value);
+        }
+        __m128i low_values = values[0];
+        __m128i high_values = values[1];
+        if(max_color < 256){
+            __m128i packed = _mm_packus_epi16(_mm_packs_epi32(low_values, high_values), _mm_setzero_si128());
+            _mm_storel_epi64((__m128i*)(output + i), packed);
+        } else {
+            //Values above 32767 do not fit a signed pack, so shift them down and back after
+            __m128i offset = _mm_set1_epi32(32768);
+            __m128i packed = _mm_packs_epi32(_mm_sub_epi32(low_values, offset), _mm_sub_epi32(high_values, offset));
+            packed = _mm_xor_si128(packed, _mm_set1_epi16((short)0x8000));
+            packed = _mm_or_si128(_mm_slli_epi16(packed, 8), _mm_srli_epi16(packed, 8));
+            _mm_storeu_si128((__m128i*)(output + 2 * i), packed);
+        }
+    }
+#endif
+    
+    for (; i < sample_count; i++) {
+        int value = quantizeSample(samples[i], scale, max_color);
+        if(max_color < 256){
+            output[i] = (unsigned char)value;
+        } else {
+            output[2 * i] = (unsigned char)(value >> 8);
+            output[2 * i + 1] = (unsigned char)(value & 0xFF);
+        }
+    }
+}
+
+/**
+ * Converts one sample into an integer of a binary image file
+ * 
+ * @param sample Sample to convert (0 to 255)
+ * @param scale Scale from 255 to the maximum color
+ * @param max_color Maximum color value of the file
+ * @return Scaled, clamped and rounded sample
+ */
+int SampleQuantizer::quantizeSample(float sample, float scale, int max_color){
+    return (int)(std::max(0.0f, std::min((float)max_color, sample * scale)) + 0.5f);
+}
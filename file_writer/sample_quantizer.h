@@ -0,0 +1,43 @@
+// Ray Tracer: sample_quantizer.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: The Sample Quantizer converts color samples (0 to 255, as 
+//                  traced) into the 8-bit or 16-bit integers of binary image
+//                  files, clamping and rounding them to the nearest value. 
+//                  Eight samples are converted at a time with SSE2 where the
+//                  processor has it.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef SAMPLE_QUANTIZER_H
+#define	SAMPLE_QUANTIZER_H
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+class SampleQuantizer {
+public:
+    static void quantize(float* samples, int sample_count, int max_color, unsigned char* output);
+    static int quantizeSample(float sample, float scale, int max_color);
+};
+
+#endif	/* SAMPLE_QUANTIZER_H */
@@ -0,0 +1,235 @@
+// Ray Tracer: stream_writer.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Stream Writer writes each frame as soon as it is complete to 
+//                  standard output, a named pipe or an open descriptor, so
+//                  a video encoder can read the frames as they are traced 
+//                  without any temporary files. Frames are raw 8-bit (or 
+//                  16-bit, most significant byte first) RGB samples, row by
+//                  row from the top-left corner, optionally each preceded 
+//                  by a binary PPM header. A whole frame is handed to the 
+//                  stream at once, bypassing any buffering in the process.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "stream_writer.h"
+
+StreamWriter::StreamWriter(){
+    this->filename_ = "-";
+    this->file_descriptor_ = -1;
+    this->owns_descriptor_ = false;
+    this->frame_headers_ = false;
+    this->width_ = 0;
+    this->height_ = 0;
+    this->max_color_ = 255;
+    this->header_size_ = 0;
+    this->frame_count_ = 0;
+}
+
+StreamWriter::StreamWriter(std::string filename){
+    this->filename_ = filename;
+    this->file_descriptor_ = -1;
+    this->owns_descriptor_ = false;
+    this->frame_headers_ = false;
+    this->width_ = 0;
+    this->height_ = 0;
+    this->max_color_ = 255;
+    this->header_size_ = 0;
+    this->frame_count_ = 0;
+}
+
+StreamWriter::StreamWriter(int file_descriptor){
+    this->filename_ = "";
+    this->file_descriptor_ = file_descriptor;
+    this->owns_descriptor_ = false;
+    this->frame_headers_ = false;
+    this->width_ = 0;
+    this->height_ = 0;
+    this->max_color_ = 255;
+    this->header_size_ = 0;
+    this->frame_count_ = 0;
+}
+
+StreamWriter::~StreamWriter(){
+    if(this->owns_descriptor_){
+        ::close(this->file_descriptor_);
+    }
+}
+
+/**
+ * Opens the stream the first time it is called: standard output when the 
+ * filename is "-", otherwise the file or named pipe with the filename 
+ * assigned in the constructor. Opening a named pipe waits until a reader has
+ * opened it. The stream stays open for every following frame, so later calls
+ * (and later filenames) are ignored.
+ */
+void StreamWriter::init(){
+    if(this->file_descriptor_ >= 0){
+        return;
+    }
+    if(this->filename_ == "-"){
+        this->file_descriptor_ = STDOUT_FILENO;
+        return;
+    }
+    
+    this->file_descriptor_ = open(this->filename_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(this->file_descriptor_ < 0){
+        throw std::runtime_error("Could not open " + this->filename_ + ".");
+    }
+    this->owns_descriptor_ = true;
+}
+
+/**
+ * Sets the size and maximum color value of the next frame, and sizes the 
+ * buffer the frame is encoded into. When the stream is a pipe, its capacity 
+ * is raised towards the size of a frame (up to STREAM_MAX_PIPE_SIZE), so the
+ * reader wakes up less often.
+ * 
+ * @param image_width Frame width in pixels
+ * @param image_height Frame height in pixels
+ * @param max_color Maximum color value (1-65535); above 255, samples take two bytes
+ */
+void StreamWriter::defineHeaders(int image_width, int image_height, int max_color){
+    if(max_color <= 0 || max_color >= 65536){
+        throw std::invalid_argument("Maximum color value must be less than 65536 and more than zero.");
+    }
+    if(this->file_descriptor_ < 0){
+        throw std::logic_error("The stream must be opened with init before headers are defined.");
+    }
+    
+    char header[64];
+    this->header_size_ = 0;
+    if(this->frame_headers_){
+        this->header_size_ = snprintf(header, sizeof(header), "P6\n%d %d\n%d\n", image_width, image_height, max_color);
+    }
+    
+    this->width_ = image_width;
+    this->height_ = image_height;
+    this->max_color_ = max_color;
+    int sample_size = max_color < 256 ? 1 : 2;
+    this->frame_.resize(this->header_size_ + (size_t)image_width * image_height * 3 * sample_size);
+    std::copy(header, header + this->header_size_, this->frame_.begin());
+    
+#ifdef F_SETPIPE_SZ
+    //Fails harmlessly when the stream is not a pipe
+    fcntl(this->file_descriptor_, F_SETPIPE_SZ, (int)std::min(this->frame_.size(), (size_t)STREAM_MAX_PIPE_SIZE));
+#endif
+}
+
+/**
+ * Text cannot be placed in a binary stream: frames are added with 
+ * addFrameBuffer.
+ * 
+ * @param content Text that would be added to the stream
+ */
+void StreamWriter::addContent(std::string content){
+    throw std::logic_error("Frames of a stream are added with addFrameBuffer.");
+}
+
+/**
+ * Implementation of the close function. 
+ * Each frame is already in the stream once addFrameBuffer returns, and the 
+ * stream stays open for the next frame, so this function is a No-Op. The 
+ * stream is closed when the writer is deleted (standard output and 
+ * descriptors given to the constructor are left open).
+ */
+void StreamWriter::close(){
+    return;
+}
+
+/**
+ * Returns the type of File Writer
+ * 
+ * File Writer Flag List (10/19/2016)
+ * 
+ * 0: ASCII PPM Writer
+ * 1: Mapped Binary PPM Writer
+ * 2: PFM Writer
+ * 3: Binary PPM Writer
+ * 4: Stream Writer
+ * 
+ * @return The flag defining the writer as a stream writer (4)
+ */
+int StreamWriter::getType(){
+    return 4;
+}
+
+/**
+ * Sets whether each frame is preceded by a binary PPM header, for readers 
+ * that take a sequence of PPM images rather than raw video of a known size
+ * 
+ * @param frame_headers Whether each frame starts with a PPM header
+ */
+void StreamWriter::setFrameHeaders(bool frame_headers){
+    this->frame_headers_ = frame_headers;
+}
+
+/**
+ * Gets whether each frame is preceded by a binary PPM header
+ * 
+ * @return Whether each frame starts with a PPM header
+ */
+bool StreamWriter::getFrameHeaders(){
+    return this->frame_headers_;
+}
+
+/**
+ * Encodes every pixel of a frame buffer into the frame and writes the whole 
+ * frame to the stream
+ * 
+ * @param frame_buffer Frame buffer matching the headers of the frame
+ */
+void StreamWriter::addFrameBuffer(FrameBuffer* frame_buffer){
+    if(frame_buffer->getWidth() != this->width_ || frame_buffer->getHeight() != this->height_){
+        throw std::logic_error("The frame buffer must match the headers of the frame.");
+    }
+    
+    size_t row_size = (size_t)this->width_ * 3 * (this->max_color_ < 256 ? 1 : 2);
+    for (int y = 0; y < this->height_; y++) {
+        SampleQuantizer::quantize(frame_buffer->getRow(y), 3 * this->width_, this->max_color_, &this->frame_[this->header_size_ + y * row_size]);
+    }
+    writeFrame();
+}
+
+/**
+ * Gets the amount of frames written to the stream
+ * 
+ * @return Amount of frames written
+ */
+long StreamWriter::getFrameCount(){
+    return this->frame_count_;
+}
+
+/**
+ * Writes the encoded frame to the stream, continuing after partial writes 
+ * and interruptions until every byte is written
+ */
+void StreamWriter::writeFrame(){
+    size_t written = 0;
+    while(written < this->frame_.size()){
+        ssize_t result = write(this->file_descriptor_, &this->frame_[written], this->frame_.size() - written);
+        if(result < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            throw std::runtime_error(std::string("Could not write a frame to the stream: ") + strerror(errno) + ".");
+        }
+        written += result;
+    }
+    this->frame_count_++;
+}
@@ -0,0 +1,81 @@
+// Ray Tracer: stream_writer.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Stream Writer writes each frame as soon as it is complete to 
+//                  standard output, a named pipe or an open descriptor, so
+//                  a video encoder can read the frames as they are traced 
+//                  without any temporary files. Frames are raw 8-bit (or 
+//                  16-bit, most significant byte first) RGB samples, row by
+//                  row from the top-left corner, optionally each preceded 
+//                  by a binary PPM header. A whole frame is handed to the 
+//                  stream at once, bypassing any buffering in the process.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef STREAM_WRITER_H
+#define	STREAM_WRITER_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "file_writer.h"
+#include "sample_quantizer.h"
+
+#include "../frame_buffer.h"
+
+#define STREAM_MAX_PIPE_SIZE (1 << 20)
+
+class StreamWriter: public FileWriter{
+public:
+    StreamWriter();
+    StreamWriter(std::string filename);
+    StreamWriter(int file_descriptor);
+    virtual ~StreamWriter();
+    void init();
+    void defineHeaders(int image_width, int image_height, int max_color);
+    void addContent(std::string content);
+    void close();
+    int getType();
+    
+    void setFrameHeaders(bool frame_headers);
+    bool getFrameHeaders();
+    void addFrameBuffer(FrameBuffer* frame_buffer);
+    long getFrameCount();
+private:
+    void writeFrame();
+    
+    int file_descriptor_;
+    bool owns_descriptor_;
+    bool frame_headers_;
+    int width_;
+    int height_;
+    int max_color_;
+    size_t header_size_;
+    std::vector<unsigned char> frame_;
+    long frame_count_;
+};
+
+#endif	/* STREAM_WRITER_H */
@@ -0,0 +1,148 @@
+// Ray Tracer: write_queue.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Write Queue hands finished parts of an image from the 
+//                  threads tracing them to the thread writing them. It holds
+//                  a fixed number of requests in a ring, and any number of 
+//                  threads may push and pop at once without locks: each slot
+//                  carries a sequence number telling whether it is ready to
+//                  be filled or emptied for the current lap of the ring 
+//                  (after Dmitry Vyukov's bounded queue).
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "write_queue.h"
+
+/**
+ * Creates an empty queue
+ * 
+ * @param capacity Amount of requests the queue holds, rounded up to a power of two
+ */
+WriteQueue::WriteQueue(int capacity){
+    size_t cell_count = 2;
+    while(cell_count < (size_t)capacity){
+        cell_count *= 2;
+    }
+    this->cells_ = new WriteQueueCell[cell_count];
+    this->mask_ = cell_count - 1;
+    for (size_t i = 0; i < cell_count; i++) {
+        this->cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    this->push_position_.store(0, std::memory_order_relaxed);
+    this->pop_position_.store(0, std::memory_order_relaxed);
+}
+
+WriteQueue::~WriteQueue(){
+    delete[] this->cells_;
+}
+
+/**
+ * Adds a request to the back of the queue, unless the queue is full.
+ * 
+ * A slot whose sequence equals the push position is free for this lap: the 
+ * position is claimed with a compare-and-swap, the request is stored, and the
+ * sequence is advanced by one to hand the slot to the consumers. A sequence 
+ * behind the position means the slot still holds a request from the last lap.
+ * 
+ * @param request Request to add
+ * @return Flag indicating whether the request was added
+ */
+bool WriteQueue::tryPush(WriteRequest request){
+    size_t position = this->push_position_.load(std::memory_order_relaxed);
+    while(true){
+        WriteQueueCell* cell = &this->cells_[position & this->mask_];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        ptrdiff_t difference = (ptrdiff_t)sequence - (ptrdiff_t)position;
+        if(difference == 0){
+            if(this->push_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                cell->request = request;
+                cell->sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if(difference < 0){
+            return false;
+        } else {
+            position = this->push_position_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Takes the request at the front of the queue, unless the queue is empty.
+ * 
+ * A slot whose sequence is one past the pop position holds a request for 
+ * this lap; once taken, the sequence is advanced to the position of the slot
+ * in the next lap, freeing it for the producers.
+ * 
+ * @param request Resulting request taken from the queue
+ * @return Flag indicating whether a request was taken
+ */
+bool WriteQueue::tryPop(WriteRequest* request){
+    size_t position = this->pop_position_.load(std::memory_order_relaxed);
+    while(true){
+        WriteQueueCell* cell = &this->cells_[position & this->mask_];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        ptrdiff_t difference = (ptrdiff_t)sequence - (ptrdiff_t)(position + 1);
+        if(difference == 0){
+            if(this->pop_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                *request = cell->request;
+                cell->sequence.store(position + this->mask_ + 1, std::memory_order_release);
+                return true;
+            }
+        } else if(difference < 0){
+            return false;
+        } else {
+            position = this->pop_position_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Adds a request to the back of the queue. While the queue is full the 
+ * calling thread gives way to others, which holds tracing back until the 
+ * writer catches up.
+ * 
+ * @param request Request to add
+ */
+void WriteQueue::push(WriteRequest request){
+    while(!tryPush(request)){
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * Takes the request at the front of the queue. While the queue is empty the 
+ * calling thread sleeps in short steps, so an idle writer leaves the 
+ * processors to the threads tracing.
+ * 
+ * @param request Resulting request taken from the queue
+ */
+void WriteQueue::pop(WriteRequest* request){
+    while(!tryPop(request)){
+        std::this_thread::sleep_for(std::chrono::microseconds(WRITE_QUEUE_IDLE_MICROSECONDS));
+    }
+}
+
+/**
+ * Gets the amount of requests the queue holds
+ * 
+ * @return Capacity of the queue
+ */
+int WriteQueue::getCapacity(){
+    return this->mask_ + 1;
+}
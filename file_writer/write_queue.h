@@ -0,0 +1,77 @@
+// Ray Tracer: write_queue.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Write Queue hands finished parts of an image from the 
+//                  threads tracing them to the thread writing them. It holds
+//                  a fixed number of requests in a ring, and any number of 
+//                  threads may push and pop at once without locks: each slot
+//                  carries a sequence number telling whether it is ready to
+//                  be filled or emptied for the current lap of the ring 
+//                  (after Dmitry Vyukov's bounded queue).
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef WRITE_QUEUE_H
+#define	WRITE_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+#define WRITE_QUEUE_CACHE_LINE_SIZE 64
+#define WRITE_QUEUE_IDLE_MICROSECONDS 200
+
+//A tile of pixels to write, or a band of rows to release once written
+struct WriteRequest {
+    int type; //0: Tile, 1: Release Rows, 2: Stop
+    int first_x;
+    int first_y;
+    int width;
+    int height;
+    float* samples;
+};
+
+//One slot of the ring
+struct WriteQueueCell {
+    std::atomic<size_t> sequence;
+    WriteRequest request;
+};
+
+class WriteQueue {
+public:
+    WriteQueue(int capacity);
+    virtual ~WriteQueue();
+    
+    bool tryPush(WriteRequest request);
+    bool tryPop(WriteRequest* request);
+    void push(WriteRequest request);
+    void pop(WriteRequest* request);
+    int getCapacity();
+    
+private:
+    WriteQueueCell* cells_;
+    size_t mask_;
+    char padding_before_[WRITE_QUEUE_CACHE_LINE_SIZE];
+    std::atomic<size_t> push_position_;
+    char padding_between_[WRITE_QUEUE_CACHE_LINE_SIZE];
+    std::atomic<size_t> pop_position_;
+    char padding_after_[WRITE_QUEUE_CACHE_LINE_SIZE];
+};
+
+#endif	/* WRITE_QUEUE_H */
@@ -0,0 +1,90 @@
+// Ray Tracer: frame_buffer.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Frame Buffer holds the color of every pixel of the image
+//                  between renders, so parts of the image can be traced 
+//                  again without tracing the whole image. Colors are stored 
+//                  as floats, red, green and blue for each pixel in turn, 
+//                  row by row, so whole rows can be processed and written 
+//                  without conversion.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "frame_buffer.h"
+
+FrameBuffer::FrameBuffer(int width, int height){
+    this->width_ = width;
+    this->height_ = height;
+    this->samples_.resize(3 * width * height, 0.0f);
+}
+
+FrameBuffer::~FrameBuffer(){}
+
+/**
+ * Gets the width of the image in pixels
+ *
+ * @return Width of the image
+ */
+int FrameBuffer::getWidth(){
+    return this->width_;
+}
+
+/**
+ * Gets the height of the image in pixels
+ *
+ * @return Height of the image
+ */
+int FrameBuffer::getHeight(){
+    return this->height_;
+}
+
+/**
+ * Gets the color of a pixel
+ *
+ * @param x X-coordinate of the pixel
+ * @param y Y-coordinate of the pixel
+ * @return Color of the pixel
+ */
+RgbColor FrameBuffer::getPixel(int x, int y){
+    float* pixel = &this->samples_[3 * (y * this->width_ + x)];
+    return RgbColor(pixel[0], pixel[1], pixel[2]);
+}
+
+/**
+ * Sets the color of a pixel
+ *
+ * @param x X-coordinate of the pixel
+ * @param y Y-coordinate of the pixel
+ * @param color Color of the pixel
+ */
+void FrameBuffer::setPixel(int x, int y, RgbColor color){
+    float* pixel = &this->samples_[3 * (y * this->width_ + x)];
+    pixel[0] = color.getRed();
+    pixel[1] = color.getGreen();
+    pixel[2] = color.getBlue();
+}
+
+/**
+ * Gets the samples of a row of pixels, stored left to right
+ *
+ * @param y Y-coordinate of the row
+ * @return Red, green and blue samples of each pixel of the row
+ */
+float* FrameBuffer::getRow(int y){
+    return &this->samples_[3 * y * this->width_];
+}
@@ -0,0 +1,52 @@
+// Ray Tracer: frame_buffer.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Frame Buffer holds the color of every pixel of the image
+//                  between renders, so parts of the image can be traced 
+//                  again without tracing the whole image. Colors are stored 
+//                  as floats, red, green and blue for each pixel in turn, 
+//                  row by row, so whole rows can be processed and written 
+//                  without conversion.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef FRAME_BUFFER_H
+#define FRAME_BUFFER_H
+
+#include <vector>
+
+#include "math/rgb_color.h"
+
+class FrameBuffer {
+public:
+    FrameBuffer(int width, int height);
+    virtual ~FrameBuffer();
+    
+    int getWidth();
+    int getHeight();
+    RgbColor getPixel(int x, int y);
+    void setPixel(int x, int y, RgbColor color);
+    float* getRow(int y);
+    
+private:
+    int width_;
+    int height_;
+    std::vector<float> samples_;
+};
+
+#endif /* FRAME_BUFFER_H */
@@ -0,0 +1,77 @@
+// Ray Tracer: g_buffer.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: A G-Buffer keeps the surfaces hit by the rays of each pixel 
+//                  so the image can be shaded again without casting the 
+//                  primary, reflection and refraction rays. Each hit is 
+//                  stored as a node linked to the hit whose ray spawned it,
+//                  together with the weight its color was gathered with.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "g_buffer.h"
+
+GBuffer::GBuffer(int width, int height){
+    this->width_ = width;
+    this->height_ = height;
+    this->pixel_nodes_.resize(width * height);
+}
+
+GBuffer::~GBuffer(){}
+
+/**
+ * Gets the width of the buffer in pixels
+ *
+ * @return Width of the buffer
+ */
+int GBuffer::getWidth(){
+    return this->width_;
+}
+
+/**
+ * Gets the height of the buffer in pixels
+ *
+ * @return Height of the buffer
+ */
+int GBuffer::getHeight(){
+    return this->height_;
+}
+
+/**
+ * Gets the list of surfaces hit by the rays of a pixel
+ *
+ * @param x X-coordinate of the pixel
+ * @param y Y-coordinate of the pixel
+ * @return Pointer to the nodes of the pixel
+ */
+std::vector<GBufferNode>* GBuffer::getPixelNodes(int x, int y){
+    return &this->pixel_nodes_[y * this->width_ + x];
+}
+
+/**
+ * Gets the amount of surfaces stored for the whole image
+ *
+ * @return Amount of nodes in the buffer
+ */
+long GBuffer::getNodeCount(){
+    long node_count = 0;
+    for (unsigned int i = 0; i < this->pixel_nodes_.size(); i++) {
+        node_count += this->pixel_nodes_[i].size();
+    }
+    return node_count;
+}
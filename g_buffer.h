@@ -0,0 +1,68 @@
+// Ray Tracer: g_buffer.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: A G-Buffer keeps the surfaces hit by the rays of each pixel 
+//                  so the image can be shaded again without casting the 
+//                  primary, reflection and refraction rays. Each hit is 
+//                  stored as a node linked to the hit whose ray spawned it,
+//                  together with the weight its color was gathered with.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef G_BUFFER_H
+#define G_BUFFER_H
+
+#include <vector>
+
+#include "geo/geometry.h"
+
+#include "math/point3d.h"
+#include "math/rgb_color.h"
+#include "math/vector3d.h"
+
+//A surface hit by a ray of a pixel. Nodes are stored in the order the rays
+//were cast, so every node follows the node that spawned it. A node without
+//a parent starts a new sample of the pixel, and a node without geometry
+//marks a ray that missed the scene.
+struct GBufferNode {
+    int parent_index;
+    Geometry* geometry;
+    Point3D position;
+    Vector3D normal;
+    Vector3D direction_to_eye;
+    RgbColor weight;
+    double weight_scale;
+};
+
+class GBuffer {
+public:
+    GBuffer(int width, int height);
+    virtual ~GBuffer();
+    
+    int getWidth();
+    int getHeight();
+    std::vector<GBufferNode>* getPixelNodes(int x, int y);
+    long getNodeCount();
+    
+private:
+    int width_;
+    int height_;
+    std::vector< std::vector<GBufferNode> > pixel_nodes_;
+};
+
+#endif /* G_BUFFER_H */
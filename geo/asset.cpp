@@ -0,0 +1,156 @@
+// Ray Tracer: asset.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: An Asset is a group of geometry placed many times in a scene 
+//                 through Instances. The geometry and the hierarchy sorting 
+//                 it are stored once, in the space of the asset, however 
+//                 many instances there are.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "asset.h"
+
+Asset::Asset(){
+    this->bvh_ = NULL;
+}
+
+Asset::~Asset(){
+    delete this->bvh_;
+    
+    while(!this->geometry_list_.empty()){
+        Geometry* geometry = this->geometry_list_.back();
+        delete geometry;
+        this->geometry_list_.pop_back();
+    }
+}
+
+/**
+ * Adds geometry to the asset, in the space of the asset. The asset takes 
+ * ownership of the geometry. Geometry should not be added or edited once the 
+ * asset is placed in a scene, since its instances would not be marked edited.
+ * 
+ * @param geometry Pointer to a geometry description
+ */
+void Asset::addGeo(Geometry* geometry){
+    this->geometry_list_.push_back(geometry);
+    delete this->bvh_;
+    this->bvh_ = NULL;
+}
+
+/**
+ * Retrieves the geometry description at the given index
+ * 
+ * @param index Index to retrieve the geometry description from
+ * @return Geometry description at the given index
+ */
+Geometry* Asset::getGeoAt(int index){
+    return this->geometry_list_.at(index);
+}
+
+/**
+ * Gets the amount of Geometry objects in the asset
+ * 
+ * @return Amount of Geometry objects in the asset
+ */
+int Asset::getGeoListSize(){
+    return this->geometry_list_.size();
+}
+
+/**
+ * Sorts the geometry of the asset into its hierarchy. This happens on first 
+ * use, which is when the first instance of the asset is added to a scene.
+ */
+void Asset::build(){
+    delete this->bvh_;
+    this->bvh_ = new Bvh(this->geometry_list_);
+    
+    this->bounds_ = BoundingBox();
+    for (unsigned int i = 0; i < this->geometry_list_.size(); i++) {
+        this->bounds_.expand(this->geometry_list_[i]->getBounds());
+    }
+}
+
+/**
+ * Finds the geometry of the asset nearest to the origin of a ray given in the
+ * space of the asset
+ * 
+ * @param ray Ray to compute intersections with
+ * @param nearest_point Resulting point of the nearest intersection
+ * @param normal_at_nearest_point Resulting normal at the nearest intersection
+ * @return Geometry nearest to the origin of the ray (NULL if none is hit)
+ */
+Geometry* Asset::computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point){
+    if(this->bvh_ == NULL){
+        build();
+    }
+    return this->bvh_->computeNearestIntersection(ray, nearest_point, normal_at_nearest_point);
+}
+
+/**
+ * Determines if a ray given in the space of the asset intersects any of its 
+ * geometry within the ray's interval
+ * 
+ * @param ray Ray to compute intersections with
+ * @return Result of the check
+ */
+bool Asset::hasIntersection(Ray* ray){
+    if(this->bvh_ == NULL){
+        build();
+    }
+    return this->bvh_->hasIntersection(ray);
+}
+
+/**
+ * Gets the box enclosing the geometry of the asset, in the space of the asset
+ * 
+ * @return Box enclosing the asset
+ */
+BoundingBox Asset::getBounds(){
+    if(this->bvh_ == NULL){
+        build();
+    }
+    return this->bounds_;
+}
+
+/**
+ * Checks whether any geometry of the asset reflects
+ * 
+ * @return Boolean indicating presence of reflection in the asset
+ */
+bool Asset::hasReflection(){
+    for (unsigned int i = 0; i < this->geometry_list_.size(); i++) {
+        if(this->geometry_list_[i]->hasReflection()){
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Checks whether any geometry of the asset refracts
+ * 
+ * @return Boolean indicating presence of refraction in the asset
+ */
+bool Asset::hasRefraction(){
+    for (unsigned int i = 0; i < this->geometry_list_.size(); i++) {
+        if(this->geometry_list_[i]->hasRefraction()){
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,63 @@
+// Ray Tracer: asset.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: An Asset is a group of geometry placed many times in a scene 
+//                 through Instances. The geometry and the hierarchy sorting 
+//                 it are stored once, in the space of the asset, however 
+//                 many instances there are.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef ASSET_H
+#define ASSET_H
+
+#include <vector>
+
+#include "geometry.h"
+
+#include "../ray.h"
+
+#include "../accel/bvh.h"
+
+#include "../math/bounding_box.h"
+#include "../math/point3d.h"
+#include "../math/vector3d.h"
+
+class Asset {
+public:
+    Asset();
+    virtual ~Asset();
+    
+    void addGeo(Geometry* geometry);
+    Geometry* getGeoAt(int index);
+    int getGeoListSize();
+    
+    void build();
+    Geometry* computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point);
+    bool hasIntersection(Ray* ray);
+    BoundingBox getBounds();
+    bool hasReflection();
+    bool hasRefraction();
+    
+private:
+    std::vector<Geometry*> geometry_list_;
+    Bvh* bvh_;
+    BoundingBox bounds_;
+};
+
+#endif /* ASSET_H */
@@ -24,7 +24,11 @@
 
 #include "geometry.h"
 
-Geometry::Geometry(){}
+Geometry::Geometry(){
+    this->edited_ = false;
+    this->moved_ = false;
+    this->object_id_ = 0;
+}
 
 Geometry::~Geometry(){
     delete this->shader_;
@@ -53,6 +57,24 @@ int Geometry::getShaderType(){
     return this->shader_->getType();
 }
 
+/**
+ * Computes the geometry hit by the ray, along with the point hit and the 
+ * normal at that point. Geometry made of other geometry (such as an Instance)
+ * returns the part that was hit, which is the geometry to shade. Otherwise 
+ * this is the geometry itself.
+ * 
+ * @param ray Ray to test intersection
+ * @param point_hit Point hit by the ray, if intersection is detected
+ * @param normal_hit Normal of the surface at the point that is hit, if intersection is detected
+ * @return Geometry hit by the ray (NULL if none)
+ */
+Geometry* Geometry::computeNearestIntersection(Ray* ray, Point3D* point_hit, Vector3D* normal_hit){
+    if(hasIntersection(ray, point_hit, normal_hit)){
+        return this;
+    }
+    return NULL;
+}
+
 /**
  * Queries the shader to see whether it has reflection or not
  * 
@@ -87,6 +109,7 @@ RgbColor Geometry::getDiffuseColor(){
  */
 void Geometry::setDiffuseColor(RgbColor diffuse_color){
     this->shader_->setDiffuseColor(diffuse_color);
+    markEdited(false);
 }
 
 /**
@@ -105,6 +128,7 @@ RgbColor Geometry::getSpecularHighlight(){
  */
 void Geometry::setSpecularHighlight(RgbColor specular_highlight){
     this->shader_->setSpecularHighlight(specular_highlight);
+    markEdited(false);
 }
 
 /**
@@ -123,6 +147,7 @@ int Geometry::getPhongConstant(){
  */
 void Geometry::setPhongConstant(int phong_constant){
     this->shader_->setPhongConstant(phong_constant);
+    markEdited(false);
 }
 
 /**
@@ -141,6 +166,26 @@ RgbColor Geometry::getReflectiveColor(){
  */
 void Geometry::setReflectiveColor(RgbColor reflective_color){
     this->shader_->setReflectiveColor(reflective_color);
+    markEdited(false);
+}
+
+/**
+ * Gets the shader's transmissive color
+ * 
+ * @return Shader Transmissive Color
+ */
+RgbColor Geometry::getTransmissiveColor(){
+    return this->shader_->getTransmissiveColor();
+}
+
+/**
+ * Sets the shader's transmissive color
+ * 
+ * @param transmissive_color Transmissive color to set
+ */
+void Geometry::setTransmissiveColor(RgbColor transmissive_color){
+    this->shader_->setTransmissiveColor(transmissive_color);
+    markEdited(false);
 }
 
 /**
@@ -159,4 +204,75 @@ double Geometry::getRefractionIndex(){
  */
 void Geometry::setRefractionIndex(double refraction_index){
     this->shader_->setRefractionIndex(refraction_index);
+    markEdited(false);
+}
+
+/**
+ * Records that the geometry has been edited since the last render, so the
+ * ray tracer can find the part of the image that must be traced again. The
+ * current bounds of the geometry are added to the edited bounds, so moving 
+ * geometry must be marked both before and after it is moved.
+ * 
+ * @param moved Flag indicating whether the shape or position of the geometry changed
+ */
+void Geometry::markEdited(bool moved){
+    this->edited_ = true;
+    this->moved_ = this->moved_ || moved;
+    this->edited_bounds_.expand(getBounds());
+}
+
+/**
+ * Determines if the geometry has been edited since the edits were last cleared
+ * 
+ * @return Result of the check
+ */
+bool Geometry::isEdited(){
+    return this->edited_;
+}
+
+/**
+ * Determines if the shape or position of the geometry has changed since the 
+ * edits were last cleared, in which case the shadows it casts changed too
+ * 
+ * @return Result of the check
+ */
+bool Geometry::hasMoved(){
+    return this->moved_;
+}
+
+/**
+ * Gets the box enclosing the geometry both before and after its edits
+ * 
+ * @return Box enclosing every position of the geometry since the edits were last cleared
+ */
+BoundingBox Geometry::getEditedBounds(){
+    return this->edited_bounds_;
+}
+
+/**
+ * Forgets the edits made to the geometry, once they have been rendered
+ */
+void Geometry::clearEdits(){
+    this->edited_ = false;
+    this->moved_ = false;
+    this->edited_bounds_ = BoundingBox();
+}
+
+/**
+ * Sets the id written to the object id output channel where the geometry is
+ * hit. Geometry added to a scene without an id is given one by the scene.
+ * 
+ * @param object_id Id of the geometry (0 for none)
+ */
+void Geometry::setObjectId(int object_id){
+    this->object_id_ = object_id;
+}
+
+/**
+ * Gets the id written to the object id output channel where the geometry is hit
+ * 
+ * @return Id of the geometry (0 for none)
+ */
+int Geometry::getObjectId(){
+    return this->object_id_;
 }
@@ -29,6 +29,7 @@
 
 #include "../ray.h"
 #include "../shader/shader.h"
+#include "../math/bounding_box.h"
 #include "../math/point3d.h"
 #include "../math/vector3d.h"
 
@@ -40,9 +41,11 @@ public:
     void initShader(Shader* shader);
     
     virtual bool hasIntersection(Ray* ray, Point3D* point_hit, Vector3D* normal_hit) = 0;
+    virtual Geometry* computeNearestIntersection(Ray* ray, Point3D* point_hit, Vector3D* normal_hit);
+    virtual BoundingBox getBounds() = 0;
     int getShaderType();
-    bool hasReflection();
-    bool hasRefraction();
+    virtual bool hasReflection();
+    virtual bool hasRefraction();
     
     RgbColor getDiffuseColor();
     void setDiffuseColor(RgbColor diffuse_color);
@@ -52,11 +55,26 @@ public:
     void setPhongConstant(int phong_constant);
     RgbColor getReflectiveColor();
     void setReflectiveColor(RgbColor reflective_color);
+    RgbColor getTransmissiveColor();
+    void setTransmissiveColor(RgbColor transmissive_color);
     double getRefractionIndex();
     void setRefractionIndex(double refraction_index);
     
+    void markEdited(bool moved);
+    bool isEdited();
+    bool hasMoved();
+    BoundingBox getEditedBounds();
+    void clearEdits();
+    
+    void setObjectId(int object_id);
+    int getObjectId();
+    
 protected:
     Shader* shader_;
+    bool edited_;
+    bool moved_;
+    BoundingBox edited_bounds_;
+    int object_id_;
 
 };
 
@@ -0,0 +1,161 @@
+// Ray Tracer: instance.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: An Instance places an Asset in the scene with a transform. 
+//                 Rays are moved into the space of the asset to be traced 
+//                 against its shared geometry, so each instance only stores
+//                 its transform. The geometry of the asset that is hit is 
+//                 shaded with its own shader.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "instance.h"
+
+/**
+ * Places an asset in the scene. The instance does not take ownership of the
+ * asset, which is shared by all its instances (see Scene::addAsset).
+ * 
+ * @param asset Asset to place
+ * @param transform Transform from the space of the asset to the scene
+ */
+Instance::Instance(Asset* asset, Transform transform){
+    this->asset_ = asset;
+    this->transform_ = transform;
+    
+    //The geometry of the asset is shaded, never the instance itself
+    this->shader_ = NULL;
+}
+
+Instance::~Instance(){}
+
+/**
+ * Determines if the ray intersects the asset and computes the point hit and 
+ * the normal at that point, in the space of the scene
+ * 
+ * @param ray Ray to test intersection
+ * @param point_hit Point hit by the ray, if intersection is detected
+ * @param normal_hit Normal of the surface at the point that is hit, if intersection is detected
+ * @return Boolean indicating whether intersection was detected or not
+ */
+bool Instance::hasIntersection(Ray* ray, Point3D* point_hit, Vector3D* normal_hit){
+    return computeNearestIntersection(ray, point_hit, normal_hit) != NULL;
+}
+
+/**
+ * Computes the geometry of the asset hit by the ray. The ray is moved into 
+ * the space of the asset, where its direction is normalized again, and its 
+ * interval is scaled to match. The point hit and its normal are moved back 
+ * into the space of the scene.
+ * 
+ * @param ray Ray to test intersection
+ * @param point_hit Point hit by the ray, if intersection is detected
+ * @param normal_hit Normal of the surface at the point that is hit, if intersection is detected
+ * @return Geometry of the asset hit by the ray (NULL if none)
+ */
+Geometry* Instance::computeNearestIntersection(Ray* ray, Point3D* point_hit, Vector3D* normal_hit){
+    Ray* asset_ray = transformRay(ray);
+    
+    Point3D asset_point_hit (0,0,0);
+    Vector3D asset_normal_hit (1,1,1);
+    Geometry* geometry_hit = this->asset_->computeNearestIntersection(asset_ray, &asset_point_hit, &asset_normal_hit);
+    delete asset_ray;
+    
+    if(geometry_hit != NULL){
+        *point_hit = this->transform_.transformPoint(&asset_point_hit);
+        *normal_hit = this->transform_.transformNormal(&asset_normal_hit);
+        normal_hit->normalize();
+    }
+    return geometry_hit;
+}
+
+/**
+ * Computes the axis-aligned box enclosing the placed asset
+ * 
+ * @return Box enclosing the instance
+ */
+BoundingBox Instance::getBounds(){
+    return this->transform_.transformBounds(this->asset_->getBounds());
+}
+
+/**
+ * Checks whether any geometry of the asset reflects
+ * 
+ * @return Boolean indicating presence of reflection in the asset
+ */
+bool Instance::hasReflection(){
+    return this->asset_->hasReflection();
+}
+
+/**
+ * Checks whether any geometry of the asset refracts
+ * 
+ * @return Boolean indicating presence of refraction in the asset
+ */
+bool Instance::hasRefraction(){
+    return this->asset_->hasRefraction();
+}
+
+/**
+ * Gets the asset placed by the instance
+ * 
+ * @return Asset placed by the instance
+ */
+Asset* Instance::getAsset(){
+    return this->asset_;
+}
+
+/**
+ * Gets the transform from the space of the asset to the scene
+ * 
+ * @return Transform of the instance
+ */
+Transform Instance::getTransform(){
+    return this->transform_;
+}
+
+/**
+ * Sets the transform from the space of the asset to the scene
+ * 
+ * @param transform Transform of the instance
+ */
+void Instance::setTransform(Transform transform){
+    markEdited(true);
+    this->transform_ = transform;
+    markEdited(true);
+}
+
+/**
+ * Moves a ray into the space of the asset
+ * 
+ * @param ray Ray in the space of the scene
+ * @return New ray in the space of the asset, with a normalized direction
+ */
+Ray* Instance::transformRay(Ray* ray){
+    Transform inverse = this->transform_.getInverse();
+    Point3D origin = inverse.transformPoint(ray->getOrigin());
+    Vector3D direction = inverse.transformVector(ray->getDirection());
+    
+    //Distances along the ray are scaled along with the direction
+    double scale = direction.magnitude();
+    direction.normalize();
+    
+    Ray* asset_ray = new Ray(new Point3D(origin.getX(), origin.getY(), origin.getZ()), 
+                             new Vector3D(direction.getX(), direction.getY(), direction.getZ()));
+    asset_ray->setInterval(ray->getMinDistance() * scale, ray->getMaxDistance() * scale);
+    return asset_ray;
+}
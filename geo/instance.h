@@ -0,0 +1,62 @@
+// Ray Tracer: instance.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: An Instance places an Asset in the scene with a transform. 
+//                 Rays are moved into the space of the asset to be traced 
+//                 against its shared geometry, so each instance only stores
+//                 its transform. The geometry of the asset that is hit is 
+//                 shaded with its own shader.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+#include "asset.h"
+#include "geometry.h"
+
+#include "../ray.h"
+
+#include "../math/bounding_box.h"
+#include "../math/point3d.h"
+#include "../math/transform.h"
+#include "../math/vector3d.h"
+
+class Instance: public Geometry{
+    public:
+        Instance(Asset* asset, Transform transform);
+        virtual ~Instance();
+        
+        bool hasIntersection(Ray* ray, Point3D* point_hit, Vector3D* normal_hit);
+        Geometry* computeNearestIntersection(Ray* ray, Point3D* point_hit, Vector3D* normal_hit);
+        BoundingBox getBounds();
+        bool hasReflection();
+        bool hasRefraction();
+        
+        Asset* getAsset();
+        Transform getTransform();
+        void setTransform(Transform transform);
+        
+    private:
+        Ray* transformRay(Ray* ray);
+        
+        Asset* asset_;
+        Transform transform_;
+};
+
+#endif /* INSTANCE_H */
@@ -24,6 +24,8 @@
 
 #include "sphere.h"
 
+#define INTERSECTION_EPSILON 1e-9
+
 Sphere::Sphere(){
     this->center_ = new Point3D(0,0,0);
     this->radius_ = 1.0;
@@ -34,6 +36,7 @@ Sphere::Sphere(){
     setSpecularHighlight(RgbColor(0,0,0));
     setPhongConstant(0);
     setReflectiveColor(RgbColor(0,0,0));
+    setTransmissiveColor(RgbColor(0,0,0));
     setRefractionIndex(0.0);
 }
 
@@ -53,7 +56,9 @@ Sphere::~Sphere(){
  * returns only false result 
  * 
  * To test intersection with a sphere, we locate the point along the ray closest
- * to the center of the sphere and compare it with the radius.
+ * to the center of the sphere and compare it with the radius. Rays starting 
+ * inside the sphere (such as refracted rays) hit the far side of the sphere.
+ * Only intersections within the ray's interval are reported.
  * 
  * @param ray Ray to test intersection
  * @param pointHit Point hit by the ray, if intersection is detected
@@ -78,7 +83,9 @@ bool Sphere::hasIntersection(Ray* ray, Point3D* point_hit, Vector3D* normal_hit)
                                     vector_to_sphere_center_z * ray->getDirection()->getZ();
     
     //3. Reject if the Sphere is not in the direction of the Ray (Dot Product is Negative)
-    if(distance_to_test_point < 0){
+    //     unless the Ray starts inside of the Sphere
+    bool origin_inside = distance_to_sphere_center < this->radius_;
+    if(distance_to_test_point < 0 && !origin_inside){
         return false;
     }
     
@@ -101,6 +108,18 @@ bool Sphere::hasIntersection(Ray* ray, Point3D* point_hit, Vector3D* normal_hit)
     //      the distance from the origin to the intersection pt
     double distance_to_intersection = distance_to_test_point - penetration_amount;
     
+    //   If that point is before the start of the Ray, the Ray starts inside the Sphere and leaves through the far side
+    double min_distance = std::max(ray->getMinDistance(), INTERSECTION_EPSILON);
+    if(distance_to_intersection < min_distance){
+        distance_to_intersection = distance_to_test_point + penetration_amount;
+        if(distance_to_intersection < min_distance){
+            return false;
+        }
+    }
+    if(distance_to_intersection > ray->getMaxDistance()){
+        return false;
+    }
+    
     //3. Using parametric coordinates, find the point in 3D space where the sphere was intersected by the ray
     Point3D intersection_point = ray->findPoint(distance_to_intersection);
     
@@ -138,6 +157,16 @@ Vector3D Sphere::getNormalAt(Point3D* intersection_point){
     return normal; 
 }
 
+/**
+ * Computes the axis-aligned box enclosing the sphere
+ * 
+ * @return Box enclosing the sphere
+ */
+BoundingBox Sphere::getBounds(){
+    return BoundingBox(Point3D(this->center_->getX() - this->radius_, this->center_->getY() - this->radius_, this->center_->getZ() - this->radius_),
+                       Point3D(this->center_->getX() + this->radius_, this->center_->getY() + this->radius_, this->center_->getZ() + this->radius_));
+}
+
 /**
  * Get the point where the center of the sphere is located
  * 
@@ -153,7 +182,12 @@ Point3D* Sphere::getCenter(){
  * @param center Point where the sphere will be centered
  */
 void Sphere::setCenter(Point3D* center){
+    markEdited(true);
+    if(this->center_ != center){
+        delete this->center_;
+    }
     this->center_ = center;
+    markEdited(true);
 }
 
 /**
@@ -171,5 +205,7 @@ double Sphere::getRadius(){
  * @param radius Radius to set to the sphere
  */
 void Sphere::setRadius(double radius){
+    markEdited(true);
     this->radius_ = radius;
+    markEdited(true);
 }
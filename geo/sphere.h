@@ -24,6 +24,8 @@
 #ifndef SPHERE_H
 #define	SPHERE_H
 
+#include <algorithm>
+
 #include "geometry.h"
 #include "../shader/phong_shader.h"
 
@@ -35,6 +37,7 @@ class Sphere: public Geometry{
         
         bool hasIntersection(Ray* ray, Point3D* point_hit, Vector3D* normal_hit);
         Vector3D getNormalAt(Point3D* intersection_point);
+        BoundingBox getBounds();
         
         Point3D* getCenter();
         void setCenter(Point3D* center);
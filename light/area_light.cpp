@@ -0,0 +1,145 @@
+// Ray Tracer: area_light.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: An Area Light provides a template for lights cast from a 
+//                  surface rather than a single point. Points spread over 
+//                  the surface are sampled to compute soft shadows. The light
+//                  is cast from the side of the surface facing its normal.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "area_light.h"
+
+AreaLight::AreaLight(){
+    this->color_ = RgbColor(0,0,0);
+    this->center_ = new Point3D(0,0,0);
+    this->normal_ = new Vector3D(0,-1,0);
+    this->falloff_distance_ = 1.0;
+    this->shadow_sample_count_ = DEFAULT_SHADOW_SAMPLE_COUNT;
+}
+
+AreaLight::AreaLight(RgbColor color, Point3D* center, Vector3D* normal){
+    this->color_ = color;
+    this->center_ = center;
+    this->normal_ = normal;
+    this->normal_->normalize();
+    this->falloff_distance_ = 1.0;
+    this->shadow_sample_count_ = DEFAULT_SHADOW_SAMPLE_COUNT;
+}
+
+AreaLight::~AreaLight(){
+    delete this->center_;
+    delete this->normal_;
+}
+
+/**
+ * Gets the normalized direction from the given point to the center of the light
+ * 
+ * @param point Point in 3D space being lit
+ * @return Normalized direction to the center of the light
+ */
+Vector3D AreaLight::getDirectionToLight(Point3D* point){
+    return point->computeDirection(this->center_, true);
+}
+
+/**
+ * Gets the distance from the given point to the center of the light
+ * 
+ * @param point Point in 3D space being lit
+ * @return Distance to the center of the light
+ */
+double AreaLight::getDistanceToLight(Point3D* point){
+    return point->computeDistance(this->center_);
+}
+
+/**
+ * Gets the color of the light cast from a point on the light onto the given
+ * point. The light fades with the angle to the surface of the light and with
+ * the distance (an inverse square falloff). Nothing is cast behind the light.
+ * 
+ * @param light_point Point on the surface of the light
+ * @param point Point in 3D space being lit
+ * @return Color of the light arriving at the point
+ */
+RgbColor AreaLight::getColorFrom(Point3D* light_point, Point3D* point){
+    Vector3D direction_from_light = light_point->computeDirection(point, false);
+    double distance = direction_from_light.magnitude();
+    double cos_angle = direction_from_light.dot(this->normal_) / distance;
+    if(cos_angle <= 0.0){
+        return RgbColor(0,0,0);
+    }
+    
+    double scaled_distance = distance / this->falloff_distance_;
+    return this->color_ * (cos_angle / (1 + scaled_distance * scaled_distance));
+}
+
+/**
+ * Gets the center of the surface of the light
+ * 
+ * @return Pointer to the center of the light
+ */
+Point3D* AreaLight::getCenter(){
+    return this->center_;
+}
+
+/**
+ * Gets the normal of the surface of the light, pointing to the lit side
+ * 
+ * @return Pointer to the normal of the light
+ */
+Vector3D* AreaLight::getNormal(){
+    return this->normal_;
+}
+
+/**
+ * Sets the distance at which the light has faded to half of its color
+ * 
+ * @param falloff_distance Distance at which the light is at half its color
+ */
+void AreaLight::setFalloffDistance(double falloff_distance){
+    this->falloff_distance_ = falloff_distance;
+}
+
+/**
+ * Gets the distance at which the light has faded to half of its color
+ * 
+ * @return Distance at which the light is at half its color
+ */
+double AreaLight::getFalloffDistance(){
+    return this->falloff_distance_;
+}
+
+/**
+ * Sets the largest number of shadow rays cast towards the light from a single
+ * point. Only points in the penumbra use the full number, points that are 
+ * fully lit or fully in shadow stop after the first four.
+ * 
+ * @param shadow_sample_count Largest number of shadow rays per point
+ */
+void AreaLight::setShadowSampleCount(int shadow_sample_count){
+    this->shadow_sample_count_ = shadow_sample_count;
+}
+
+/**
+ * Gets the largest number of shadow rays cast towards the light from a single point
+ * 
+ * @return Largest number of shadow rays per point
+ */
+int AreaLight::getShadowSampleCount(){
+    return this->shadow_sample_count_;
+}
@@ -0,0 +1,61 @@
+// Ray Tracer: area_light.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: An Area Light provides a template for lights cast from a 
+//                  surface rather than a single point. Points spread over 
+//                  the surface are sampled to compute soft shadows. The light
+//                  is cast from the side of the surface facing its normal.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef AREA_LIGHT_H
+#define AREA_LIGHT_H
+
+#include "light.h"
+#include "../math/point3d.h"
+#include "../math/rgb_color.h"
+#include "../math/vector3d.h"
+
+#define DEFAULT_SHADOW_SAMPLE_COUNT 16
+
+class AreaLight : public Light {
+public:
+    AreaLight();
+    AreaLight(RgbColor color, Point3D* center, Vector3D* normal);
+    virtual ~AreaLight();
+    
+    virtual Point3D samplePoint(double u, double v) = 0;
+    Vector3D getDirectionToLight(Point3D* point);
+    double getDistanceToLight(Point3D* point);
+    RgbColor getColorFrom(Point3D* light_point, Point3D* point);
+    
+    Point3D* getCenter();
+    Vector3D* getNormal();
+    void setFalloffDistance(double falloff_distance);
+    double getFalloffDistance();
+    void setShadowSampleCount(int shadow_sample_count);
+    int getShadowSampleCount();
+    
+protected:
+    Point3D* center_;
+    Vector3D* normal_;
+    double falloff_distance_;
+    int shadow_sample_count_;
+};
+
+#endif /* AREA_LIGHT_H */
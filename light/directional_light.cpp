@@ -45,6 +45,10 @@ DirectionalLight::~DirectionalLight(){
  * 
  * 0: Ambient
  * 1: Directional
+ * 2: Point
+ * 3: Spot
+ * 4: Rectangle
+ * 5: Disc
  * 
  * @return The flag defining the light as a directional type (1)
  */
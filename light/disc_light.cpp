@@ -0,0 +1,101 @@
+// Ray Tracer: disc_light.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Disc Light is an Area Light cast from a disc defined by 
+//                  its center, normal and radius.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "disc_light.h"
+
+DiscLight::DiscLight(){
+    this->radius_ = 1.0;
+    computeTangents();
+}
+
+/**
+ * Creates a disc light
+ * 
+ * @param color Color of the light
+ * @param center Center of the disc
+ * @param normal Normal of the disc, pointing to the lit side
+ * @param radius Radius of the disc
+ */
+DiscLight::DiscLight(RgbColor color, Point3D* center, Vector3D* normal, double radius)
+    : AreaLight(color, center, normal){
+    this->radius_ = radius;
+    computeTangents();
+}
+
+DiscLight::~DiscLight(){}
+
+/**
+ * Returns an integer flag defining the type of light.
+ * 
+ * Light Flag List (2/2/2016)
+ * 
+ * 0: Ambient
+ * 1: Directional
+ * 2: Point
+ * 3: Spot
+ * 4: Rectangle
+ * 5: Disc
+ * 
+ * @return The flag defining the light as a disc type (5)
+ */
+int DiscLight::getType(){
+    return 5;
+}
+
+/**
+ * Maps a point in the unit square to a point on the disc. The concentric 
+ * mapping keeps stratified samples stratified on the disc.
+ * 
+ * @param u First coordinate in the unit square (0-1)
+ * @param v Second coordinate in the unit square (0-1)
+ * @return Point on the surface of the light
+ */
+Point3D DiscLight::samplePoint(double u, double v){
+    double disc_x, disc_y;
+    Sampler::mapToDisk(u, v, disc_x, disc_y);
+    Vector3D offset = (this->tangent_u_ * (disc_x * this->radius_)) + (this->tangent_v_ * (disc_y * this->radius_));
+    return this->center_->translate(&offset);
+}
+
+/**
+ * Gets the radius of the disc
+ * 
+ * @return Radius of the disc
+ */
+double DiscLight::getRadius(){
+    return this->radius_;
+}
+
+/**
+ * Computes two perpendicular directions spanning the plane of the disc
+ */
+void DiscLight::computeTangents(){
+    //Start from the axis least aligned with the normal to avoid a degenerate cross product
+    Vector3D axis(1,0,0);
+    if(std::abs(this->normal_->getX()) > 0.9){
+        axis = Vector3D(0,1,0);
+    }
+    this->tangent_u_ = this->normal_->crossProd(&axis);
+    this->tangent_u_.normalize();
+    this->tangent_v_ = this->normal_->crossProd(&this->tangent_u_);
+}
@@ -0,0 +1,50 @@
+// Ray Tracer: disc_light.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Disc Light is an Area Light cast from a disc defined by 
+//                  its center, normal and radius.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef DISC_LIGHT_H
+#define DISC_LIGHT_H
+
+#include <cmath>
+
+#include "area_light.h"
+#include "../math/sampler.h"
+
+class DiscLight : public AreaLight {
+public:
+    DiscLight();
+    DiscLight(RgbColor color, Point3D* center, Vector3D* normal, double radius);
+    virtual ~DiscLight();
+    
+    int getType();
+    Point3D samplePoint(double u, double v);
+    double getRadius();
+    
+private:
+    void computeTangents();
+    
+    double radius_;
+    Vector3D tangent_u_;
+    Vector3D tangent_v_;
+};
+
+#endif /* DISC_LIGHT_H */
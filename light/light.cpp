@@ -60,4 +60,39 @@ Vector3D* Light::getDirectionFromLight(){
  */
 Vector3D Light::getDirectionToLight(){
     return Vector3D(0,0,0);
-}
\ No newline at end of file
+}
+
+/**
+ * Gets the normalized direction from the given point to the light.
+ * Unless overridden, the direction is the same for every point.
+ * 
+ * @param point Point in 3D space being lit
+ * @return Normalized direction to the light
+ */
+Vector3D Light::getDirectionToLight(Point3D* point){
+    Vector3D direction_to_light = getDirectionToLight();
+    direction_to_light.normalize();
+    return direction_to_light;
+}
+
+/**
+ * Gets the distance from the given point to the light. Unless overridden, 
+ * the light is infinitely far away.
+ * 
+ * @param point Point in 3D space being lit
+ * @return Distance to the light
+ */
+double Light::getDistanceToLight(Point3D* point){
+    return INFINITY;
+}
+
+/**
+ * Gets the color of the light arriving at the given point. Unless overridden,
+ * the light arrives with its full color everywhere.
+ * 
+ * @param point Point in 3D space being lit
+ * @return Color of the light arriving at the point
+ */
+RgbColor Light::getColorAt(Point3D* point){
+    return this->color_;
+}
@@ -24,6 +24,9 @@
 #ifndef LIGHT_H
 #define	LIGHT_H
 
+#include <cmath>
+
+#include "../math/point3d.h"
 #include "../math/rgb_color.h"
 #include "../math/vector3d.h"
 
@@ -37,9 +40,16 @@ public:
     
     //0: Ambient
     //1: Directional
+    //2: Point
+    //3: Spot
+    //4: Rectangle
+    //5: Disc
     virtual int getType() = 0;
     virtual Vector3D* getDirectionFromLight();
     virtual Vector3D getDirectionToLight();
+    virtual Vector3D getDirectionToLight(Point3D* point);
+    virtual double getDistanceToLight(Point3D* point);
+    virtual RgbColor getColorAt(Point3D* point);
     
 protected:
     RgbColor color_;
@@ -0,0 +1,302 @@
+// Ray Tracer: light_bvh.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Light BVH sorts the bounded lights of a scene into a 
+//                  hierarchy of boxes enclosing their spheres of influence,
+//                  so the lights that can reach a point are found without
+//                  testing every light in the scene. The hierarchy also
+//                  stores the power of the lights below each node so a 
+//                  light can be picked in proportion to its estimated
+//                  contribution to a point.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "light_bvh.h"
+
+//Orders lights by the position of their centers along one axis
+struct LightAxisOrder {
+    int axis;
+    
+    bool operator()(PointLight* a, PointLight* b) const {
+        switch(axis){
+            case 0: return a->getPosition()->getX() < b->getPosition()->getX();
+            case 1: return a->getPosition()->getY() < b->getPosition()->getY();
+            default: return a->getPosition()->getZ() < b->getPosition()->getZ();
+        }
+    }
+};
+
+/**
+ * Builds the hierarchy over the given lights. The hierarchy does not take 
+ * ownership of the lights.
+ * 
+ * @param lights Bounded lights to sort into the hierarchy
+ */
+LightBvh::LightBvh(std::vector<PointLight*> lights){
+    this->lights_ = lights;
+    if(!this->lights_.empty()){
+        this->nodes_.reserve(2 * this->lights_.size() / LIGHT_BVH_LEAF_SIZE + 1);
+        build(0, this->lights_.size());
+    }
+}
+
+LightBvh::~LightBvh(){}
+
+/**
+ * Collects every light whose sphere of influence contains the given point.
+ * Branches of the hierarchy whose box does not contain the point are skipped.
+ * 
+ * @param point Point in 3D space being lit
+ * @param lights_in_range List to append the lights that reach the point to
+ */
+void LightBvh::query(Point3D* point, std::vector<PointLight*>* lights_in_range){
+    if(this->nodes_.empty()){
+        return;
+    }
+    
+    int stack[64];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    
+    while(stack_size > 0){
+        int node_index = stack[--stack_size];
+        LightBvhNode* node = &this->nodes_[node_index];
+        if(!node->bounds.contains(point)){
+            continue;
+        }
+        
+        if(node->light_count > 0){
+            for (int i = node->first_light_index; i < node->first_light_index + node->light_count; i++) {
+                PointLight* light = this->lights_[i];
+                if(point->computeDistance(light->getPosition()) < light->getInfluenceRadius()){
+                    lights_in_range->push_back(light);
+                }
+            }
+        } else {
+            stack[stack_size++] = node->second_child_index;
+            stack[stack_size++] = node_index + 1;
+        }
+    }
+}
+
+/**
+ * Picks a single light in proportion to its estimated contribution to the 
+ * given point. Starting at the root, one of the two children is chosen in 
+ * proportion to their importance until a leaf is reached, where a light is
+ * chosen in proportion to the unshadowed light it casts on the surface. 
+ * Dividing the contribution of the light by the returned probability gives
+ * an estimate of the sum over all lights. Every light that can light the 
+ * point has a chance of being picked.
+ * 
+ * @param point Point in 3D space being lit
+ * @param normal Normal of the surface at the point
+ * @param u Uniformly distributed number (0-1) deciding the light picked
+ * @param pdf Resulting probability of the light having been picked
+ * @return Light picked, or NULL if no light can light the point
+ */
+PointLight* LightBvh::sample(Point3D* point, Vector3D* normal, double u, double &pdf){
+    pdf = 0.0;
+    if(this->nodes_.empty() || computeImportance(&this->nodes_[0], point, normal) <= 0.0){
+        return NULL;
+    }
+    
+    pdf = 1.0;
+    int node_index = 0;
+    while(this->nodes_[node_index].light_count == 0){
+        int second_child_index = this->nodes_[node_index].second_child_index;
+        double first_importance = computeImportance(&this->nodes_[node_index + 1], point, normal);
+        double second_importance = computeImportance(&this->nodes_[second_child_index], point, normal);
+        double total_importance = first_importance + second_importance;
+        if(total_importance <= 0.0){
+            pdf = 0.0;
+            return NULL;
+        }
+        
+        //Reuse the number for the next choice by rescaling the chosen part to (0-1)
+        double first_probability = first_importance / total_importance;
+        if(u < first_probability){
+            u = u / first_probability;
+            pdf *= first_probability;
+            node_index = node_index + 1;
+        } else {
+            u = (u - first_probability) / (1.0 - first_probability);
+            pdf *= 1.0 - first_probability;
+            node_index = second_child_index;
+        }
+    }
+    
+    LightBvhNode* leaf = &this->nodes_[node_index];
+    double importance[LIGHT_BVH_LEAF_SIZE];
+    double total_importance = 0.0;
+    for (int i = 0; i < leaf->light_count; i++) {
+        importance[i] = computeImportance(this->lights_[leaf->first_light_index + i], point, normal);
+        total_importance += importance[i];
+    }
+    if(total_importance <= 0.0){
+        pdf = 0.0;
+        return NULL;
+    }
+    
+    double threshold = u * total_importance;
+    int chosen = leaf->light_count - 1;
+    for (int i = 0; i < leaf->light_count; i++) {
+        if(importance[i] > 0.0 && threshold < importance[i]){
+            chosen = i;
+            break;
+        }
+        threshold -= importance[i];
+    }
+    //Rounding may step past the last light that can light the point
+    while(importance[chosen] <= 0.0){
+        chosen--;
+    }
+    
+    pdf *= importance[chosen] / total_importance;
+    return this->lights_[leaf->first_light_index + chosen];
+}
+
+/**
+ * Gets the amount of lights sorted into the hierarchy
+ * 
+ * @return Amount of lights in the hierarchy
+ */
+int LightBvh::getLightCount(){
+    return this->lights_.size();
+}
+
+/**
+ * Gets the amount of nodes in the hierarchy
+ * 
+ * @return Amount of nodes in the hierarchy
+ */
+int LightBvh::getNodeCount(){
+    return this->nodes_.size();
+}
+
+/**
+ * Recursively builds the node enclosing the given range of lights. The range
+ * is split at the median light center along the longest axis of the box 
+ * enclosing the centers, which keeps the hierarchy balanced.
+ * 
+ * @param begin Index of the first light in the range
+ * @param end Index after the last light in the range
+ * @return Index of the node built
+ */
+int LightBvh::build(int begin, int end){
+    int node_index = this->nodes_.size();
+    this->nodes_.push_back(LightBvhNode());
+    
+    BoundingBox bounds;
+    BoundingBox center_bounds;
+    double power = 0.0;
+    for (int i = begin; i < end; i++) {
+        bounds.expand(this->lights_[i]->getBounds());
+        center_bounds.expand(*this->lights_[i]->getPosition());
+        power += this->lights_[i]->getColor().getMaxComponent();
+    }
+    
+    this->nodes_[node_index].bounds = bounds;
+    this->nodes_[node_index].power = power;
+    if(end - begin <= LIGHT_BVH_LEAF_SIZE){
+        this->nodes_[node_index].first_light_index = begin;
+        this->nodes_[node_index].light_count = end - begin;
+        this->nodes_[node_index].second_child_index = -1;
+        return node_index;
+    }
+    
+    double extent_x = center_bounds.getMax().getX() - center_bounds.getMin().getX();
+    double extent_y = center_bounds.getMax().getY() - center_bounds.getMin().getY();
+    double extent_z = center_bounds.getMax().getZ() - center_bounds.getMin().getZ();
+    
+    LightAxisOrder order;
+    order.axis = 2;
+    if(extent_x >= extent_y && extent_x >= extent_z){
+        order.axis = 0;
+    } else if(extent_y >= extent_z){
+        order.axis = 1;
+    }
+    
+    int middle = (begin + end) / 2;
+    std::nth_element(this->lights_.begin() + begin, this->lights_.begin() + middle, this->lights_.begin() + end, order);
+    
+    build(begin, middle);
+    int second_child_index = build(middle, end);
+    
+    //The node list may have been reallocated while building the children
+    this->nodes_[node_index].first_light_index = begin;
+    this->nodes_[node_index].light_count = 0;
+    this->nodes_[node_index].second_child_index = second_child_index;
+    
+    return node_index;
+}
+
+/**
+ * Estimates how much the lights below a node contribute to the given point:
+ * their power divided by the squared distance to the center of the node. The 
+ * distance is not allowed to fall below half the size of the node, as the 
+ * lights may be spread anywhere inside it. Nodes whose box does not contain 
+ * the point, or lies entirely behind the surface, cannot light the point.
+ * 
+ * @param node Node of the hierarchy
+ * @param point Point in 3D space being lit
+ * @param normal Normal of the surface at the point
+ * @return Importance of the node (0 if it cannot light the point)
+ */
+double LightBvh::computeImportance(LightBvhNode* node, Point3D* point, Vector3D* normal){
+    if(!node->bounds.contains(point)){
+        return 0.0;
+    }
+    
+    bool in_front = false;
+    for (int i = 0; i < 8 && !in_front; i++) {
+        Point3D corner = node->bounds.getCorner(i);
+        Vector3D direction_to_corner = point->computeDirection(&corner, false);
+        in_front = normal->dot(&direction_to_corner) > 0.0;
+    }
+    if(!in_front){
+        return 0.0;
+    }
+    
+    Point3D center = node->bounds.getCenter();
+    Point3D min_corner = node->bounds.getMin();
+    Point3D max_corner = node->bounds.getMax();
+    double distance = point->computeDistance(&center);
+    double half_size = 0.5 * min_corner.computeDistance(&max_corner);
+    double clamped_distance = std::max(distance, half_size);
+    
+    return node->power / (clamped_distance * clamped_distance);
+}
+
+/**
+ * Estimates how much a single light contributes to the given point from the
+ * unshadowed light it casts on the surface
+ * 
+ * @param light Light lighting the point
+ * @param point Point in 3D space being lit
+ * @param normal Normal of the surface at the point
+ * @return Importance of the light (0 if it cannot light the point)
+ */
+double LightBvh::computeImportance(PointLight* light, Point3D* point, Vector3D* normal){
+    Vector3D direction_to_light = light->getDirectionToLight(point);
+    double cos_angle = normal->dot(&direction_to_light);
+    if(cos_angle <= 0.0){
+        return 0.0;
+    }
+    
+    return light->getColorAt(point).getMaxComponent() * cos_angle;
+}
@@ -0,0 +1,72 @@
+// Ray Tracer: light_bvh.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Light BVH sorts the bounded lights of a scene into a 
+//                  hierarchy of boxes enclosing their spheres of influence,
+//                  so the lights that can reach a point are found without
+//                  testing every light in the scene. The hierarchy also
+//                  stores the power of the lights below each node so a 
+//                  light can be picked in proportion to its estimated
+//                  contribution to a point.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef LIGHT_BVH_H
+#define LIGHT_BVH_H
+
+#include <algorithm>
+#include <vector>
+
+#include "point_light.h"
+
+#include "../math/bounding_box.h"
+#include "../math/point3d.h"
+#include "../math/vector3d.h"
+
+#define LIGHT_BVH_LEAF_SIZE 4
+
+//A node of the flattened hierarchy. The first child of an interior node 
+//directly follows it, the second child is found at second_child_index.
+struct LightBvhNode {
+    BoundingBox bounds;
+    double power;
+    int first_light_index;
+    int light_count;
+    int second_child_index;
+};
+
+class LightBvh {
+public:
+    LightBvh(std::vector<PointLight*> lights);
+    virtual ~LightBvh();
+    
+    void query(Point3D* point, std::vector<PointLight*>* lights_in_range);
+    PointLight* sample(Point3D* point, Vector3D* normal, double u, double &pdf);
+    int getLightCount();
+    int getNodeCount();
+    
+private:
+    int build(int begin, int end);
+    double computeImportance(LightBvhNode* node, Point3D* point, Vector3D* normal);
+    double computeImportance(PointLight* light, Point3D* point, Vector3D* normal);
+    
+    std::vector<PointLight*> lights_;
+    std::vector<LightBvhNode> nodes_;
+};
+
+#endif /* LIGHT_BVH_H */
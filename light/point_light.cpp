@@ -0,0 +1,160 @@
+// Ray Tracer: point_light.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Point Light casts light in every direction from a single 
+//                  point. The light fades with distance and reaches nothing
+//                  beyond its radius of influence. Light from a Point Light
+//                  can be obscured by geometry.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "point_light.h"
+
+PointLight::PointLight(){
+    this->color_ = RgbColor(0,0,0);
+    this->position_ = new Point3D(0,0,0);
+    this->influence_radius_ = 1.0;
+    this->falloff_distance_ = 1.0;
+}
+
+PointLight::PointLight(RgbColor color, Point3D* position, double influence_radius){
+    this->color_ = color;
+    this->position_ = position;
+    this->influence_radius_ = influence_radius;
+    this->falloff_distance_ = 1.0;
+}
+
+PointLight::~PointLight(){
+    delete this->position_;
+}
+
+/**
+ * Returns an integer flag defining the type of light.
+ * 
+ * Light Flag List (2/2/2016)
+ * 
+ * 0: Ambient
+ * 1: Directional
+ * 2: Point
+ * 3: Spot
+ * 4: Rectangle
+ * 5: Disc
+ * 
+ * @return The flag defining the light as a point type (2)
+ */
+int PointLight::getType(){
+    return 2;
+}
+
+/**
+ * Gets the normalized direction from the given point to the light
+ * 
+ * @param point Point in 3D space being lit
+ * @return Normalized direction to the light
+ */
+Vector3D PointLight::getDirectionToLight(Point3D* point){
+    return point->computeDirection(this->position_, true);
+}
+
+/**
+ * Gets the distance from the given point to the light
+ * 
+ * @param point Point in 3D space being lit
+ * @return Distance to the light
+ */
+double PointLight::getDistanceToLight(Point3D* point){
+    return point->computeDistance(this->position_);
+}
+
+/**
+ * Gets the color of the light arriving at the given point after falloff
+ * 
+ * @param point Point in 3D space being lit
+ * @return Color of the light arriving at the point
+ */
+RgbColor PointLight::getColorAt(Point3D* point){
+    return this->color_ * computeFalloff(getDistanceToLight(point));
+}
+
+/**
+ * Gets the position of the light
+ * 
+ * @return Pointer to the position of the light
+ */
+Point3D* PointLight::getPosition(){
+    return this->position_;
+}
+
+/**
+ * Gets the distance beyond which the light reaches nothing
+ * 
+ * @return Radius of influence of the light
+ */
+double PointLight::getInfluenceRadius(){
+    return this->influence_radius_;
+}
+
+/**
+ * Sets the distance at which the light has faded to half of its color
+ * (before the fade at the edge of the radius of influence is applied)
+ * 
+ * @param falloff_distance Distance at which the light is at half its color
+ */
+void PointLight::setFalloffDistance(double falloff_distance){
+    this->falloff_distance_ = falloff_distance;
+}
+
+/**
+ * Gets the distance at which the light has faded to half of its color
+ * 
+ * @return Distance at which the light is at half its color
+ */
+double PointLight::getFalloffDistance(){
+    return this->falloff_distance_;
+}
+
+/**
+ * Computes the box enclosing the sphere of influence of the light
+ * 
+ * @return Box enclosing everything the light can reach
+ */
+BoundingBox PointLight::getBounds(){
+    return BoundingBox(Point3D(this->position_->getX() - this->influence_radius_, this->position_->getY() - this->influence_radius_, this->position_->getZ() - this->influence_radius_),
+                       Point3D(this->position_->getX() + this->influence_radius_, this->position_->getY() + this->influence_radius_, this->position_->getZ() + this->influence_radius_));
+}
+
+/**
+ * Computes the fraction of the light's color remaining at the given distance.
+ * The light follows an inverse square falloff, multiplied by a window that
+ * smoothly brings it to zero at the radius of influence so that lights can
+ * be skipped beyond it without a visible edge.
+ * 
+ * @param distance Distance from the light
+ * @return Fraction of the light's color remaining (0-1)
+ */
+double PointLight::computeFalloff(double distance){
+    if(distance >= this->influence_radius_){
+        return 0.0;
+    }
+    
+    double relative_distance = distance / this->influence_radius_;
+    double window = 1 - relative_distance * relative_distance * relative_distance * relative_distance;
+    double scaled_distance = distance / this->falloff_distance_;
+    
+    return (window * window) / (1 + scaled_distance * scaled_distance);
+}
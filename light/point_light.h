@@ -0,0 +1,63 @@
+// Ray Tracer: point_light.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Point Light casts light in every direction from a single 
+//                  point. The light fades with distance and reaches nothing
+//                  beyond its radius of influence. Light from a Point Light
+//                  can be obscured by geometry.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef POINT_LIGHT_H
+#define POINT_LIGHT_H
+
+#include <algorithm>
+#include <cmath>
+
+#include "light.h"
+#include "../math/bounding_box.h"
+#include "../math/point3d.h"
+#include "../math/rgb_color.h"
+#include "../math/vector3d.h"
+
+class PointLight : public Light {
+public:
+    PointLight();
+    PointLight(RgbColor color, Point3D* position, double influence_radius);
+    virtual ~PointLight();
+    
+    int getType();
+    Vector3D getDirectionToLight(Point3D* point);
+    double getDistanceToLight(Point3D* point);
+    RgbColor getColorAt(Point3D* point);
+    
+    Point3D* getPosition();
+    double getInfluenceRadius();
+    void setFalloffDistance(double falloff_distance);
+    double getFalloffDistance();
+    BoundingBox getBounds();
+    
+protected:
+    double computeFalloff(double distance);
+    
+    Point3D* position_;
+    double influence_radius_;
+    double falloff_distance_;
+};
+
+#endif /* POINT_LIGHT_H */
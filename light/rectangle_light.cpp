@@ -0,0 +1,80 @@
+// Ray Tracer: rectangle_light.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Rectangle Light is an Area Light cast from a rectangle
+//                  defined by its center and two perpendicular edges. The 
+//                  light is cast to the side the cross product of the edges
+//                  points to.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "rectangle_light.h"
+
+RectangleLight::RectangleLight(){
+    this->edge_u_ = new Vector3D(1,0,0);
+    this->edge_v_ = new Vector3D(0,0,1);
+}
+
+/**
+ * Creates a rectangle light
+ * 
+ * @param color Color of the light
+ * @param center Center of the rectangle
+ * @param edge_u First edge of the rectangle
+ * @param edge_v Second edge of the rectangle
+ */
+RectangleLight::RectangleLight(RgbColor color, Point3D* center, Vector3D* edge_u, Vector3D* edge_v)
+    : AreaLight(color, center, new Vector3D(edge_u->crossProd(edge_v))){
+    this->edge_u_ = edge_u;
+    this->edge_v_ = edge_v;
+}
+
+RectangleLight::~RectangleLight(){
+    delete this->edge_u_;
+    delete this->edge_v_;
+}
+
+/**
+ * Returns an integer flag defining the type of light.
+ * 
+ * Light Flag List (2/2/2016)
+ * 
+ * 0: Ambient
+ * 1: Directional
+ * 2: Point
+ * 3: Spot
+ * 4: Rectangle
+ * 5: Disc
+ * 
+ * @return The flag defining the light as a rectangle type (4)
+ */
+int RectangleLight::getType(){
+    return 4;
+}
+
+/**
+ * Maps a point in the unit square to a point on the rectangle
+ * 
+ * @param u Position along the first edge (0-1)
+ * @param v Position along the second edge (0-1)
+ * @return Point on the surface of the light
+ */
+Point3D RectangleLight::samplePoint(double u, double v){
+    Vector3D offset = (*this->edge_u_ * (u - 0.5)) + (*this->edge_v_ * (v - 0.5));
+    return this->center_->translate(&offset);
+}
@@ -0,0 +1,45 @@
+// Ray Tracer: rectangle_light.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Rectangle Light is an Area Light cast from a rectangle
+//                  defined by its center and two perpendicular edges. The 
+//                  light is cast to the side the cross product of the edges
+//                  points to.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef RECTANGLE_LIGHT_H
+#define RECTANGLE_LIGHT_H
+
+#include "area_light.h"
+
+class RectangleLight : public AreaLight {
+public:
+    RectangleLight();
+    RectangleLight(RgbColor color, Point3D* center, Vector3D* edge_u, Vector3D* edge_v);
+    virtual ~RectangleLight();
+    
+    int getType();
+    Point3D samplePoint(double u, double v);
+    
+private:
+    Vector3D* edge_u_;
+    Vector3D* edge_v_;
+};
+
+#endif /* RECTANGLE_LIGHT_H */
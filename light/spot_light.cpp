@@ -0,0 +1,105 @@
+// Ray Tracer: spot_light.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Spot Light is a Point Light that only casts light inside a 
+//                  cone around its direction. The light is at full strength 
+//                  inside the inner angle of the cone and fades out towards 
+//                  the outer angle.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "spot_light.h"
+
+SpotLight::SpotLight(){
+    this->direction_from_light_ = new Vector3D(0,0,-1);
+    this->cos_inner_angle_ = cos(30 * (M_PI/180));
+    this->cos_outer_angle_ = cos(45 * (M_PI/180));
+}
+
+/**
+ * Creates a spot light. The angles are measured in degrees between 
+ * the direction of the light and the edge of the cone.
+ * 
+ * @param color Color of the light
+ * @param position Position of the light
+ * @param direction Direction the light is cast in
+ * @param influence_radius Distance beyond which the light reaches nothing
+ * @param inner_angle Angle of the cone lit at full strength
+ * @param outer_angle Angle of the cone beyond which nothing is lit
+ */
+SpotLight::SpotLight(RgbColor color, Point3D* position, Vector3D* direction, double influence_radius, double inner_angle, double outer_angle)
+    : PointLight(color, position, influence_radius){
+    this->direction_from_light_ = direction;
+    this->direction_from_light_->normalize();
+    this->cos_inner_angle_ = cos(inner_angle * (M_PI/180));
+    this->cos_outer_angle_ = cos(outer_angle * (M_PI/180));
+}
+
+SpotLight::~SpotLight(){
+    delete this->direction_from_light_;
+}
+
+/**
+ * Returns an integer flag defining the type of light.
+ * 
+ * Light Flag List (2/2/2016)
+ * 
+ * 0: Ambient
+ * 1: Directional
+ * 2: Point
+ * 3: Spot
+ * 4: Rectangle
+ * 5: Disc
+ * 
+ * @return The flag defining the light as a spot type (3)
+ */
+int SpotLight::getType(){
+    return 3;
+}
+
+/**
+ * Gets the direction the light is being cast in
+ * 
+ * @return Direction the light is being cast in
+ */
+Vector3D* SpotLight::getDirectionFromLight(){
+    return this->direction_from_light_;
+}
+
+/**
+ * Gets the color of the light arriving at the given point after falloff and
+ * after fading between the inner and outer angle of the cone
+ * 
+ * @param point Point in 3D space being lit
+ * @return Color of the light arriving at the point
+ */
+RgbColor SpotLight::getColorAt(Point3D* point){
+    Vector3D direction_from_light = this->position_->computeDirection(point, true);
+    double cos_angle = direction_from_light.dot(this->direction_from_light_);
+    if(cos_angle <= this->cos_outer_angle_){
+        return RgbColor(0,0,0);
+    }
+    
+    double cone_fade = 1.0;
+    if(cos_angle < this->cos_inner_angle_){
+        double t = (cos_angle - this->cos_outer_angle_) / (this->cos_inner_angle_ - this->cos_outer_angle_);
+        cone_fade = t * t * (3 - 2 * t);
+    }
+    
+    return PointLight::getColorAt(point) * cone_fade;
+}
@@ -0,0 +1,47 @@
+// Ray Tracer: spot_light.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Spot Light is a Point Light that only casts light inside a 
+//                  cone around its direction. The light is at full strength 
+//                  inside the inner angle of the cone and fades out towards 
+//                  the outer angle.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef SPOT_LIGHT_H
+#define SPOT_LIGHT_H
+
+#include "point_light.h"
+
+class SpotLight : public PointLight {
+public:
+    SpotLight();
+    SpotLight(RgbColor color, Point3D* position, Vector3D* direction, double influence_radius, double inner_angle, double outer_angle);
+    virtual ~SpotLight();
+    
+    int getType();
+    Vector3D* getDirectionFromLight();
+    RgbColor getColorAt(Point3D* point);
+    
+private:
+    Vector3D* direction_from_light_;
+    double cos_inner_angle_;
+    double cos_outer_angle_;
+};
+
+#endif /* SPOT_LIGHT_H */
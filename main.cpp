@@ -20,14 +20,35 @@
 // A full copy of the GNU General Public License may be found at
 // <http://www.gnu.org/licenses/>.
 
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include <unistd.h>
+
 #include "scene.h"
 #include "ray_tracer.h"
+#include "animation.h"
 
+#include "file_writer/binary_ppm_writer.h"
+#include "file_writer/mapped_ppm_writer.h"
+#include "file_writer/pfm_writer.h"
 #include "file_writer/ppm_writer.h"
+#include "file_writer/stream_writer.h"
+
+#include "service/farm_coordinator.h"
+#include "service/farm_worker.h"
+#include "service/render_client.h"
+#include "service/render_service.h"
 
 #include "geo/sphere.h"
 
@@ -120,12 +141,337 @@ void addCamera(Scene* scene){
     Camera* camera = new Camera();
     camera->setResolution(512, 512);
     camera->setOrigin(new Point3D(0,0,1));
+    camera->setLookAt(new Point3D(0,0,0));
     camera->setFocalParams(28.0, false);
     camera->setDistToImagePlane(1);
     scene->setCamera(camera);
 }
 
+/**
+ * Adds key frames moving the scene of addGeometry and addCamera
+ * 
+ * Animation Description (10/19/2016)
+ * 
+ * Frames 0-47: The camera swings from (0, 0, 1) to (0.5, 0.25, 0.9), still
+ *       aimed at (0, 0, 0)
+ * Frames 0-47: Sphere 2 (red) moves from (0.2, 0, -0.1) to (0.2, 0.3, 0.1)
+ * 
+ * @param scene Pointer to the scene description to animate
+ * @param animation Pointer to the animation to be appended to
+ */
+void addAnimation(Scene* scene, Animation* animation){
+    animation->addCameraKey(0, Point3D(0,0,1), Point3D(0,0,0));
+    animation->addCameraKey(47, Point3D(0.5,0.25,0.9), Point3D(0,0,0));
+    
+    Sphere* sphere2 = static_cast<Sphere*>(scene->getGeoAt(1));
+    animation->addCenterKey(sphere2, 0, Point3D(0.2, 0, -0.1));
+    animation->addCenterKey(sphere2, 47, Point3D(0.2, 0.3, 0.1));
+}
+
+/**
+ * Measures the frames per second a stream writer sustains through a pipe. 
+ * A reader thread drains the other end of the pipe, as an encoder would, and
+ * checks that every byte arrives.
+ * 
+ * @param frame_count Amount of frames to stream
+ * @param width Width of each frame in pixels
+ * @param height Height of each frame in pixels
+ * @return 0 if every frame went through the pipe, 1 otherwise
+ */
+int benchmarkStream(int frame_count, int width, int height){
+    FrameBuffer frame_buffer(width, height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            frame_buffer.setPixel(x, y, RgbColor(255.0 * x / width, 255.0 * y / height, 128));
+        }
+    }
+    
+    int pipe_descriptors[2];
+    if(pipe(pipe_descriptors) != 0){
+        cerr << "Error (StreamWriter): Could not create a pipe." << endl;
+        return 1;
+    }
+    
+    long long bytes_read = 0;
+    std::thread reader([&bytes_read, &pipe_descriptors](){
+        std::vector<char> buffer(1 << 20);
+        ssize_t result;
+        while((result = read(pipe_descriptors[0], &buffer[0], buffer.size())) != 0){
+            if(result > 0){
+                bytes_read += result;
+            }
+        }
+    });
+    
+    StreamWriter stream_writer(pipe_descriptors[1]);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    stream_writer.init();
+    for (int frame = 0; frame < frame_count; frame++) {
+        stream_writer.defineHeaders(width, height, 255);
+        stream_writer.addFrameBuffer(&frame_buffer);
+        stream_writer.close();
+    }
+    close(pipe_descriptors[1]);
+    reader.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    close(pipe_descriptors[0]);
+    
+    long long expected_bytes = (long long)frame_count * width * height * 3;
+    cout << "Streamed " << frame_count << " frames of " << width << "x" << height << " in " << seconds << " s: " 
+         << frame_count / seconds << " frames/s, " << bytes_read / seconds / (1 << 20) << " MB/s" << endl;
+    if(bytes_read != expected_bytes){
+        cout << "Error (StreamWriter): " << bytes_read << " bytes read, " << expected_bytes << " expected." << endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Measures each acceleration structure against the binary bounding volume
+ * hierarchy, whose uncompressed layout the compressed hierarchy is meant to
+ * shrink: its build time, its memory and the rays per second it traces,
+ * both for the nearest intersection and for any intersection (as a shadow
+ * ray does). The scene is made of equal spheres spread at random over 
+ * [-1, 1]^3, and the rays leave a sphere of radius 3 around it towards 
+ * random points of the scene. The same seed is used every run, and every
+ * structure must report the same amount of hits.
+ * 
+ * @param geometry_count Amount of spheres in the scene
+ * @param ray_count Amount of rays traced by each query
+ * @return 0 if every structure agreed on the hits, 1 otherwise
+ */
+int benchmarkAcceleration(int geometry_count, int ray_count){
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> coordinate(-1, 1);
+    
+    //Spheres a quarter of the mean spacing wide, so they rarely overlap
+    Scene* scene = new Scene();
+    double radius = 0.125 * cbrt(8.0 / std::max(geometry_count, 1));
+    for (int i = 0; i < geometry_count; i++) {
+        Sphere* sphere = new Sphere(new Point3D(coordinate(random), coordinate(random), coordinate(random)), radius, new ConstantShader());
+        scene->addGeo(sphere);
+    }
+    addCamera(scene);
+    
+    std::vector<Ray*> rays(ray_count);
+    for (int i = 0; i < ray_count; i++) {
+        Vector3D start (coordinate(random), coordinate(random), coordinate(random));
+        start.normalize();
+        Point3D* origin = new Point3D(3 * start.getX(), 3 * start.getY(), 3 * start.getZ());
+        Vector3D* direction = new Vector3D(coordinate(random) - origin->getX(), coordinate(random) - origin->getY(), coordinate(random) - origin->getZ());
+        direction->normalize();
+        rays[i] = new Ray(origin, direction);
+    }
+    
+    int acceleration_types[] = {0, 1, 2, 3, 4};
+    int type_count = sizeof(acceleration_types) / sizeof(acceleration_types[0]);
+    std::string names[] = {"Bvh", "CompressedBvh", "Bvh4", "UniformGrid", "TwoLevelGrid"};
+    RayTracer ray_tracer(scene, NULL);
+    double reference_rates[2] = {0, 0};
+    int reference_hits[2] = {-1, -1};
+    int status = 0;
+    
+    cout << geometry_count << " spheres, " << ray_count << " rays (Mrays/s relative to Bvh)" << endl;
+    cout << std::left << std::setw(15) << "Structure" << std::right << std::setw(10) << "Build ms" << std::setw(10) << "Memory MB" 
+         << std::setw(10) << "Nearest" << std::setw(8) << "" << std::setw(10) << "Any hit" << std::setw(8) << "" << endl;
+    for (int t = 0; t < type_count; t++) {
+        ray_tracer.setAccelerationType(acceleration_types[t]);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        ray_tracer.buildAccelerationStructure();
+        double build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        AccelerationStructure* acceleration_structure = ray_tracer.getAccelerationStructure();
+        
+        double rates[2];
+        int hits[2] = {0, 0};
+        for (int query = 0; query < 2; query++) {
+            Point3D nearest_point (0,0,0);
+            Vector3D normal (1,0,0);
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < ray_count; i++) {
+                bool hit = query == 0 ? acceleration_structure->computeNearestIntersection(rays[i], &nearest_point, &normal) != NULL
+                                      : acceleration_structure->hasIntersection(rays[i]);
+                hits[query] += hit;
+            }
+            rates[query] = ray_count / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 1e6;
+            if(t == 0){
+                reference_rates[query] = rates[query];
+                reference_hits[query] = hits[query];
+            } else if(hits[query] != reference_hits[query]){
+                status = 1;
+            }
+        }
+        
+        cout << std::left << std::setw(15) << names[acceleration_types[t]] << std::right << std::fixed 
+             << std::setw(10) << std::setprecision(1) << build_seconds * 1000 
+             << std::setw(10) << std::setprecision(2) << acceleration_structure->getMemoryUsage() / 1048576.0
+             << std::setw(10) << std::setprecision(3) << rates[0] << "  x" << std::setw(5) << std::setprecision(2) << rates[0] / reference_rates[0]
+             << std::setw(10) << std::setprecision(3) << rates[1] << "  x" << std::setw(5) << std::setprecision(2) << rates[1] / reference_rates[1] << endl;
+        if(hits[0] != reference_hits[0] || hits[1] != reference_hits[1]){
+            cout << "Error (" << names[acceleration_types[t]] << "): " << hits[0] << " nearest and " << hits[1] << " any hits, " 
+                 << reference_hits[0] << " and " << reference_hits[1] << " expected." << endl;
+        }
+    }
+    
+    for (int i = 0; i < ray_count; i++) {
+        delete rays[i];
+    }
+    return status;
+}
+
+/**
+ * Runs a render service on a Unix domain socket until it is shut down
+ * 
+ * @param socket_path Path of the socket to listen on
+ * @param worker_count Amount of jobs rendered at the same time
+ * @param cache_capacity Amount of scenes kept built between jobs
+ * @return Exit status
+ */
+int runDaemon(std::string socket_path, int worker_count, int cache_capacity){
+    RenderService service(socket_path, worker_count, cache_capacity);
+    try {
+        service.run();
+    } catch ( const std::exception& error ) {
+        cerr << "Error (RenderService): " << error.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Sends a request to a render service and prints its replies
+ * 
+ * Client Commands (10/19/2016)
+ * 
+ * render PRIORITY OUTPUT SCENE_FILE: Prints the id of the job once queued, 
+ *     then how it ended
+ * cancel ID
+ * stats
+ * shutdown
+ * 
+ * @param socket_path Path of the socket of the service
+ * @param arguments Command and its arguments
+ * @return Exit status, 1 if the request or its job failed
+ */
+int runClient(std::string socket_path, std::vector<std::string> arguments){
+    RenderClient client(socket_path);
+    try {
+        client.connect();
+        if(arguments.size() >= 4 && arguments[0] == "render"){
+            std::ifstream scene_file(arguments[3].c_str());
+            if(!scene_file){
+                cerr << "Error (RenderClient): could not read " << arguments[3] << endl;
+                return 1;
+            }
+            std::stringstream scene_text;
+            scene_text << scene_file.rdbuf();
+            
+            int job_id = client.queueRender(atoi(arguments[1].c_str()), arguments[2], scene_text.str());
+            cout << "QUEUED " << job_id << endl;
+            std::string reply = client.readLine();
+            cout << reply << endl;
+            return reply.compare(0, 4, "DONE") == 0 ? 0 : 1;
+        } else if(arguments.size() >= 2 && arguments[0] == "cancel"){
+            cout << client.request("CANCEL " + arguments[1]) << endl;
+        } else if(arguments.size() >= 1 && arguments[0] == "stats"){
+            cout << client.request("STATS") << endl;
+        } else if(arguments.size() >= 1 && arguments[0] == "shutdown"){
+            cout << client.request("SHUTDOWN") << endl;
+        } else {
+            cerr << "Usage: --client SOCKET render PRIORITY OUTPUT SCENE_FILE | cancel ID | stats | shutdown" << endl;
+            return 1;
+        }
+    } catch ( const std::exception& error ) {
+        cerr << "Error (RenderClient): " << error.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Renders a scene file across worker processes. Local workers run this 
+ * executable, and remote workers can join with "--farm-worker HOST PORT"
+ * using the port printed on standard error.
+ * 
+ * @param worker_count Amount of local workers to start
+ * @param output Name of the output file (a PFM if it ends in ".pfm")
+ * @param scene_filename Scene file (see Scene Parser)
+ * @param port Port to listen on, 0 for any free port
+ * @param tile_timeout Seconds a worker may spend on a tile before it is dropped
+ * @return Exit status
+ */
+int runFarm(int worker_count, std::string output, std::string scene_filename, int port, double tile_timeout){
+    std::ifstream scene_file(scene_filename.c_str());
+    if(!scene_file){
+        cerr << "Error (FarmCoordinator): could not read " << scene_filename << endl;
+        return 1;
+    }
+    std::stringstream scene_text;
+    scene_text << scene_file.rdbuf();
+    
+    char executable[4096];
+    ssize_t executable_size = readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+    if(executable_size <= 0){
+        cerr << "Error (FarmCoordinator): could not find the ray tracer executable" << endl;
+        return 1;
+    }
+    executable[executable_size] = '\0';
+    
+    FarmCoordinator coordinator(64, tile_timeout);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    try {
+        coordinator.setScene(scene_text.str());
+        coordinator.listen(port);
+        cerr << "Listening for workers on port " << coordinator.getPort() << endl;
+        coordinator.spawnLocalWorkers(worker_count, executable);
+        coordinator.render(output);
+    } catch ( const std::exception& error ) {
+        cerr << "Error (FarmCoordinator): " << error.what() << endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cerr << "Rendered " << coordinator.getTileCount() << " tiles with " << coordinator.getWorkerCount() << " workers in " 
+         << seconds << " s (" << coordinator.getReassignedCount() << " reassigned, " << coordinator.getDuplicatedCount() 
+         << " duplicated, " << coordinator.getDroppedWorkerCount() << " workers dropped)" << endl;
+    return 0;
+}
+
+/**
+ * Renders the scene to output.ppm, or with "--frames FIRST LAST [PATTERN]" 
+ * renders the frames of the animation to a file each (frame_%04d.ppm by 
+ * default). "--stream TARGET FIRST LAST" streams the frames instead as raw 
+ * RGB24 video to TARGET ("-" for standard output, or a named pipe), and 
+ * "--bench-stream [FRAMES [WIDTH HEIGHT]]" measures the frames per second a
+ * pipe sustains, and "--bench-accel [SPHERES [RAYS]]" compares the 
+ * acceleration structures. With "--aov PREFIX" the depth, normal and object id channels are
+ * also written, to PREFIX_depth.pfm, PREFIX_normal.pfm and PREFIX_object_id.pfm.
+ * 
+ * "--daemon SOCKET [WORKERS [CACHE]]" runs a render service instead, taking
+ * scenes described as text over a Unix domain socket, and "--client SOCKET 
+ * COMMAND ..." sends it requests (see runClient). "--farm WORKERS OUTPUT 
+ * SCENE_FILE [PORT [TILE_TIMEOUT]]" renders a scene file in tiles across 
+ * worker processes (see runFarm).
+ */
 int main(int argc, char** argv) {
+    
+    if(argc >= 3 && std::string(argv[1]) == "--daemon"){
+        return runDaemon(argv[2], argc >= 4 ? atoi(argv[3]) : 2, argc >= 5 ? atoi(argv[4]) : 8);
+    }
+    if(argc >= 4 && std::string(argv[1]) == "--client"){
+        return runClient(argv[2], std::vector<std::string>(argv + 3, argv + argc));
+    }
+    if(argc >= 5 && std::string(argv[1]) == "--farm"){
+        return runFarm(atoi(argv[2]), argv[3], argv[4], argc >= 6 ? atoi(argv[5]) : 0, argc >= 7 ? atof(argv[6]) : 30.0);
+    }
+    if(argc >= 4 && std::string(argv[1]) == "--farm-worker"){
+        FarmWorker worker(argv[2], atoi(argv[3]));
+        try {
+            worker.run();
+        } catch ( const std::exception& error ) {
+            cerr << "Error (FarmWorker): " << error.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
  
     Scene* scene1 = new Scene();
 
@@ -134,19 +480,128 @@ int main(int argc, char** argv) {
     addLights(scene1);
     addCamera(scene1);
     
-    PpmWriter* output_writer = new PpmWriter("output.ppm");
+    if(argc >= 4 && std::string(argv[1]) == "--frames"){
+        Animation animation;
+        addAnimation(scene1, &animation);
+        
+        RayTracer* ray_tracer = new RayTracer(scene1, new PpmWriter());
+        try {
+            ray_tracer->renderSequence(&animation, atoi(argv[2]), atoi(argv[3]), argc >= 5 ? argv[4] : "frame_%04d.ppm");
+        } catch ( const std::exception& error ) {
+            std::cout << "Error (FileWriter): " << error.what() << std::endl;
+            delete ray_tracer;
+            return 1;
+        }
+        ray_tracer->printRayStatistics(std::cout);
+        
+        delete ray_tracer;
+        return 0;
+    }
+    
+    if(argc >= 5 && std::string(argv[1]) == "--stream"){
+        Animation animation;
+        addAnimation(scene1, &animation);
+        
+        //Opened before tracing, so a named pipe waits for its reader first
+        StreamWriter* stream_writer = new StreamWriter(argv[2]);
+        try {
+            stream_writer->init();
+        } catch ( const std::exception& error ) {
+            cerr << "Error (StreamWriter): " << error.what() << endl;
+            delete scene1;
+            delete stream_writer;
+            return 1;
+        }
+        
+        //Statistics go to standard error, which may be the stream's only other output
+        RayTracer* ray_tracer = new RayTracer(scene1, stream_writer);
+        try {
+            ray_tracer->renderSequence(&animation, atoi(argv[3]), atoi(argv[4]), argv[2]);
+        } catch ( const std::exception& error ) {
+            cerr << "Error (StreamWriter): " << error.what() << endl;
+            delete ray_tracer;
+            return 1;
+        }
+        ray_tracer->printRayStatistics(std::cerr);
+        
+        delete ray_tracer;
+        return 0;
+    }
+    
+    if(argc >= 2 && std::string(argv[1]) == "--bench-stream"){
+        delete scene1;
+        int frame_count = argc >= 3 ? atoi(argv[2]) : 240;
+        int width = argc >= 5 ? atoi(argv[3]) : 1920;
+        int height = argc >= 5 ? atoi(argv[4]) : 1080;
+        return benchmarkStream(frame_count, width, height);
+    }
+    
+    if(argc >= 2 && std::string(argv[1]) == "--bench-accel"){
+        delete scene1;
+        int geometry_count = argc >= 3 ? atoi(argv[2]) : 100000;
+        int ray_count = argc >= 4 ? atoi(argv[3]) : 1000000;
+        return benchmarkAcceleration(geometry_count, ray_count);
+    }
+    
+    if(argc >= 3 && std::string(argv[1]) == "--mapped"){
+        if(argc >= 5){
+            scene1->getCamera()->setResolution(atoi(argv[3]), atoi(argv[4]));
+        }
+        
+        MappedPpmWriter* mapped_writer = new MappedPpmWriter(argv[2]);
+        mapped_writer->setAsynchronous(true);
+        try {
+            mapped_writer->init();
+            mapped_writer->defineHeaders(scene1->getWidthResolution(), scene1->getHeightResolution(), 255);
+        } catch ( const std::exception& error ) {
+            std::cout << "Error (MappedPpmWriter): " << error.what() << std::endl;
+            delete scene1;
+            delete mapped_writer;
+            return 1;
+        }
+        
+        RayTracer* ray_tracer = new RayTracer(scene1, mapped_writer);
+        ray_tracer->run();
+        mapped_writer->close();
+        ray_tracer->printRayStatistics(std::cout);
+        
+        delete ray_tracer;
+        return 0;
+    }
+    
+    //Float or 16-bit output keeps the precision lost by the 8-bit ASCII file
+    FileWriter* output_writer;
+    int max_color = 255;
+    if(argc >= 3 && std::string(argv[1]) == "--pfm"){
+        output_writer = new PfmWriter(argv[2]);
+    } else if(argc >= 3 && std::string(argv[1]) == "--ppm16"){
+        output_writer = new BinaryPpmWriter(argv[2]);
+        max_color = 65535;
+    } else {
+        output_writer = new PpmWriter("output.ppm");
+    }
     try {
         output_writer->init();
-        output_writer->defineHeaders(scene1->getWidthResolution(), scene1->getHeightResolution(), 255);
+        output_writer->defineHeaders(scene1->getWidthResolution(), scene1->getHeightResolution(), max_color);
     } catch ( const std::invalid_argument& error ) {
-        std::cout << "Error (PpmWriter): " << error.what() << std::endl;
+        std::cout << "Error (FileWriter): " << error.what() << std::endl;
         delete scene1;
         delete output_writer;
         return 1;
     }
 
     RayTracer* ray_tracer = new RayTracer(scene1, output_writer);
+    bool write_output_channels = argc >= 3 && std::string(argv[1]) == "--aov";
+    for (int i = 0; i < AOV_CHANNEL_COUNT; i++) {
+        ray_tracer->setOutputChannel(i, write_output_channels);
+    }
     ray_tracer->run();
+    if(write_output_channels){
+        for (int i = 0; i < AOV_CHANNEL_COUNT; i++) {
+            ray_tracer->writeOutputChannel(i, std::string(argv[2]) + "_" + AovBuffer::getChannelName(i) + ".pfm");
+        }
+    }
+    ray_tracer->printRayStatistics(std::cout);
     
     delete ray_tracer;
 
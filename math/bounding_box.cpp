@@ -0,0 +1,147 @@
+// Ray Tracer: bounding_box.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Bounding Box is an axis-aligned box defined by its minimum
+//                 and maximum corners. It conservatively encloses a piece of
+//                 geometry so it can be culled without testing the geometry.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "bounding_box.h"
+
+/**
+ * Creates an empty box. Expanding an empty box by a point or box
+ * results in a box enclosing only that point or box.
+ */
+BoundingBox::BoundingBox(){
+    this->min_corner_ = Point3D(INFINITY, INFINITY, INFINITY);
+    this->max_corner_ = Point3D(-INFINITY, -INFINITY, -INFINITY);
+}
+
+BoundingBox::BoundingBox(Point3D min_corner, Point3D max_corner){
+    this->min_corner_ = min_corner;
+    this->max_corner_ = max_corner;
+}
+
+/**
+ * Determines if the box encloses no space at all
+ *
+ * @return Result of the check
+ */
+bool BoundingBox::isEmpty(){
+    return this->min_corner_.getX() > this->max_corner_.getX() ||
+           this->min_corner_.getY() > this->max_corner_.getY() ||
+           this->min_corner_.getZ() > this->max_corner_.getZ();
+}
+
+/**
+ * Determines if the given point lies inside the box or on its boundary
+ *
+ * @param point Point to test
+ * @return Result of the check
+ */
+bool BoundingBox::contains(Point3D* point){
+    return point->getX() >= this->min_corner_.getX() && point->getX() <= this->max_corner_.getX() &&
+           point->getY() >= this->min_corner_.getY() && point->getY() <= this->max_corner_.getY() &&
+           point->getZ() >= this->min_corner_.getZ() && point->getZ() <= this->max_corner_.getZ();
+}
+
+/**
+ * Grows the box so that it encloses the given point
+ *
+ * @param point Point to enclose
+ */
+void BoundingBox::expand(Point3D point){
+    this->min_corner_ = Point3D(std::min(this->min_corner_.getX(), point.getX()),
+                                std::min(this->min_corner_.getY(), point.getY()),
+                                std::min(this->min_corner_.getZ(), point.getZ()));
+    this->max_corner_ = Point3D(std::max(this->max_corner_.getX(), point.getX()),
+                                std::max(this->max_corner_.getY(), point.getY()),
+                                std::max(this->max_corner_.getZ(), point.getZ()));
+}
+
+/**
+ * Grows the box so that it encloses the given box
+ *
+ * @param box Box to enclose
+ */
+void BoundingBox::expand(BoundingBox box){
+    if(box.isEmpty()){
+        return;
+    }
+    expand(box.getMin());
+    expand(box.getMax());
+}
+
+/**
+ * Gets the corner of the box with the smallest coordinates
+ *
+ * @return Minimum corner of the box
+ */
+Point3D BoundingBox::getMin(){
+    return this->min_corner_;
+}
+
+/**
+ * Gets the corner of the box with the largest coordinates
+ *
+ * @return Maximum corner of the box
+ */
+Point3D BoundingBox::getMax(){
+    return this->max_corner_;
+}
+
+/**
+ * Gets one of the eight corners of the box. Bits 0, 1 and 2 of the index
+ * select the maximum instead of the minimum X, Y and Z coordinate.
+ *
+ * @param index Index of the corner (0-7)
+ * @return Corner of the box
+ */
+Point3D BoundingBox::getCorner(int index){
+    return Point3D((index & 1) ? this->max_corner_.getX() : this->min_corner_.getX(),
+                   (index & 2) ? this->max_corner_.getY() : this->min_corner_.getY(),
+                   (index & 4) ? this->max_corner_.getZ() : this->min_corner_.getZ());
+}
+
+/**
+ * Gets the point halfway between the minimum and maximum corner of the box
+ *
+ * @return Center of the box
+ */
+Point3D BoundingBox::getCenter(){
+    return Point3D((this->min_corner_.getX() + this->max_corner_.getX()) * 0.5,
+                   (this->min_corner_.getY() + this->max_corner_.getY()) * 0.5,
+                   (this->min_corner_.getZ() + this->max_corner_.getZ()) * 0.5);
+}
+
+/**
+ * Computes the area of the surface of the box. The chance that a random ray
+ * crossing an enclosing box also crosses this box is proportional to it.
+ *
+ * @return Surface area of the box (0 if the box is empty)
+ */
+double BoundingBox::getSurfaceArea(){
+    if(isEmpty()){
+        return 0.0;
+    }
+    double extent_x = this->max_corner_.getX() - this->min_corner_.getX();
+    double extent_y = this->max_corner_.getY() - this->min_corner_.getY();
+    double extent_z = this->max_corner_.getZ() - this->min_corner_.getZ();
+    return 2 * (extent_x * extent_y + extent_y * extent_z + extent_z * extent_x);
+}
@@ -0,0 +1,54 @@
+// Ray Tracer: bounding_box.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Bounding Box is an axis-aligned box defined by its minimum
+//                 and maximum corners. It conservatively encloses a piece of
+//                 geometry so it can be culled without testing the geometry.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef BOUNDING_BOX_H
+#define BOUNDING_BOX_H
+
+#include <algorithm>
+#include <cmath>
+
+#include "point3d.h"
+
+class BoundingBox {
+public:
+    BoundingBox();
+    BoundingBox(Point3D min_corner, Point3D max_corner);
+
+    bool isEmpty();
+    bool contains(Point3D* point);
+    void expand(Point3D point);
+    void expand(BoundingBox box);
+
+    Point3D getMin();
+    Point3D getMax();
+    Point3D getCorner(int index);
+    Point3D getCenter();
+    double getSurfaceArea();
+
+private:
+    Point3D min_corner_;
+    Point3D max_corner_;
+};
+
+#endif /* BOUNDING_BOX_H */
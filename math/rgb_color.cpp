@@ -107,6 +107,15 @@ double RgbColor::getBlue() const{
     return this->z_;
 }
 
+/**
+ * Gets the largest of the red, green and blue components
+ * 
+ * @return The largest component of the color
+ */
+double RgbColor::getMaxComponent(){
+    return std::max(this->x_, std::max(this->y_, this->z_));
+}
+
 /**
  * Clips the internal color values at the maximum color allowed 
  * so the color data does not overflow
@@ -24,6 +24,7 @@
 #ifndef RGB_COLOR_H
 #define	RGB_COLOR_H
 
+#include <algorithm>
 #include <cmath>
 
 #include "v3double.h"
@@ -40,6 +41,7 @@ public:
     double getGreen() const;
     double getBlue();
     double getBlue() const;
+    double getMaxComponent();
     
     void correctOverflow();
     
@@ -0,0 +1,119 @@
+// Ray Tracer: sampler.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Sampler generates a reproducible stream of pseudo-random
+//                 numbers in the range [0, 1) used for stochastic decisions
+//                 along a ray path. It also provides low-discrepancy sequences
+//                 for spreading a fixed number of samples evenly.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "sampler.h"
+
+Sampler::Sampler(){
+    seed(0);
+}
+
+Sampler::Sampler(uint64_t seed){
+    this->seed(seed);
+}
+
+/**
+ * Resets the sequence of the sampler. The seed is scrambled (SplitMix64)
+ * so that consecutive seeds, such as neighboring pixel indices,
+ * still produce uncorrelated sequences.
+ *
+ * @param seed Value identifying the sequence to generate
+ */
+void Sampler::seed(uint64_t seed){
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+
+    //A state of zero would lock the generator at zero
+    this->state_ = (z == 0) ? 0x2545F4914F6CDD1DULL : z;
+}
+
+/**
+ * Generates the next number in the sequence (xorshift64*)
+ *
+ * @return Uniformly distributed number in the range [0, 1)
+ */
+double Sampler::nextDouble(){
+    this->state_ ^= this->state_ >> 12;
+    this->state_ ^= this->state_ << 25;
+    this->state_ ^= this->state_ >> 27;
+    uint64_t result = this->state_ * 0x2545F4914F6CDD1DULL;
+
+    //Use the upper 53 bits to fill the mantissa of a double
+    return (result >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * Computes the radical inverse of an index: the digits of the index in the 
+ * given base are mirrored around the decimal point. Successive indices fill 
+ * the range [0, 1) evenly (the van der Corput sequence), and using different
+ * prime bases for different dimensions gives the Halton sequence.
+ *
+ * @param base Prime base of the sequence
+ * @param index Index of the sample in the sequence
+ * @return Sample in the range [0, 1)
+ */
+double Sampler::radicalInverse(int base, unsigned int index){
+    double inverse_base = 1.0 / base;
+    double digit_weight = inverse_base;
+    double result = 0.0;
+    while(index > 0){
+        result += (index % base) * digit_weight;
+        index /= base;
+        digit_weight *= inverse_base;
+    }
+    return result;
+}
+
+/**
+ * Maps a point in the unit square to a point in the unit disk using the 
+ * concentric mapping of Shirley and Chiu, which keeps evenly spread samples
+ * evenly spread on the disk.
+ *
+ * @param u First coordinate in the unit square (0-1)
+ * @param v Second coordinate in the unit square (0-1)
+ * @param x Resulting X-coordinate in the unit disk
+ * @param y Resulting Y-coordinate in the unit disk
+ */
+void Sampler::mapToDisk(double u, double v, double &x, double &y){
+    double offset_u = 2 * u - 1;
+    double offset_v = 2 * v - 1;
+    if(offset_u == 0 && offset_v == 0){
+        x = 0;
+        y = 0;
+        return;
+    }
+    
+    double radius, angle;
+    if(std::abs(offset_u) > std::abs(offset_v)){
+        radius = offset_u;
+        angle = (M_PI / 4) * (offset_v / offset_u);
+    } else {
+        radius = offset_v;
+        angle = (M_PI / 2) - (M_PI / 4) * (offset_u / offset_v);
+    }
+    x = radius * cos(angle);
+    y = radius * sin(angle);
+}
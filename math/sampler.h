@@ -0,0 +1,47 @@
+// Ray Tracer: sampler.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Sampler generates a reproducible stream of pseudo-random
+//                 numbers in the range [0, 1) used for stochastic decisions
+//                 along a ray path. It also provides low-discrepancy sequences
+//                 for spreading a fixed number of samples evenly.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <cmath>
+#include <stdint.h>
+
+class Sampler {
+public:
+    Sampler();
+    Sampler(uint64_t seed);
+
+    void seed(uint64_t seed);
+    double nextDouble();
+    
+    static double radicalInverse(int base, unsigned int index);
+    static void mapToDisk(double u, double v, double &x, double &y);
+
+private:
+    uint64_t state_;
+};
+
+#endif /* SAMPLER_H */
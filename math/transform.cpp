@@ -0,0 +1,225 @@
+// Ray Tracer: transform.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Transform is an affine mapping of 3D space (any mix of 
+//                 translation, rotation and scaling), stored as a 3x4 matrix
+//                 together with its inverse so points can be mapped either
+//                 way without inverting the matrix again.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "transform.h"
+
+#define SINGULAR_EPSILON 1e-12
+
+Transform::Transform(){
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 4; column++) {
+            this->matrix_[row][column] = (row == column) ? 1.0 : 0.0;
+            this->inverse_[row][column] = (row == column) ? 1.0 : 0.0;
+        }
+    }
+}
+
+/**
+ * Creates a transform from the rows of its matrix. The last column holds the
+ * translation.
+ * 
+ * @param matrix Rows of the 3x4 matrix
+ */
+Transform::Transform(double matrix[3][4]){
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 4; column++) {
+            this->matrix_[row][column] = matrix[row][column];
+        }
+    }
+    
+    //Invert the linear part by its adjugate
+    double (*m)[4] = this->matrix_;
+    double cofactors[3][3] = {
+        {m[1][1] * m[2][2] - m[1][2] * m[2][1], m[1][2] * m[2][0] - m[1][0] * m[2][2], m[1][0] * m[2][1] - m[1][1] * m[2][0]},
+        {m[0][2] * m[2][1] - m[0][1] * m[2][2], m[0][0] * m[2][2] - m[0][2] * m[2][0], m[0][1] * m[2][0] - m[0][0] * m[2][1]},
+        {m[0][1] * m[1][2] - m[0][2] * m[1][1], m[0][2] * m[1][0] - m[0][0] * m[1][2], m[0][0] * m[1][1] - m[0][1] * m[1][0]}
+    };
+    double determinant = m[0][0] * cofactors[0][0] + m[0][1] * cofactors[0][1] + m[0][2] * cofactors[0][2];
+    if(std::abs(determinant) < SINGULAR_EPSILON){
+        throw std::invalid_argument("Transform must not collapse space (its matrix is singular).");
+    }
+    
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 3; column++) {
+            this->inverse_[row][column] = cofactors[column][row] / determinant;
+        }
+    }
+    //The inverse moves the translated origin back to the origin
+    for (int row = 0; row < 3; row++) {
+        this->inverse_[row][3] = -(this->inverse_[row][0] * m[0][3] + this->inverse_[row][1] * m[1][3] + this->inverse_[row][2] * m[2][3]);
+    }
+}
+
+/**
+ * Creates a transform moving space by the given offset
+ * 
+ * @param x Offset along the X-axis
+ * @param y Offset along the Y-axis
+ * @param z Offset along the Z-axis
+ * @return Resulting transform
+ */
+Transform Transform::translation(double x, double y, double z){
+    double matrix[3][4] = {{1, 0, 0, x}, {0, 1, 0, y}, {0, 0, 1, z}};
+    return Transform(matrix);
+}
+
+/**
+ * Creates a transform scaling space about the origin
+ * 
+ * @param x Scale along the X-axis
+ * @param y Scale along the Y-axis
+ * @param z Scale along the Z-axis
+ * @return Resulting transform
+ */
+Transform Transform::scaling(double x, double y, double z){
+    double matrix[3][4] = {{x, 0, 0, 0}, {0, y, 0, 0}, {0, 0, z, 0}};
+    return Transform(matrix);
+}
+
+/**
+ * Creates a transform rotating space about an axis through the origin
+ * (Rodrigues' rotation formula). Looking down the axis, the rotation is 
+ * counterclockwise.
+ * 
+ * @param axis Axis to rotate about (does not need to be normalized)
+ * @param angle Angle of the rotation
+ * @param radians Flag indicating whether the angle is in radians or degrees
+ * @return Resulting transform
+ */
+Transform Transform::rotation(Vector3D axis, double angle, bool radians){
+    if(!radians){
+        angle = angle * M_PI / 180.0;
+    }
+    axis.normalize();
+    double x = axis.getX(), y = axis.getY(), z = axis.getZ();
+    double c = cos(angle), s = sin(angle), t = 1 - c;
+    double matrix[3][4] = {
+        {t * x * x + c,     t * x * y - s * z, t * x * z + s * y, 0},
+        {t * x * y + s * z, t * y * y + c,     t * y * z - s * x, 0},
+        {t * x * z - s * y, t * y * z + s * x, t * z * z + c,     0}
+    };
+    return Transform(matrix);
+}
+
+/**
+ * Composes two transforms. The result applies the right transform first.
+ * 
+ * @param t Transform to apply first
+ * @return Resulting transform
+ */
+Transform Transform::operator*(const Transform& t){
+    Transform result;
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 4; column++) {
+            result.matrix_[row][column] = this->matrix_[row][0] * t.matrix_[0][column] +
+                                          this->matrix_[row][1] * t.matrix_[1][column] +
+                                          this->matrix_[row][2] * t.matrix_[2][column];
+            //The inverse of the result applies the inverse of this transform last
+            result.inverse_[row][column] = t.inverse_[row][0] * this->inverse_[0][column] +
+                                           t.inverse_[row][1] * this->inverse_[1][column] +
+                                           t.inverse_[row][2] * this->inverse_[2][column];
+        }
+        result.matrix_[row][3] += this->matrix_[row][3];
+        result.inverse_[row][3] += t.inverse_[row][3];
+    }
+    return result;
+}
+
+/**
+ * Gets the transform undoing this transform
+ * 
+ * @return Inverse transform
+ */
+Transform Transform::getInverse(){
+    Transform result;
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 4; column++) {
+            result.matrix_[row][column] = this->inverse_[row][column];
+            result.inverse_[row][column] = this->matrix_[row][column];
+        }
+    }
+    return result;
+}
+
+/**
+ * Maps a point, applying the translation
+ * 
+ * @param point Point to map
+ * @return Mapped point
+ */
+Point3D Transform::transformPoint(Point3D* point){
+    double x = point->getX(), y = point->getY(), z = point->getZ();
+    return Point3D(this->matrix_[0][0] * x + this->matrix_[0][1] * y + this->matrix_[0][2] * z + this->matrix_[0][3],
+                   this->matrix_[1][0] * x + this->matrix_[1][1] * y + this->matrix_[1][2] * z + this->matrix_[1][3],
+                   this->matrix_[2][0] * x + this->matrix_[2][1] * y + this->matrix_[2][2] * z + this->matrix_[2][3]);
+}
+
+/**
+ * Maps a direction, ignoring the translation. The length of the direction is
+ * scaled along with space.
+ * 
+ * @param vector Direction to map
+ * @return Mapped direction
+ */
+Vector3D Transform::transformVector(Vector3D* vector){
+    double x = vector->getX(), y = vector->getY(), z = vector->getZ();
+    return Vector3D(this->matrix_[0][0] * x + this->matrix_[0][1] * y + this->matrix_[0][2] * z,
+                    this->matrix_[1][0] * x + this->matrix_[1][1] * y + this->matrix_[1][2] * z,
+                    this->matrix_[2][0] * x + this->matrix_[2][1] * y + this->matrix_[2][2] * z);
+}
+
+/**
+ * Maps the normal of a surface so it stays perpendicular to the mapped 
+ * surface. Under non-uniform scaling this differs from mapping it as a 
+ * direction: normals are mapped by the transpose of the inverse. The result 
+ * is not normalized.
+ * 
+ * @param normal Normal to map
+ * @return Mapped normal
+ */
+Vector3D Transform::transformNormal(Vector3D* normal){
+    double x = normal->getX(), y = normal->getY(), z = normal->getZ();
+    return Vector3D(this->inverse_[0][0] * x + this->inverse_[1][0] * y + this->inverse_[2][0] * z,
+                    this->inverse_[0][1] * x + this->inverse_[1][1] * y + this->inverse_[2][1] * z,
+                    this->inverse_[0][2] * x + this->inverse_[1][2] * y + this->inverse_[2][2] * z);
+}
+
+/**
+ * Computes the axis-aligned box enclosing a mapped box
+ * 
+ * @param bounds Box to map
+ * @return Box enclosing the eight mapped corners
+ */
+BoundingBox Transform::transformBounds(BoundingBox bounds){
+    BoundingBox result;
+    if(bounds.isEmpty()){
+        return result;
+    }
+    for (int corner = 0; corner < 8; corner++) {
+        Point3D corner_point = bounds.getCorner(corner);
+        result.expand(transformPoint(&corner_point));
+    }
+    return result;
+}
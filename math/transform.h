@@ -0,0 +1,58 @@
+// Ray Tracer: transform.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Transform is an affine mapping of 3D space (any mix of 
+//                 translation, rotation and scaling), stored as a 3x4 matrix
+//                 together with its inverse so points can be mapped either
+//                 way without inverting the matrix again.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <cmath>
+#include <stdexcept>
+
+#include "bounding_box.h"
+#include "point3d.h"
+#include "vector3d.h"
+
+class Transform {
+public:
+    Transform();
+    Transform(double matrix[3][4]);
+    
+    static Transform translation(double x, double y, double z);
+    static Transform scaling(double x, double y, double z);
+    static Transform rotation(Vector3D axis, double angle, bool radians);
+    
+    Transform operator*(const Transform& t);
+    Transform getInverse();
+    
+    Point3D transformPoint(Point3D* point);
+    Vector3D transformVector(Vector3D* vector);
+    Vector3D transformNormal(Vector3D* normal);
+    BoundingBox transformBounds(BoundingBox bounds);
+    
+private:
+    double matrix_[3][4];
+    double inverse_[3][4];
+};
+
+#endif /* TRANSFORM_H */
@@ -109,6 +109,13 @@ Vector3D Vector3D::operator+(const double d){
    return Vector3D(result_x, result_y, result_z); 
 }
 
+Vector3D Vector3D::operator+(const Vector3D v){
+   double result_x = this->x_ + v.getX();
+   double result_y = this->y_ + v.getY();
+   double result_z = this->z_ + v.getZ();
+   return Vector3D(result_x, result_y, result_z); 
+}
+
 Vector3D Vector3D::operator-(const double d){
    double result_x = this->x_ - d;
    double result_y = this->y_ - d;
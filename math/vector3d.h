@@ -44,6 +44,7 @@ public:
     Vector3D operator*(const double d);
     Vector3D operator*(const Vector3D v);
     Vector3D operator+(const double d);
+    Vector3D operator+(const Vector3D v);
     Vector3D operator-(const double d);
     Vector3D operator-(const Vector3D v);
 private:
@@ -0,0 +1,171 @@
+// Ray Tracer: path_state.cpp
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Path State holds the mutable data shared by every ray
+//                  spawned from a single primary ray, such as the random
+//                  number sequence used for stochastic path termination,
+//                  the budget of secondary rays the path may still spawn,
+//                  the number of rays of each type it has cast and, when a 
+//                  G-Buffer is kept, the list its hits are recorded to.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "path_state.h"
+
+PathState::PathState(){
+    this->ray_budget_ = 0;
+    for (int i = 0; i < RAY_TYPE_COUNT; i++) {
+        this->ray_counts_[i] = 0;
+    }
+    this->g_buffer_nodes_ = NULL;
+    this->current_node_ = -1;
+    this->aov_sample_ = NULL;
+}
+
+PathState::PathState(uint64_t seed){
+    this->sampler_.seed(seed);
+    this->ray_budget_ = 0;
+    for (int i = 0; i < RAY_TYPE_COUNT; i++) {
+        this->ray_counts_[i] = 0;
+    }
+    this->g_buffer_nodes_ = NULL;
+    this->current_node_ = -1;
+    this->aov_sample_ = NULL;
+}
+
+PathState::~PathState(){}
+
+/**
+ * Gets the random number sequence owned by the path
+ *
+ * @return Pointer to the path's sampler
+ */
+Sampler* PathState::getSampler(){
+    return &this->sampler_;
+}
+
+/**
+ * Sets the number of secondary rays (reflection and refraction) the path
+ * may still spawn
+ *
+ * @param ray_budget Number of secondary rays the path may spawn
+ */
+void PathState::setRayBudget(int ray_budget){
+    this->ray_budget_ = ray_budget;
+}
+
+/**
+ * Gets the number of secondary rays the path may still spawn
+ *
+ * @return Number of secondary rays left in the budget
+ */
+int PathState::getRayBudget(){
+    return this->ray_budget_;
+}
+
+/**
+ * Takes one ray out of the path's budget. If the budget is exhausted the ray
+ * must not be spawned, otherwise it is counted under the given type.
+ *
+ * @param ray_type Type of the ray to spawn (see Ray Type List)
+ * @return Flag indicating whether the ray may be spawned
+ */
+bool PathState::consumeRay(int ray_type){
+    if(this->ray_budget_ <= 0){
+        return false;
+    }
+    this->ray_budget_--;
+    countRay(ray_type);
+    return true;
+}
+
+/**
+ * Records that a ray of the given type has been cast
+ *
+ * @param ray_type Type of the ray cast (see Ray Type List)
+ */
+void PathState::countRay(int ray_type){
+    this->ray_counts_[ray_type]++;
+}
+
+/**
+ * Gets the number of rays of the given type cast by the path
+ *
+ * @param ray_type Type of the ray (see Ray Type List)
+ * @return Number of rays of the type cast by the path
+ */
+long PathState::getRayCount(int ray_type){
+    return this->ray_counts_[ray_type];
+}
+
+/**
+ * Sets the list the hits of the path are recorded to. Hits are not recorded
+ * when no list is set.
+ *
+ * @param g_buffer_nodes List to record the hits of the path to (or NULL)
+ */
+void PathState::setGBufferNodes(std::vector<GBufferNode>* g_buffer_nodes){
+    this->g_buffer_nodes_ = g_buffer_nodes;
+}
+
+/**
+ * Gets the list the hits of the path are recorded to
+ *
+ * @return List to record the hits of the path to (NULL when not recording)
+ */
+std::vector<GBufferNode>* PathState::getGBufferNodes(){
+    return this->g_buffer_nodes_;
+}
+
+/**
+ * Sets the recorded hit whose rays are being traced, which becomes the 
+ * parent of the hits recorded next
+ *
+ * @param node_index Index of the hit being shaded (-1 for the camera)
+ */
+void PathState::setCurrentNode(int node_index){
+    this->current_node_ = node_index;
+}
+
+/**
+ * Gets the recorded hit whose rays are being traced
+ *
+ * @return Index of the hit being shaded (-1 for the camera)
+ */
+int PathState::getCurrentNode(){
+    return this->current_node_;
+}
+
+/**
+ * Sets where the output variables of the next surface hit are recorded. 
+ * Output variables are not recorded when none is set.
+ *
+ * @param aov_sample Output variables to fill with the next hit (or NULL)
+ */
+void PathState::setAovSample(AovSample* aov_sample){
+    this->aov_sample_ = aov_sample;
+}
+
+/**
+ * Gets where the output variables of the next surface hit are recorded
+ *
+ * @return Output variables to fill with the next hit (NULL when not recording)
+ */
+AovSample* PathState::getAovSample(){
+    return this->aov_sample_;
+}
@@ -0,0 +1,79 @@
+// Ray Tracer: path_state.h
+//
+// Author: Wesley Hauwiller
+//
+// Description: A Path State holds the mutable data shared by every ray
+//                  spawned from a single primary ray, such as the random
+//                  number sequence used for stochastic path termination,
+//                  the budget of secondary rays the path may still spawn,
+//                  the number of rays of each type it has cast and, when a 
+//                  G-Buffer is kept, the list its hits are recorded to, and
+//                  when output channels are kept, where its first hit is 
+//                  recorded.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef PATH_STATE_H
+#define PATH_STATE_H
+
+#include <stdint.h>
+
+#include "aov_buffer.h"
+#include "g_buffer.h"
+
+#include "math/sampler.h"
+
+//Ray Type List (10/19/2016)
+//0: Primary
+//1: Reflection
+//2: Refraction
+//3: Shadow
+#define RAY_TYPE_COUNT 4
+
+class PathState {
+public:
+    PathState();
+    PathState(uint64_t seed);
+    virtual ~PathState();
+
+    Sampler* getSampler();
+    
+    void setRayBudget(int ray_budget);
+    int getRayBudget();
+    bool consumeRay(int ray_type);
+    
+    void countRay(int ray_type);
+    long getRayCount(int ray_type);
+    
+    void setGBufferNodes(std::vector<GBufferNode>* g_buffer_nodes);
+    std::vector<GBufferNode>* getGBufferNodes();
+    void setCurrentNode(int node_index);
+    int getCurrentNode();
+    
+    void setAovSample(AovSample* aov_sample);
+    AovSample* getAovSample();
+
+private:
+    Sampler sampler_;
+    int ray_budget_;
+    long ray_counts_[RAY_TYPE_COUNT];
+    std::vector<GBufferNode>* g_buffer_nodes_;
+    int current_node_;
+    AovSample* aov_sample_;
+};
+
+#endif /* PATH_STATE_H */
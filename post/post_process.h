@@ -0,0 +1,75 @@
+// Ray Tracer: post_process.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: The Post Process turns the colors traced into a frame buffer
+//                  into the colors written to an image. Each sample is scaled
+//                  by the exposure, compressed by a tone mapping operator,
+//                  gamma encoded and dithered. Rows are split between 
+//                  threads and four samples are processed at a time with 
+//                  SSE2 where the processor has it.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef POST_PROCESS_H
+#define	POST_PROCESS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../frame_buffer.h"
+
+class PostProcess {
+public:
+    PostProcess();
+    virtual ~PostProcess();
+    
+    void setExposure(double exposure);
+    double getExposure();
+    void setToneMapOperator(int tone_map_operator);
+    int getToneMapOperator();
+    void setGamma(double gamma);
+    double getGamma();
+    void setDitherAmplitude(double dither_amplitude);
+    double getDitherAmplitude();
+    
+    void apply(FrameBuffer* source, FrameBuffer* destination);
+    void processRows(FrameBuffer* source, FrameBuffer* destination, int first_y, int last_y);
+    void processRow(float* samples, float* processed_samples, int pixel_count, int first_x, int y);
+    
+    float encodeGamma(float value);
+#ifdef __SSE2__
+    __m128 encodeGamma(__m128 values);
+#endif
+    
+private:
+    double exposure_;
+    int tone_map_operator_;
+    double gamma_;
+    std::vector<float> gamma_table_;
+    double dither_amplitude_;
+};
+
+#endif	/* POST_PROCESS_H */
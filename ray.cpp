@@ -26,11 +26,15 @@
 Ray::Ray(){
     this->origin_ = new Point3D(0,0,0);
     this->direction_ = new Vector3D(0,0,0);
+    this->min_distance_ = 0;
+    this->max_distance_ = INFINITY;
 }
 
 Ray::Ray(Point3D* origin, Vector3D* direction){
     this->origin_ = origin;
     this->direction_ = direction;
+    this->min_distance_ = 0;
+    this->max_distance_ = INFINITY;
 }
 
 Ray::~Ray(){
@@ -97,4 +101,33 @@ void Ray::setDirection(Vector3D* direction){
  */
 Vector3D Ray::getInverseDirection(){
     return Vector3D(-this->direction_->getX(), -this->direction_->getY(), -this->direction_->getZ());
-}
\ No newline at end of file
+}
+/**
+ * Limits the part of the ray that can intersect geometry to the segment between
+ * two distances from the origin (such as the near and far clip planes of the camera)
+ * 
+ * @param min_distance Intersections closer to the origin than this are ignored
+ * @param max_distance Intersections farther from the origin than this are ignored
+ */
+void Ray::setInterval(double min_distance, double max_distance){
+    this->min_distance_ = min_distance;
+    this->max_distance_ = max_distance;
+}
+
+/**
+ * Gets the distance from the origin at which the ray starts intersecting geometry
+ * 
+ * @return Minimum distance of an intersection
+ */
+double Ray::getMinDistance(){
+    return this->min_distance_;
+}
+
+/**
+ * Gets the distance from the origin at which the ray stops intersecting geometry
+ * 
+ * @return Maximum distance of an intersection
+ */
+double Ray::getMaxDistance(){
+    return this->max_distance_;
+}
@@ -24,6 +24,8 @@
 #ifndef RAY_H
 #define	RAY_H
 
+#include <cmath>
+
 #include "math/point3d.h"
 #include "math/vector3d.h"
 
@@ -40,9 +42,15 @@ public:
     Vector3D* getDirection();
     void setDirection(Vector3D* direction);
     Vector3D getInverseDirection();
+    
+    void setInterval(double min_distance, double max_distance);
+    double getMinDistance();
+    double getMaxDistance();
 private:
     Point3D* origin_;
     Vector3D* direction_;
+    double min_distance_;
+    double max_distance_;
 };
 
 #endif	/* RAY_H */
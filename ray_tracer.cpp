@@ -27,112 +27,1356 @@
 
 #include "ray_tracer.h"
 
-#define MAX_RAY_DEPTH 2
+#define DEFAULT_MAX_RAY_DEPTH 2
+#define DEFAULT_THROUGHPUT_THRESHOLD 0.01
+#define DEFAULT_RAY_BUDGET 16
+#define SURFACE_EPSILON 1e-6
+#define PROJECTION_BIN_SIZE 16
+#define MAX_AREA_LIGHT_STRATA 16
+#define UPDATE_TILE_SIZE 16
+#define RENDER_TILE_SIZE 64
+#define AUTOMATIC_GRID_MIN_GEOMETRY 64
+#define AUTOMATIC_GRID_MAX_RAYS_PER_GEOMETRY 4
+#define AUTOMATIC_GRID_MAX_SIZE_VARIATION 0.5
+#define AUTOMATIC_GRID_HISTOGRAM_RESOLUTION 8
+#define AUTOMATIC_GRID_MAX_EMPTY_FRACTION 0.5
 
 
-RayTracer::RayTracer(){}
+RayTracer::RayTracer(){
+    this->max_ray_depth_ = DEFAULT_MAX_RAY_DEPTH;
+    this->throughput_threshold_ = DEFAULT_THROUGHPUT_THRESHOLD;
+    this->russian_roulette_ = false;
+    this->ray_budget_ = DEFAULT_RAY_BUDGET;
+    this->light_sample_count_ = 0;
+    this->keep_g_buffer_ = false;
+    this->g_buffer_ = NULL;
+    for (int i = 0; i < AOV_CHANNEL_COUNT; i++) {
+        this->output_channels_[i] = false;
+    }
+    this->aov_buffer_ = NULL;
+    this->frame_buffer_ = NULL;
+    this->post_process_ = new PostProcess();
+    this->projection_grid_ = NULL;
+    this->acceleration_structure_ = NULL;
+    this->acceleration_type_ = 0;
+    this->samples_per_pixel_ = 1;
+    for (int i = 0; i < RAY_TYPE_COUNT; i++) {
+        this->ray_counts_[i] = 0;
+    }
+    this->cancelled_ = false;
+}
+
+RayTracer::RayTracer(Scene* scene, FileWriter* file_writer){
+    this->scene_ = scene;
+    this->file_writer_ = file_writer;
+    this->max_ray_depth_ = DEFAULT_MAX_RAY_DEPTH;
+    this->throughput_threshold_ = DEFAULT_THROUGHPUT_THRESHOLD;
+    this->russian_roulette_ = false;
+    this->ray_budget_ = DEFAULT_RAY_BUDGET;
+    this->light_sample_count_ = 0;
+    this->keep_g_buffer_ = false;
+    this->g_buffer_ = NULL;
+    for (int i = 0; i < AOV_CHANNEL_COUNT; i++) {
+        this->output_channels_[i] = false;
+    }
+    this->aov_buffer_ = NULL;
+    this->frame_buffer_ = NULL;
+    this->post_process_ = new PostProcess();
+    this->projection_grid_ = NULL;
+    this->acceleration_structure_ = NULL;
+    this->acceleration_type_ = 0;
+    this->samples_per_pixel_ = 1;
+    for (int i = 0; i < RAY_TYPE_COUNT; i++) {
+        this->ray_counts_[i] = 0;
+    }
+    this->cancelled_ = false;
+}
+
+RayTracer::~RayTracer(){
+    delete this->scene_;
+    delete this->file_writer_;
+    delete this->g_buffer_;
+    delete this->aov_buffer_;
+    delete this->frame_buffer_;
+    delete this->post_process_;
+    delete this->acceleration_structure_;
+}
+
+/**
+ * Iterates over each pixel in the image. Casts a ray through the center of the 
+ * pixel on the focal plane, computes the color of the pixel using the ray, and 
+ * writes the color data to the file writer. For an orthographic camera the 
+ * geometry is first sorted into a projection grid, since all primary rays 
+ * share the same direction. When a G-Buffer is kept, the surfaces hit by the
+ * rays of every pixel are recorded for relight. The colors are kept in a frame
+ * buffer so that update can trace only the part of the image that changes.
+ * The geometry is sorted into a bounding volume hierarchy before tracing,
+ * which is kept for the next run: it is only refit to geometry edited since
+ * (or rebuilt when geometry was added), so a scene can be rendered again with
+ * another camera or other lights without sorting its geometry again. The 
+ * frame buffer keeps the colors as traced; they are post processed as they 
+ * are written. Nothing is written if the run is cancelled.
+ * 
+ * A mapped file writer instead receives the image tile by tile from several 
+ * threads, and no frame buffer is kept (update then traces the whole image).
+ */
+void RayTracer::run(){
+    this->scene_->compile();
+    
+    std::vector<Geometry*> edited_geometry;
+    this->scene_->getEditedGeometry(&edited_geometry);
+    updateAccelerationStructure(!edited_geometry.empty());
+    this->scene_->clearEdits();
+    
+    delete this->frame_buffer_;
+    this->frame_buffer_ = NULL;
+    if(this->file_writer_->getType() == 1){
+        renderTiles(static_cast<MappedPpmWriter*>(this->file_writer_));
+        return;
+    }
+    this->frame_buffer_ = new FrameBuffer(this->scene_->getWidthResolution(), this->scene_->getHeightResolution());
+    
+    renderFrame();
+    if(!this->cancelled_){
+        writeFrameBuffer();
+    }
+}
+
+/**
+ * Stops the render in progress (on another thread) as soon as the rows or 
+ * tiles being traced are finished. The ray tracer stays cancelled, so later
+ * renders stop at once too, until clearCancel is called.
+ */
+void RayTracer::cancel(){
+    this->cancelled_ = true;
+}
+
+/**
+ * Allows renders again after cancel
+ */
+void RayTracer::clearCancel(){
+    this->cancelled_ = false;
+}
+
+/**
+ * Checks whether renders are cancelled
+ * 
+ * @return Boolean indicating whether renders are cancelled
+ */
+bool RayTracer::isCancelled(){
+    return this->cancelled_;
+}
+
+/**
+ * Renders a range of frames of an animation, writing each frame to its own 
+ * file. The scene is kept between frames: the lights are compiled once, the 
+ * hierarchy over the geometry is built for the first frame and only refit to
+ * the geometry that moved for the following frames (it rebuilds itself once
+ * refitting has made it too slow), and the two frame 
+ * buffers are reused. While one frame is written out, the next frame is set 
+ * up and traced. A cancelled frame is not written. The frame written is a
+ * post processed copy, so the frame buffer kept for update holds the colors
+ * as traced. An error writing a frame is thrown once its writer has ended.
+ * 
+ * @param animation Animation moving the camera and geometry of the scene
+ * @param first_frame First frame to render
+ * @param last_frame Last frame to render
+ * @param filename_pattern Name of each file, with a field for the frame number (see formatFrameFilename), unused by stream writers
+ */
+void RayTracer::renderSequence(Animation* animation, int first_frame, int last_frame, std::string filename_pattern){
+    this->scene_->compile();
+    
+    delete this->frame_buffer_;
+    this->frame_buffer_ = new FrameBuffer(this->scene_->getWidthResolution(), this->scene_->getHeightResolution());
+    FrameBuffer* written_frame_buffer = new FrameBuffer(this->scene_->getWidthResolution(), this->scene_->getHeightResolution());
+    
+    //A stream is opened once under its own name, so its frames are not named
+    bool named_frames = this->file_writer_->getType() != 4;
+    if(named_frames){
+        formatFrameFilename(filename_pattern, first_frame);
+    }
+    
+    std::thread writer;
+    std::exception_ptr write_error;
+    for (int frame = first_frame; frame <= last_frame; frame++) {
+        animation->applyFrame(this->scene_, frame);
+        
+        std::vector<Geometry*> edited_geometry;
+        this->scene_->getEditedGeometry(&edited_geometry);
+        updateAccelerationStructure(!edited_geometry.empty());
+        this->scene_->clearEdits();
+        
+        renderFrame();
+        if(this->cancelled_){
+            break;
+        }
+        
+        //The previous frame must be written before its buffer is reused
+        if(writer.joinable()){
+            writer.join();
+        }
+        if(write_error){
+            delete written_frame_buffer;
+            std::rethrow_exception(write_error);
+        }
+        postProcessFrameBuffer(this->frame_buffer_, written_frame_buffer);
+        
+        std::string filename = named_frames ? formatFrameFilename(filename_pattern, frame) : this->file_writer_->getFilename();
+        writer = std::thread(writeFrame, this->file_writer_, written_frame_buffer, filename, &write_error);
+    }
+    if(writer.joinable()){
+        writer.join();
+    }
+    delete written_frame_buffer;
+    if(write_error){
+        std::rethrow_exception(write_error);
+    }
+}
+
+/**
+ * Sorts the geometry of the scene into a new acceleration structure of the 
+ * selected type
+ */
+void RayTracer::buildAccelerationStructure(){
+    delete this->acceleration_structure_;
+    int acceleration_type = this->acceleration_type_;
+    if(acceleration_type < 0){
+        acceleration_type = chooseAccelerationType();
+    }
+    switch(acceleration_type){
+        case 1: //Compressed Bounding Volume Hierarchy
+            this->acceleration_structure_ = new CompressedBvh(this->scene_);
+            break;
+        case 2: //4-wide Bounding Volume Hierarchy
+            this->acceleration_structure_ = new Bvh4(this->scene_);
+            break;
+        case 3: //Uniform Grid
+            this->acceleration_structure_ = new UniformGrid(this->scene_);
+            break;
+        case 4: //Two-Level Grid
+            this->acceleration_structure_ = new TwoLevelGrid(this->scene_);
+            break;
+        default: //Bounding Volume Hierarchy
+            this->acceleration_structure_ = new Bvh(this->scene_);
+            break;
+    }
+}
+
+/**
+ * Chooses the type of acceleration structure suited to the geometry of the 
+ * scene. A grid builds dozens of times faster than a hierarchy but traces 
+ * each ray a few times slower, so it only pays off when there is a lot of 
+ * geometry for the rays of a frame, such as when a large scene moves every 
+ * frame. Grids also need geometry of similar size, since each piece then 
+ * overlaps a few cells; a single grid suits geometry spread over the whole 
+ * scene, and a two-level grid geometry gathered in clusters. Everything else
+ * uses the 4-wide bounding volume hierarchy.
+ * 
+ * 1. The rays of a frame are estimated from the resolution and the samples 
+ *       per pixel
+ * 2. The spread of sizes is the standard deviation of the diagonals of the 
+ *       geometry boxes relative to their mean
+ * 3. The clustering is the share of empty cells when the centers of the 
+ *       geometry are counted in a coarse grid over the scene
+ * 4. The mean diagonal must not exceed the side of the space each piece of
+ *       geometry gets when the occupied cells are shared equally, 
+ *       (occupied volume / count)^(1/3)
+ * 
+ * @return Flag of the type of acceleration structure to build
+ */
+int RayTracer::chooseAccelerationType(){
+    int geometry_count = this->scene_->getGeoListSize();
+    double ray_count = (double)this->scene_->getWidthResolution() * this->scene_->getHeightResolution() * this->samples_per_pixel_;
+    if(geometry_count < AUTOMATIC_GRID_MIN_GEOMETRY || ray_count > geometry_count * AUTOMATIC_GRID_MAX_RAYS_PER_GEOMETRY){
+        return 2;
+    }
+    
+    double diagonal_sum = 0;
+    double diagonal_square_sum = 0;
+    for (int i = 0; i < geometry_count; i++) {
+        BoundingBox bounds = this->scene_->getGeoAt(i)->getBounds();
+        Point3D min = bounds.getMin();
+        Point3D max = bounds.getMax();
+        double diagonal = min.computeDistance(&max);
+        diagonal_sum += diagonal;
+        diagonal_square_sum += diagonal * diagonal;
+    }
+    double diagonal_mean = diagonal_sum / geometry_count;
+    double diagonal_variance = std::max(0.0, diagonal_square_sum / geometry_count - diagonal_mean * diagonal_mean);
+    if(diagonal_mean <= 0 || sqrt(diagonal_variance) / diagonal_mean > AUTOMATIC_GRID_MAX_SIZE_VARIATION){
+        return 2;
+    }
+    
+    BoundingBox scene_bounds = this->scene_->getBounds();
+    Point3D scene_min = scene_bounds.getMin();
+    Point3D scene_max = scene_bounds.getMax();
+    double extent[3] = {scene_max.getX() - scene_min.getX(), scene_max.getY() - scene_min.getY(), scene_max.getZ() - scene_min.getZ()};
+    int resolution = AUTOMATIC_GRID_HISTOGRAM_RESOLUTION;
+    std::vector<char> occupied(resolution * resolution * resolution, 0);
+    for (int i = 0; i < geometry_count; i++) {
+        Point3D center = this->scene_->getGeoAt(i)->getBounds().getCenter();
+        double position[3] = {center.getX() - scene_min.getX(), center.getY() - scene_min.getY(), center.getZ() - scene_min.getZ()};
+        int cell[3];
+        for (int axis = 0; axis < 3; axis++) {
+            cell[axis] = extent[axis] > 0 ? std::min(resolution - 1, (int)(position[axis] / extent[axis] * resolution)) : 0;
+        }
+        occupied[(cell[2] * resolution + cell[1]) * resolution + cell[0]] = 1;
+    }
+    
+    //Flat scenes can only fill the cells of one slice of the histogram
+    int cell_count = 1;
+    double measure = 1;
+    int dimension_count = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        if(extent[axis] > 0){
+            cell_count *= resolution;
+            measure *= extent[axis];
+            dimension_count++;
+        }
+    }
+    int occupied_count = 0;
+    for (unsigned int i = 0; i < occupied.size(); i++) {
+        occupied_count += occupied[i];
+    }
+    
+    //Geometry larger than the space each piece gets to itself in the occupied
+    //part of the scene spans many cells
+    double occupied_measure = measure * occupied_count / cell_count;
+    if(dimension_count == 0 || diagonal_mean > pow(occupied_measure / geometry_count, 1.0 / dimension_count)){
+        return 2;
+    }
+    if(occupied_count < cell_count * (1 - AUTOMATIC_GRID_MAX_EMPTY_FRACTION)){
+        return 4;
+    }
+    return 3;
+}
+
+/**
+ * Brings the acceleration structure up to date with the geometry of the 
+ * scene. It is refit if geometry was edited, and rebuilt if it does not 
+ * exist yet, is of another type, or geometry was added.
+ * 
+ * @param geometry_edited Flag indicating whether geometry was edited since the structure was last updated
+ */
+void RayTracer::updateAccelerationStructure(bool geometry_edited){
+    if(this->acceleration_structure_ == NULL || 
+       (this->acceleration_type_ >= 0 && this->acceleration_structure_->getType() != this->acceleration_type_) ||
+       this->acceleration_structure_->getGeometryCount() != this->scene_->getGeoListSize()){
+        buildAccelerationStructure();
+    } else if(geometry_edited){
+        this->acceleration_structure_->refit();
+    }
+}
+
+/**
+ * Sets up the per-frame data read while tracing: a new G-Buffer if one is 
+ * kept, a new AOV buffer if any output channel is kept, and the projection 
+ * grid of an orthographic camera
+ */
+void RayTracer::prepareFrame(){
+    delete this->g_buffer_;
+    this->g_buffer_ = NULL;
+    if(this->keep_g_buffer_){
+        this->g_buffer_ = new GBuffer(this->scene_->getWidthResolution(), this->scene_->getHeightResolution());
+    }
+    
+    delete this->aov_buffer_;
+    this->aov_buffer_ = NULL;
+    for (int i = 0; i < AOV_CHANNEL_COUNT; i++) {
+        if(this->output_channels_[i]){
+            if(this->aov_buffer_ == NULL){
+                this->aov_buffer_ = new AovBuffer(this->scene_->getWidthResolution(), this->scene_->getHeightResolution());
+            }
+            this->aov_buffer_->enableChannel(i);
+        }
+    }
+    
+    if(this->scene_->getCamera()->getType() == 1){
+        this->projection_grid_ = new ProjectionGrid(this->scene_, PROJECTION_BIN_SIZE);
+    }
+}
+
+/**
+ * Frees the per-frame data that is not kept once the frame is traced
+ */
+void RayTracer::finishFrame(){
+    delete this->projection_grid_;
+    this->projection_grid_ = NULL;
+}
+
+/**
+ * Traces every pixel of the image into the frame buffer, row by row until
+ * the render is cancelled
+ */
+void RayTracer::renderFrame(){
+    prepareFrame();
+    
+    for (int y = 0; y < this->frame_buffer_->getHeight() && !this->cancelled_; y++) {
+        for (int x = 0; x < this->frame_buffer_->getWidth(); x++) {
+            this->frame_buffer_->setPixel(x, y, renderPixel(x, y));
+        }
+    }
+    
+    finishFrame();
+}
+
+/**
+ * Traces the image straight into a mapped file, split into square tiles 
+ * shared out to one thread per hardware thread. Each finished tile is written
+ * into the file, and each finished row of tiles is released from memory, so 
+ * only the rows of tiles being traced stay resident whatever the size of the
+ * image (a kept G-Buffer still covers the whole image).
+ * 
+ * @param image_writer Mapped file with headers matching the resolution of the scene
+ */
+void RayTracer::renderTiles(MappedPpmWriter* image_writer){
+    if(image_writer->getWidth() != this->scene_->getWidthResolution() || 
+       image_writer->getHeight() != this->scene_->getHeightResolution()){
+        throw std::logic_error("The headers of the mapped file must match the resolution of the scene.");
+    }
+    
+    prepareFrame();
+    
+    TileProgress progress;
+    progress.tile_count_x = (image_writer->getWidth() + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    progress.tile_count_y = (image_writer->getHeight() + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    progress.next_tile = 0;
+    progress.remaining_tiles.assign(progress.tile_count_y, progress.tile_count_x);
+    
+    int thread_count = std::thread::hardware_concurrency();
+    thread_count = std::max(1, std::min(thread_count, progress.tile_count_x * progress.tile_count_y));
+    std::vector<std::thread> threads;
+    for (int i = 1; i < thread_count; i++) {
+        threads.push_back(std::thread(&RayTracer::renderTileWorker, this, image_writer, &progress));
+    }
+    renderTileWorker(image_writer, &progress);
+    for (unsigned int i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    
+    finishFrame();
+}
+
+/**
+ * Traces tiles of a tiled render until none are left. Tiles are taken in 
+ * reading order, so the threads work on neighbouring rows of tiles. Each row
+ * of a tile is post processed before the tile is written.
+ * 
+ * @param image_writer Mapped file receiving the tiles
+ * @param progress Progress of the render shared by all threads
+ */
+void RayTracer::renderTileWorker(MappedPpmWriter* image_writer, TileProgress* progress){
+    std::vector<float> tile_samples(3 * RENDER_TILE_SIZE * RENDER_TILE_SIZE);
+    int tile_count = progress->tile_count_x * progress->tile_count_y;
+    for (int tile = progress->next_tile++; tile < tile_count && !this->cancelled_; tile = progress->next_tile++) {
+        int tile_y = tile / progress->tile_count_x;
+        int first_x = (tile % progress->tile_count_x) * RENDER_TILE_SIZE;
+        int first_y = tile_y * RENDER_TILE_SIZE;
+        int tile_width = std::min(RENDER_TILE_SIZE, image_writer->getWidth() - first_x);
+        int tile_height = std::min(RENDER_TILE_SIZE, image_writer->getHeight() - first_y);
+        
+        for (int y = 0; y < tile_height; y++) {
+            float* row = &tile_samples[3 * y * tile_width];
+            for (int x = 0; x < tile_width; x++) {
+                RgbColor pixel_color = renderPixel(first_x + x, first_y + y);
+                row[3 * x] = pixel_color.getRed();
+                row[3 * x + 1] = pixel_color.getGreen();
+                row[3 * x + 2] = pixel_color.getBlue();
+            }
+            this->post_process_->processRow(row, row, tile_width, first_x, first_y + y);
+        }
+        image_writer->writeTile(first_x, first_y, tile_width, tile_height, &tile_samples[0]);
+        
+        bool row_finished;
+        {
+            std::lock_guard<std::mutex> lock(progress->mutex);
+            row_finished = --progress->remaining_tiles[tile_y] == 0;
+        }
+        if(row_finished){
+            image_writer->releaseRows(first_y, tile_height);
+        }
+    }
+}
+
+/**
+ * Traces the pixels of a region of the image into raw samples, before post
+ * processing, for a render split across processes. The frame must have been
+ * prepared, as done by prepareRegions.
+ * 
+ * @param first_x Column of the left of the region
+ * @param first_y Row of the top of the region
+ * @param width Width of the region
+ * @param height Height of the region
+ * @param samples Receives the red, green and blue samples of the region, row by row
+ */
+void RayTracer::renderRegion(int first_x, int first_y, int width, int height, float* samples){
+    for (int y = 0; y < height && !this->cancelled_; y++) {
+        float* row = &samples[3 * y * width];
+        for (int x = 0; x < width; x++) {
+            RgbColor pixel_color = renderPixel(first_x + x, first_y + y);
+            row[3 * x] = pixel_color.getRed();
+            row[3 * x + 1] = pixel_color.getGreen();
+            row[3 * x + 2] = pixel_color.getBlue();
+        }
+    }
+}
+
+/**
+ * Compiles the scene, builds or updates its acceleration structure and 
+ * prepares a frame, so regions of the image can then be traced with 
+ * renderRegion. The frame is ended with finishFrame.
+ */
+void RayTracer::prepareRegions(){
+    this->scene_->compile();
+    
+    std::vector<Geometry*> edited_geometry;
+    this->scene_->getEditedGeometry(&edited_geometry);
+    updateAccelerationStructure(!edited_geometry.empty());
+    this->scene_->clearEdits();
+    
+    prepareFrame();
+}
+
+/**
+ * Traces again only the tiles of the image that may have changed since the 
+ * last render because geometry was edited through its setters (or added), 
+ * then writes the color data of the whole image to the file writer. The 
+ * changed region is found conservatively:
+ * 
+ * 1. The screen area of each edited geometry, before and after the edit
+ * 2. For geometry that moved or changed shape, the screen area of the shadows
+ *       it casts, found by extruding its box away from each light until it 
+ *       leaves the scene
+ * 3. The screen area of every reflective or refractive geometry, since the 
+ *       edits may be seen through them
+ * 
+ * The whole image is traced if the camera has an aperture, the scene has area
+ * lights and geometry moved, or an edited region cannot be projected. Edits 
+ * to the camera or lights are not tracked and need a new run (or relight).
+ * 
+ * @return Number of tiles traced
+ */
+int RayTracer::update(){
+    if(this->frame_buffer_ == NULL || 
+       this->frame_buffer_->getWidth() != this->scene_->getWidthResolution() || 
+       this->frame_buffer_->getHeight() != this->scene_->getHeightResolution()){
+        run();
+        return ((this->scene_->getWidthResolution() + UPDATE_TILE_SIZE - 1) / UPDATE_TILE_SIZE) * 
+               ((this->scene_->getHeightResolution() + UPDATE_TILE_SIZE - 1) / UPDATE_TILE_SIZE);
+    }
+    
+    int tile_count_x = (this->frame_buffer_->getWidth() + UPDATE_TILE_SIZE - 1) / UPDATE_TILE_SIZE;
+    int tile_count_y = (this->frame_buffer_->getHeight() + UPDATE_TILE_SIZE - 1) / UPDATE_TILE_SIZE;
+    std::vector<char> edited_tiles(tile_count_x * tile_count_y, 0);
+    
+    std::vector<Geometry*> edited_geometry;
+    this->scene_->getEditedGeometry(&edited_geometry);
+    if(!edited_geometry.empty()){
+        this->scene_->compile();
+        computeEditedTiles(&edited_geometry, &edited_tiles, tile_count_x, tile_count_y);
+        updateAccelerationStructure(true);
+    }
+    this->scene_->clearEdits();
+    
+    if(this->scene_->getCamera()->getType() == 1){
+        this->projection_grid_ = new ProjectionGrid(this->scene_, PROJECTION_BIN_SIZE);
+    }
+    
+    int traced_tile_count = 0;
+    for (int tile_y = 0; tile_y < tile_count_y; tile_y++) {
+        for (int tile_x = 0; tile_x < tile_count_x; tile_x++) {
+            if(!edited_tiles[tile_y * tile_count_x + tile_x]){
+                continue;
+            }
+            
+            int end_x = std::min((tile_x + 1) * UPDATE_TILE_SIZE, this->frame_buffer_->getWidth());
+            int end_y = std::min((tile_y + 1) * UPDATE_TILE_SIZE, this->frame_buffer_->getHeight());
+            for (int y = tile_y * UPDATE_TILE_SIZE; y < end_y; y++) {
+                for (int x = tile_x * UPDATE_TILE_SIZE; x < end_x; x++) {
+                    this->frame_buffer_->setPixel(x, y, renderPixel(x, y));
+                }
+            }
+            traced_tile_count++;
+        }
+    }
+    writeFrameBuffer();
+    
+    delete this->projection_grid_;
+    this->projection_grid_ = NULL;
+    
+    return traced_tile_count;
+}
+
+/**
+ * Marks the tiles of the image that may have changed because of the edits to
+ * the given geometry (see update)
+ * 
+ * @param edited_geometry Geometry edited since the last render
+ * @param edited_tiles Flags of the tiles to trace again, row by row
+ * @param tile_count_x Number of tiles across the image
+ * @param tile_count_y Number of tiles down the image
+ */
+void RayTracer::computeEditedTiles(std::vector<Geometry*>* edited_geometry, std::vector<char>* edited_tiles, int tile_count_x, int tile_count_y){
+    bool whole_image = this->scene_->getCamera()->hasAperture();
+    
+    //Extruding a box by the size of the scene carries its shadow past every surface that can receive it
+    BoundingBox scene_bounds = this->scene_->getBounds();
+    for (unsigned int i = 0; i < edited_geometry->size(); i++) {
+        scene_bounds.expand((*edited_geometry)[i]->getEditedBounds());
+    }
+    Point3D scene_min = scene_bounds.getMin();
+    Point3D scene_max = scene_bounds.getMax();
+    double extrusion_length = scene_min.computeDistance(&scene_max);
+    
+    std::vector<Point3D> region;
+    for (unsigned int i = 0; i < edited_geometry->size() && !whole_image; i++) {
+        BoundingBox edited_bounds = (*edited_geometry)[i]->getEditedBounds();
+        region.clear();
+        for (int corner = 0; corner < 8; corner++) {
+            region.push_back(edited_bounds.getCorner(corner));
+        }
+        whole_image = !markProjectedRegion(&region, edited_tiles, tile_count_x, tile_count_y);
+        
+        if(!(*edited_geometry)[i]->hasMoved()){
+            continue;
+        }
+        
+        for (int j = 0; j < this->scene_->getLightListSize() && !whole_image; j++) {
+            Light* light = this->scene_->getLightAt(j);
+            int light_type = light->getType();
+            if(light_type == 0){ //Ambient lights cast no shadows
+                continue;
+            } else if(light_type == 4 || light_type == 5){ //Area light penumbrae are not tracked
+                whole_image = true;
+                break;
+            }
+            
+            region.clear();
+            for (int corner = 0; corner < 8; corner++) {
+                Point3D corner_point = edited_bounds.getCorner(corner);
+                Vector3D direction_from_light;
+                if(light_type == 1){ //Directional
+                    direction_from_light = light->getDirectionToLight() * -1;
+                } else { //Point or Spot
+                    Point3D* light_position = static_cast<PointLight*>(light)->getPosition();
+                    if(edited_bounds.contains(light_position)){
+                        whole_image = true;
+                        break;
+                    }
+                    direction_from_light = light_position->computeDirection(&corner_point, false);
+                }
+                direction_from_light.normalize();
+                Vector3D extrusion = direction_from_light * extrusion_length;
+                region.push_back(corner_point);
+                region.push_back(corner_point.translate(&extrusion));
+            }
+            whole_image = whole_image || !markProjectedRegion(&region, edited_tiles, tile_count_x, tile_count_y);
+        }
+    }
+    
+    for (int i = 0; i < this->scene_->getGeoListSize() && !whole_image; i++) {
+        Geometry* geometry = this->scene_->getGeoAt(i);
+        if(!geometry->hasReflection() && !geometry->hasRefraction()){
+            continue;
+        }
+        BoundingBox bounds = geometry->getBounds();
+        region.clear();
+        for (int corner = 0; corner < 8; corner++) {
+            region.push_back(bounds.getCorner(corner));
+        }
+        whole_image = !markProjectedRegion(&region, edited_tiles, tile_count_x, tile_count_y);
+    }
+    
+    if(whole_image){
+        std::fill(edited_tiles->begin(), edited_tiles->end(), 1);
+    }
+}
+
+/**
+ * Marks the tiles covered by the screen area enclosing the given points. The
+ * area is grown by a pixel to cover the samples spread over each pixel, and 
+ * the tiles marked are bounded by the tile counts.
+ * 
+ * @param region Points in 3D space enclosing the region
+ * @param edited_tiles Flags of the tiles to trace again, row by row
+ * @param tile_count_x Number of tiles across the image
+ * @param tile_count_y Number of tiles down the image
+ * @return Flag indicating whether the region could be projected onto the image
+ */
+bool RayTracer::markProjectedRegion(std::vector<Point3D>* region, std::vector<char>* edited_tiles, int tile_count_x, int tile_count_y){
+    double min_x = INFINITY, min_y = INFINITY;
+    double max_x = -INFINITY, max_y = -INFINITY;
+    for (unsigned int i = 0; i < region->size(); i++) {
+        double x, y;
+        if(!this->scene_->getCamera()->projectPoint(&(*region)[i], x, y)){
+            return false;
+        }
+        min_x = std::min(min_x, x);
+        min_y = std::min(min_y, y);
+        max_x = std::max(max_x, x);
+        max_y = std::max(max_y, y);
+    }
+    
+    //The region lies entirely outside of the image
+    if(max_x < -1 || max_y < -1 || min_x > this->frame_buffer_->getWidth() || min_y > this->frame_buffer_->getHeight()){
+        return true;
+    }
+    
+    int first_tile_x = (int)std::max(floor(min_x - 1), 0.0) / UPDATE_TILE_SIZE;
+    int first_tile_y = (int)std::max(floor(min_y - 1), 0.0) / UPDATE_TILE_SIZE;
+    int last_tile_x = std::min((int)std::min(ceil(max_x + 1), this->frame_buffer_->getWidth() - 1.0) / UPDATE_TILE_SIZE, tile_count_x - 1);
+    int last_tile_y = std::min((int)std::min(ceil(max_y + 1), this->frame_buffer_->getHeight() - 1.0) / UPDATE_TILE_SIZE, tile_count_y - 1);
+    for (int tile_y = first_tile_y; tile_y <= last_tile_y; tile_y++) {
+        for (int tile_x = first_tile_x; tile_x <= last_tile_x; tile_x++) {
+            (*edited_tiles)[tile_y * tile_count_x + tile_x] = 1;
+        }
+    }
+    return true;
+}
+
+/**
+ * Shades the image again from the G-Buffer recorded by the last run, then
+ * writes the color data to the file writer. No primary, reflection or 
+ * refraction rays are cast, only shadow rays, so this is much faster than 
+ * run when only the lights (or the colors of the geometry) have changed. 
+ * Changes to the position of geometry or the camera require a new run.
+ */
+void RayTracer::relight(){
+    if(this->g_buffer_ == NULL){
+        throw std::logic_error("A G-Buffer must be kept by a previous run before relighting.");
+    }
+    if(this->frame_buffer_ == NULL){
+        throw std::logic_error("A run writing to a mapped file keeps no frame buffer to relight.");
+    }
+    
+    this->scene_->compile();
+    
+    for (int y = 0; y < this->g_buffer_->getHeight(); y++) {
+        for (int x = 0; x < this->g_buffer_->getWidth(); x++) {
+            this->frame_buffer_->setPixel(x, y, relightPixel(x, y));
+        }
+    }
+    writeFrameBuffer();
+}
+
+/**
+ * Writes the color data of every pixel in the frame buffer to the file writer,
+ * post processed into a separate buffer
+ */
+void RayTracer::writeFrameBuffer(){
+    FrameBuffer written_frame_buffer(this->frame_buffer_->getWidth(), this->frame_buffer_->getHeight());
+    postProcessFrameBuffer(this->frame_buffer_, &written_frame_buffer);
+    addFrameBuffer(this->file_writer_, &written_frame_buffer);
+}
+
+/**
+ * Fills the frame buffer to write with the post processed colors of a traced
+ * frame buffer. A PFM file keeps the colors as traced, since its floats are 
+ * not limited to the displayable range.
+ * 
+ * @param frame_buffer Frame buffer of the traced colors
+ * @param written_frame_buffer Frame buffer to write, of the same size
+ */
+void RayTracer::postProcessFrameBuffer(FrameBuffer* frame_buffer, FrameBuffer* written_frame_buffer){
+    if(this->file_writer_->getType() == 2){
+        for (int y = 0; y < frame_buffer->getHeight(); y++) {
+            memcpy(written_frame_buffer->getRow(y), frame_buffer->getRow(y), 3 * frame_buffer->getWidth() * sizeof(float));
+        }
+        return;
+    }
+    this->post_process_->apply(frame_buffer, written_frame_buffer);
+}
+
+/**
+ * Adds the color data of every pixel in a frame buffer to a file writer whose
+ * headers are defined. Binary writers take the colors directly; only the 
+ * ASCII PPM writer needs them formatted as text.
+ * 
+ * @param file_writer File writer to add the pixels to
+ * @param frame_buffer Frame buffer to add
+ */
+void RayTracer::addFrameBuffer(FileWriter* file_writer, FrameBuffer* frame_buffer){
+    switch(file_writer->getType()){
+        case 1: //Mapped Binary PPM
+            static_cast<MappedPpmWriter*>(file_writer)->writeTile(0, 0, frame_buffer->getWidth(), frame_buffer->getHeight(), frame_buffer->getRow(0));
+            break;
+        case 2: //PFM
+            static_cast<PfmWriter*>(file_writer)->addFrameBuffer(frame_buffer);
+            break;
+        case 3: //Binary PPM
+            static_cast<BinaryPpmWriter*>(file_writer)->addFrameBuffer(frame_buffer);
+            break;
+        case 4: //Stream
+            static_cast<StreamWriter*>(file_writer)->addFrameBuffer(frame_buffer);
+            break;
+        default: //ASCII PPM
+            file_writer->addContent(formatFrameBuffer(frame_buffer));
+            break;
+    }
+}
+
+/**
+ * Formats the color data of every pixel in a frame buffer as text
+ * 
+ * @param frame_buffer Frame buffer to format
+ * @return Color data of the pixels, one row of the image per line
+ */
+std::string RayTracer::formatFrameBuffer(FrameBuffer* frame_buffer){
+    std::stringstream color_datastream;
+    for (int y = 0; y < frame_buffer->getHeight(); y++) {
+        for (int x = 0; x < frame_buffer->getWidth(); x++) {
+            RgbColor pixel_color = frame_buffer->getPixel(x, y);
+            
+            //Note: Output to the file is a give and take situation
+            //We can write the image data to MEMORY and write to DISK with a fast computation time
+            //We can write the image data to DISK at every pixel to save MEMORY, but slow down computation time
+            //Write to MEMORY(512x512): 5s    Write to DISK(512x512): 1m 40s
+            color_datastream << pixel_color.getRed() << ' ' << pixel_color.getGreen() << ' ' << pixel_color.getBlue() << "    ";
+        }
+        color_datastream << std::endl;
+    }
+    return color_datastream.str();
+}
+
+/**
+ * Names the file of a frame from a pattern holding exactly one field for the
+ * frame number: "%d", or "%Nd" / "%0Nd" to pad the number to N digits with 
+ * spaces or zeros. "%%" stands for a percent sign. The pattern is never used
+ * as a printf format, so any other field is refused.
+ * 
+ * @param filename_pattern Pattern of the file names (e.g. "frame_%04d.ppm")
+ * @param frame Frame number
+ * @return Name of the file of the frame
+ */
+std::string RayTracer::formatFrameFilename(std::string filename_pattern, int frame){
+    std::string filename;
+    int field_count = 0;
+    for (unsigned int i = 0; i < filename_pattern.size(); i++) {
+        if(filename_pattern[i] != '%'){
+            filename += filename_pattern[i];
+            continue;
+        }
+        if(i + 1 < filename_pattern.size() && filename_pattern[i + 1] == '%'){
+            filename += '%';
+            i++;
+            continue;
+        }
+        
+        unsigned int end = i + 1;
+        bool zero_padded = end < filename_pattern.size() && filename_pattern[end] == '0';
+        int width = 0;
+        while(end < filename_pattern.size() && isdigit((unsigned char)filename_pattern[end]) && width < FILENAME_MAX){
+            width = width * 10 + (filename_pattern[end] - '0');
+            end++;
+        }
+        if(end >= filename_pattern.size() || filename_pattern[end] != 'd' || width >= FILENAME_MAX){
+            throw std::invalid_argument("The filename pattern \"" + filename_pattern + "\" may only hold %d, %Nd or %0Nd fields.");
+        }
+        
+        std::ostringstream number;
+        number << std::setw(width) << std::setfill(zero_padded ? '0' : ' ') << std::internal << frame;
+        filename += number.str();
+        field_count++;
+        i = end;
+    }
+    if(field_count != 1){
+        throw std::invalid_argument("The filename pattern \"" + filename_pattern + "\" must hold exactly one field for the frame number.");
+    }
+    return filename;
+}
+
+/**
+ * Writes a frame buffer to a new file, headers included. A stream writer
+ * instead appends the frame to the stream it keeps open. Runs on its own
+ * thread while renderSequence traces the next frame, so errors are stored 
+ * for renderSequence to throw rather than thrown on the thread.
+ * 
+ * @param file_writer File writer to write the frame with
+ * @param frame_buffer Frame buffer to write
+ * @param filename Name of the file to write the frame to
+ * @param error Set to the error raised while writing, if any
+ */
+void RayTracer::writeFrame(FileWriter* file_writer, FrameBuffer* frame_buffer, std::string filename, std::exception_ptr* error){
+    try {
+        file_writer->setFilename(filename);
+        file_writer->init();
+        file_writer->defineHeaders(frame_buffer->getWidth(), frame_buffer->getHeight(), 255);
+        addFrameBuffer(file_writer, frame_buffer);
+        file_writer->close();
+    } catch ( ... ) {
+        *error = std::current_exception();
+    }
+}
+
+/**
+ * Shades a single pixel again from its G-Buffer nodes. The nodes are shaded
+ * from last to first, so the colors gathered by the reflection and refraction
+ * rays of a node are known before the node itself is shaded, and are combined
+ * exactly as trace combined them.
+ * 
+ * @param x X-coordinate of the pixel
+ * @param y Y-coordinate of the pixel
+ * @return Color of the pixel
+ */
+RgbColor RayTracer::relightPixel(int x, int y){
+    std::vector<GBufferNode>* nodes = this->g_buffer_->getPixelNodes(x, y);
+    PathState path_state(y * this->g_buffer_->getWidth() + x);
+    
+    std::vector<RgbColor> node_colors(nodes->size(), RgbColor(0,0,0));
+    for (int i = nodes->size() - 1; i >= 0; i--) {
+        GBufferNode* node = &(*nodes)[i];
+        RgbColor node_color;
+        if(node->geometry == NULL){
+            node_color = this->scene_->getBackgroundColor();
+        } else {
+            switch(node->geometry->getShaderType()){
+                case 0: //Constant Shader
+                    node_color = node->geometry->getDiffuseColor();
+                    break;
+                case 1: //Phong Shader
+                    node_color = computeDirectLighting(node->geometry, &node->direction_to_eye, &node->position, &node->normal, node_colors[i], &path_state);
+                    break;
+            }
+        }
+        
+        //Colors gathered by secondary rays are summed into their parent's entry
+        if(node->parent_index >= 0){
+            node_colors[node->parent_index] = node_colors[node->parent_index] + (node->weight * node_color) * node->weight_scale;
+        }
+        node_colors[i] = node_color;
+    }
+    
+    RgbColor pixel_color(0,0,0);
+    int sample_count = 0;
+    for (unsigned int i = 0; i < nodes->size(); i++) {
+        if((*nodes)[i].parent_index < 0){
+            pixel_color = pixel_color + node_colors[i];
+            sample_count++;
+        }
+    }
+    
+    for (int i = 0; i < RAY_TYPE_COUNT; i++) {
+        this->ray_counts_[i] += path_state.getRayCount(i);
+    }
+    
+    if(sample_count > 1){
+        pixel_color = pixel_color * (1.0 / sample_count);
+    }
+    return pixel_color;
+}
+
+/**
+ * Computes the color of a single pixel by averaging the colors of its samples.
+ * With more than one sample per pixel, the samples are spread over the pixel 
+ * using a Halton sequence. When the camera has an aperture, the samples are also 
+ * spread over the lens, with each of the pixel's samples taking its own stratum
+ * of the lens so a few samples already cover the whole aperture. Both patterns 
+ * are shifted by a random offset per pixel so neighboring pixels do not repeat 
+ * the same pattern. A single sample through a pinhole camera is cast through 
+ * the exact center of the pixel.
+ * 
+ * @param x X-coordinate of the pixel
+ * @param y Y-coordinate of the pixel
+ * @return Color of the pixel
+ */
+RgbColor RayTracer::renderPixel(int x, int y){
+    bool has_aperture = this->scene_->getCamera()->hasAperture();
+    PathState path_state(y * this->scene_->getWidthResolution() + x);
+    if(this->g_buffer_ != NULL){
+        path_state.setGBufferNodes(this->g_buffer_->getPixelNodes(x, y));
+        path_state.getGBufferNodes()->clear();
+    }
+    
+    double pixel_shift_x = 0, pixel_shift_y = 0;
+    if(this->samples_per_pixel_ > 1){
+        pixel_shift_x = path_state.getSampler()->nextDouble();
+        pixel_shift_y = path_state.getSampler()->nextDouble();
+    }
+    double lens_shift_u = 0, lens_shift_v = 0;
+    if(has_aperture){
+        lens_shift_u = path_state.getSampler()->nextDouble();
+        lens_shift_v = path_state.getSampler()->nextDouble();
+    }
+    
+    //Output variables are taken from the first primary ray only
+    AovSample aov_sample;
+    if(this->aov_buffer_ != NULL){
+        path_state.setAovSample(&aov_sample);
+    }
+    
+    RgbColor pixel_color(0,0,0);
+    for (int sample = 0; sample < this->samples_per_pixel_; sample++) {
+        double sample_x = x;
+        double sample_y = y;
+        if(this->samples_per_pixel_ > 1){
+            double offset_x = Sampler::radicalInverse(2, sample) + pixel_shift_x;
+            double offset_y = Sampler::radicalInverse(3, sample) + pixel_shift_y;
+            sample_x += (offset_x - floor(offset_x)) - 0.5;
+            sample_y += (offset_y - floor(offset_y)) - 0.5;
+        }
+        
+        double lens_u = 0.5;
+        double lens_v = 0.5;
+        if(has_aperture){
+            lens_u = (sample + 0.5) / this->samples_per_pixel_ + lens_shift_u;
+            lens_v = Sampler::radicalInverse(5, sample) + lens_shift_v;
+            lens_u = lens_u - floor(lens_u);
+            lens_v = lens_v - floor(lens_v);
+        }
+        
+        path_state.setCurrentNode(-1);
+        path_state.setRayBudget(this->ray_budget_);
+        path_state.countRay(0);
+        Ray* primary_ray = generatePrimaryRay(sample_x, sample_y, lens_u, lens_v);
+        pixel_color = pixel_color + trace(primary_ray, 1, 1.0, &path_state);
+    }
+    
+    for (int i = 0; i < RAY_TYPE_COUNT; i++) {
+        this->ray_counts_[i] += path_state.getRayCount(i);
+    }
+    if(this->aov_buffer_ != NULL){
+        this->aov_buffer_->setSample(x, y, &aov_sample);
+    }
+    
+    if(this->samples_per_pixel_ > 1){
+        pixel_color = pixel_color * (1.0 / this->samples_per_pixel_);
+    }
+    return pixel_color;
+}
+
+/**
+ * Sets the number of rays cast through each pixel. The colors of the rays are
+ * averaged, which smooths edges and, with a camera aperture, gives depth of field.
+ * 
+ * @param samples_per_pixel Number of rays cast through each pixel
+ */
+void RayTracer::setSamplesPerPixel(int samples_per_pixel){
+    this->samples_per_pixel_ = samples_per_pixel;
+}
+
+/**
+ * Gets the number of rays cast through each pixel
+ * 
+ * @return Number of rays cast through each pixel
+ */
+int RayTracer::getSamplesPerPixel(){
+    return this->samples_per_pixel_;
+}
+
+/**
+ * Sets the maximum level of recursive ray casting. Primary rays are level 1,
+ * so a depth of 2 allows two bounces off of reflective geometry.
+ * 
+ * @param max_ray_depth Maximum level of recursive ray casting
+ */
+void RayTracer::setMaxRayDepth(int max_ray_depth){
+    this->max_ray_depth_ = max_ray_depth;
+}
+
+/**
+ * Gets the maximum level of recursive ray casting
+ * 
+ * @return Maximum level of recursive ray casting
+ */
+int RayTracer::getMaxRayDepth(){
+    return this->max_ray_depth_;
+}
+
+/**
+ * Sets the throughput below which a ray path is no longer extended. The 
+ * throughput of a path is the product of the reflective weights (0-1) of every 
+ * surface the path has bounced off of, so it bounds how much the rest of 
+ * the path could still add to the pixel.
+ * 
+ * @param throughput_threshold Minimum throughput for a path to be extended (0-1)
+ */
+void RayTracer::setThroughputThreshold(double throughput_threshold){
+    this->throughput_threshold_ = throughput_threshold;
+}
+
+/**
+ * Gets the throughput below which a ray path is no longer extended
+ * 
+ * @return Minimum throughput for a path to be extended (0-1)
+ */
+double RayTracer::getThroughputThreshold(){
+    return this->throughput_threshold_;
+}
+
+/**
+ * Enables or disables Russian roulette termination. When enabled, paths 
+ * falling below the throughput threshold are randomly kept alive and 
+ * reweighted instead of always being cut, keeping the image unbiased.
+ * 
+ * @param enabled Flag enabling Russian roulette termination
+ */
+void RayTracer::setRussianRoulette(bool enabled){
+    this->russian_roulette_ = enabled;
+}
+
+/**
+ * Gets whether Russian roulette termination is enabled
+ * 
+ * @return Flag indicating whether Russian roulette termination is enabled
+ */
+bool RayTracer::getRussianRoulette(){
+    return this->russian_roulette_;
+}
+
+/**
+ * Sets the number of secondary rays (reflection and refraction) that may be
+ * spawned from a single primary ray. Once a path has used its budget no further
+ * rays are spawned, which keeps scenes with many refractive objects from 
+ * doubling the number of rays at every bounce.
+ * 
+ * @param ray_budget Maximum number of secondary rays per primary ray
+ */
+void RayTracer::setRayBudget(int ray_budget){
+    this->ray_budget_ = ray_budget;
+}
+
+/**
+ * Gets the number of secondary rays that may be spawned from a single primary ray
+ * 
+ * @return Maximum number of secondary rays per primary ray
+ */
+int RayTracer::getRayBudget(){
+    return this->ray_budget_;
+}
 
-RayTracer::RayTracer(Scene* scene, FileWriter* file_writer){
-    this->scene_ = scene;
-    this->file_writer_ = file_writer;
+/**
+ * Sets the number of point and spot lights sampled at each shaded point. 
+ * With 0 every light in range is evaluated. Otherwise only the given number 
+ * of lights is picked from the light hierarchy, in proportion to their 
+ * estimated contribution, and their weighted colors average out to the sum
+ * over all lights. This caps the cost of shading a point no matter how many
+ * lights overlap it, at the price of noise that more samples per pixel smooth.
+ * 
+ * @param light_sample_count Number of lights sampled per point (0 for all lights)
+ */
+void RayTracer::setLightSampleCount(int light_sample_count){
+    this->light_sample_count_ = light_sample_count;
 }
 
-RayTracer::~RayTracer(){
-    delete this->scene_;
-    delete this->file_writer_;
+/**
+ * Gets the number of point and spot lights sampled at each shaded point
+ * 
+ * @return Number of lights sampled per point (0 for all lights)
+ */
+int RayTracer::getLightSampleCount(){
+    return this->light_sample_count_;
 }
 
 /**
- * Iterates over each pixel in the image. Casts a ray through the center of the 
- * pixel on the focal plane, computes the color of the pixel using the ray, and 
- * writes the color data to the file writer
+ * Replaces the file writer receiving the images, e.g. to render the same
+ * scene to another file. The ray tracer takes ownership of the new writer 
+ * and deletes the old one.
+ * 
+ * @param file_writer File writer with headers matching the resolution of the scene
  */
-void RayTracer::run(){
-    std::stringstream color_datastream;
-    for (int y = 0; y < this->scene_->getHeightResolution(); y++) {
-        for (int x = 0; x < this->scene_->getWidthResolution(); x++) {
-            Ray* primary_ray = generatePrimaryRay(x, y);
-            RgbColor pixel_color = trace(primary_ray, 1);
-            
-            //Note: Output to the file is a give and take situation
-            //We can write the image data to MEMORY and write to DISK with a fast computation time
-            //We can write the image data to DISK at every pixel to save MEMORY, but slow down computation time
-            //Write to MEMORY(512x512): 5s    Write to DISK(512x512): 1m 40s
-            color_datastream << pixel_color.getRed() << ' ' << pixel_color.getGreen() << ' ' << pixel_color.getBlue() << "    ";
-        }
-        color_datastream << std::endl;
+void RayTracer::setFileWriter(FileWriter* file_writer){
+    if(file_writer != this->file_writer_){
+        delete this->file_writer_;
     }
-    this->file_writer_->addContent(color_datastream.str());
+    this->file_writer_ = file_writer;
 }
 
 /**
- * Normalizes the coordinate (scale between 0 and 1) and shifts it to center of pixel. 
- * This space is also known as Normalized Device Coordinate (NDC) space.
+ * Gets the file writer receiving the images
  * 
- * @param x X-coordinate of the pixel
- * @param y Y-coordinate of the pixel
+ * @return File writer of the ray tracer
+ */
+FileWriter* RayTracer::getFileWriter(){
+    return this->file_writer_;
+}
+
+/**
+ * Gets the scene rendered, so its camera and lights can be changed between 
+ * runs
+ * 
+ * @return Scene of the ray tracer
+ */
+Scene* RayTracer::getScene(){
+    return this->scene_;
+}
+
+/**
+ * Sets whether run keeps a G-Buffer of the surfaces hit by the rays of every
+ * pixel, so the image can be shaded again with relight after the lights change
+ * 
+ * @param keep_g_buffer Flag indicating whether to keep a G-Buffer
+ */
+void RayTracer::setKeepGBuffer(bool keep_g_buffer){
+    this->keep_g_buffer_ = keep_g_buffer;
+}
+
+/**
+ * Gets whether run keeps a G-Buffer
+ * 
+ * @return Flag indicating whether a G-Buffer is kept
+ */
+bool RayTracer::getKeepGBuffer(){
+    return this->keep_g_buffer_;
+}
+
+/**
+ * Sets the type of acceleration structure the geometry is sorted into (see 
+ * AccelerationStructure::getType). Takes effect at the next run.
+ * 
+ * Acceleration Structure Flag List (10/19/2016)
+ * 
+ * 0: Bounding Volume Hierarchy
+ * 1: Compressed Bounding Volume Hierarchy
+ * 2: 4-wide Bounding Volume Hierarchy
+ * 3: Uniform Grid
+ * 4: Two-Level Grid
+ * 
+ * -1: Chosen from the geometry of the scene at each build (see 
+ *        chooseAccelerationType)
+ * 
+ * @param acceleration_type Flag of the type of acceleration structure
+ */
+void RayTracer::setAccelerationType(int acceleration_type){
+    this->acceleration_type_ = acceleration_type;
+}
+
+/**
+ * Gets the type of acceleration structure the geometry is sorted into
+ * 
+ * @return Flag of the type of acceleration structure
+ */
+int RayTracer::getAccelerationType(){
+    return this->acceleration_type_;
+}
+
+/**
+ * Gets the acceleration structure built by the last render
+ * 
+ * @return Acceleration structure of the scene (NULL before the first render)
+ */
+AccelerationStructure* RayTracer::getAccelerationStructure(){
+    return this->acceleration_structure_;
+}
+
+/**
+ * Gets the post process turning the traced colors into the colors written,
+ * so its exposure, tone mapping, gamma and dithering can be set
+ * 
+ * @return Post process of the ray tracer
+ */
+PostProcess* RayTracer::getPostProcess(){
+    return this->post_process_;
+}
+
+/**
+ * Gets the G-Buffer recorded by the last run
+ * 
+ * @return G-Buffer of the last run (NULL if none was kept)
+ */
+GBuffer* RayTracer::getGBuffer(){
+    return this->g_buffer_;
+}
+
+/**
+ * Sets whether an output channel is filled while tracing. Every channel kept
+ * is filled in the same pass as the colors, from the surface hit by the first
+ * primary ray of each pixel.
+ * 
+ * Output Channel List (10/19/2016)
+ * 
+ * 0: Depth
+ * 1: Normal
+ * 2: Object Id
+ * 
+ * @param channel Flag of the channel
+ * @param enabled Whether the channel is filled by the next run
+ */
+void RayTracer::setOutputChannel(int channel, bool enabled){
+    this->output_channels_[channel] = enabled;
+}
+
+/**
+ * Gets whether an output channel is filled while tracing
+ * 
+ * @param channel Flag of the channel
+ * @return Whether the channel is filled by the next run
+ */
+bool RayTracer::getOutputChannel(int channel){
+    return this->output_channels_[channel];
+}
+
+/**
+ * Gets the output channels filled by the last run
+ * 
+ * @return AOV buffer of the last run (NULL if no output channel was kept)
+ */
+AovBuffer* RayTracer::getAovBuffer(){
+    return this->aov_buffer_;
+}
+
+/**
+ * Writes an output channel filled by the last run to its own PFM file, 
+ * grayscale for depth and object id, color for the normal
+ * 
+ * @param channel Flag of the channel
+ * @param filename Name of the file to write the channel to
  */
-void RayTracer::normalizeAndCenterPixel(double &x, double &y){
-    x = (x + 0.5) / this->scene_->getWidthResolution();
-    y = (y + 0.5) / this->scene_->getHeightResolution();
+void RayTracer::writeOutputChannel(int channel, std::string filename){
+    if(this->aov_buffer_ == NULL || !this->aov_buffer_->hasChannel(channel)){
+        throw std::logic_error("The output channel " + AovBuffer::getChannelName(channel) + " was not kept by the last run.");
+    }
+    
+    PfmWriter channel_writer(filename);
+    channel_writer.setChannelCount(AovBuffer::getComponentCount(channel));
+    channel_writer.init();
+    channel_writer.defineHeaders(this->aov_buffer_->getWidth(), this->aov_buffer_->getHeight(), 0);
+    channel_writer.addPlane(this->aov_buffer_->getChannel(channel), this->aov_buffer_->getWidth(), this->aov_buffer_->getHeight());
+    channel_writer.close();
 }
 
 /**
- * Transforms a coordinate in NDC space to screen space. 
- * (All the pixels are scaled between -1 and 1)
- * Then, the aspect ratio is applied adjusting the range of the x coordinate,
- * while leaving the y coordinate static.
+ * Gets the number of rays of the given type cast since the ray tracer was created
  * 
- * @param x X-coordinate in NDC space
- * @param y Y-coordinate in NDC space
+ * @param ray_type Type of the ray (see Ray Type List in path_state.h)
+ * @return Number of rays of the type cast
  */
-void RayTracer::convertToScreenSpace(double &x, double &y){
-    double aspect_ratio = this->scene_->getWidthResolution() / this->scene_->getHeightResolution();
-    x = ((x * 2) - 1) * aspect_ratio;
-    y = 1 - (y * 2);
+long long RayTracer::getRayCount(int ray_type){
+    return this->ray_counts_[ray_type];
 }
 
 /**
- * Transforms a coordinate in screen space to camera space. This applies 
- * the field of view and the distance to the focal plane to determine what 
- * area of the 3D scene is in frame.
+ * Writes the number of rays cast of each type
  * 
- * @param x X-coordinate in screen space
- * @param y Y-coordinate in screen space
+ * @param output Stream to write the statistics to
  */
-void RayTracer::convertToCameraSpace(double &x, double &y){
-    x = x * tan(this->scene_->getCameraFieldOfView()) * this->scene_->getDistToImagePlane();
-    y = y * tan(this->scene_->getCameraFieldOfView()) * this->scene_->getDistToImagePlane();
+void RayTracer::printRayStatistics(std::ostream& output){
+    const char* ray_type_names[RAY_TYPE_COUNT] = {"Primary", "Reflection", "Refraction", "Shadow"};
+    
+    output << "Rays cast:" << std::endl;
+    for (int i = 0; i < RAY_TYPE_COUNT; i++) {
+        output << "    " << ray_type_names[i] << ": " << this->ray_counts_[i].load() << std::endl;
+    }
 }
 
 /**
- * Compute the initial Ray that needs to be cast to determine the color data at the given pixel 
+ * Compute the initial Ray that needs to be cast to determine the color data at the given pixel.
+ * The camera precomputes its projection, so this only steps across the image plane.
  * 
  * @param x X-coordinate of the pixel
  * @param y Y-coordinate of the pixel
+ * @param lens_u First coordinate of the sample on the camera lens (0-1)
+ * @param lens_v Second coordinate of the sample on the camera lens (0-1)
  * @return Resulting ray
  */
-Ray* RayTracer::generatePrimaryRay(double x, double y){
-    
-    normalizeAndCenterPixel(x, y);
-    convertToScreenSpace(x, y);
-    convertToCameraSpace(x, y);
-    
-    Point3D center_of_pixel (x, y, 0);
-    Vector3D rayDirection = this->scene_->getCameraOrigin()->computeDirection(&center_of_pixel, true);
-    
-    return new Ray(new Point3D(this->scene_->getCameraOrigin()->getX(),
-                               this->scene_->getCameraOrigin()->getY(),
-                               this->scene_->getCameraOrigin()->getZ()),
-                   new Vector3D(rayDirection.getX(),
-                                rayDirection.getY(),
-                                rayDirection.getZ()));
+Ray* RayTracer::generatePrimaryRay(double x, double y, double lens_u, double lens_v){
+    return this->scene_->getCamera()->generateRay(x, y, lens_u, lens_v);
 }
 
 /**
  * Computes the geometry closest to the camera that the ray has collided with.
  * Also computes and returns the point in 3D space that was collided with and the
- * normal at that point, if applicable.
+ * normal at that point, if applicable. Once a render has built the bounding 
+ * volume hierarchy, only the geometry in the boxes crossed by the ray is tested.
  * 
  * @param ray Ray to compute intersections with
  * @param nearest_point Point in 3D space that was collided with
@@ -140,6 +1384,10 @@ Ray* RayTracer::generatePrimaryRay(double x, double y){
  * @return Pointer to the Geometry object intersected
  */
 Geometry* RayTracer::computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point){
+    if(this->acceleration_structure_ != NULL){
+        return this->acceleration_structure_->computeNearestIntersection(ray, nearest_point, normal_at_nearest_point);
+    }
+    
     Geometry* nearest_geometry = NULL;
     float nearest_intersection_distance = INFINITY;
     
@@ -147,10 +1395,11 @@ Geometry* RayTracer::computeNearestIntersection(Ray* ray, Point3D* nearest_point
     Vector3D normal_hit (1,1,1);
     
     for (int i = 0; i < this->scene_->getGeoListSize(); i++) { 
-        if (this->scene_->getGeoAt(i)->hasIntersection(ray, &point_hit, &normal_hit)) {
+        Geometry* geometry_hit = this->scene_->getGeoAt(i)->computeNearestIntersection(ray, &point_hit, &normal_hit);
+        if (geometry_hit != NULL) {
             float distance = ray->getOrigin()->computeDistance(&point_hit);
             if (distance < nearest_intersection_distance) { 
-                nearest_geometry = this->scene_->getGeoAt(i);
+                nearest_geometry = geometry_hit;
                 nearest_intersection_distance = distance;
     
                 nearest_point->setX(point_hit.getX());
@@ -171,25 +1420,33 @@ Geometry* RayTracer::computeNearestIntersection(Ray* ray, Point3D* nearest_point
  * Generates a flag based on whether the point is in shadow or not.
  * 
  * @param nearest_point Point in 3D space to test whether it is in shadow
- * @param casting_light Pointer to the light casting the shadow
+ * @param direction_to_light Normalized direction from the point to the light
+ * @param distance_to_light Distance from the point to the light (infinite for directional lights)
+ * @param path_state State of the path casting the shadow ray
  * @return Flag determining if the point is in shadow or not
  */
-bool RayTracer::computeShadowRay(Point3D* nearest_point, Light* casting_light){
+bool RayTracer::computeShadowRay(Point3D* nearest_point, Vector3D* direction_to_light, double distance_to_light, PathState* path_state){
     int shadow_flag = 0;
+    path_state->countRay(3);
     
-    Vector3D direction_to_light = casting_light->getDirectionToLight();
-    Ray* shadow_ray = new Ray(new Point3D(nearest_point->getX() + (direction_to_light.getX() * FLT_EPSILON), 
-                                          nearest_point->getY() + (direction_to_light.getY() * FLT_EPSILON), 
-                                          nearest_point->getZ() + (direction_to_light.getZ() * FLT_EPSILON)), 
-                             new Vector3D(direction_to_light.getX(), direction_to_light.getY(), direction_to_light.getZ()));
+    Ray* shadow_ray = new Ray(new Point3D(nearest_point->getX() + (direction_to_light->getX() * FLT_EPSILON), 
+                                          nearest_point->getY() + (direction_to_light->getY() * FLT_EPSILON), 
+                                          nearest_point->getZ() + (direction_to_light->getZ() * FLT_EPSILON)), 
+                             new Vector3D(direction_to_light->getX(), direction_to_light->getY(), direction_to_light->getZ()));
+    //Geometry behind the light does not cast a shadow
+    shadow_ray->setInterval(0, distance_to_light);
   
     Point3D point_hit_noop (0,0,0);
     Vector3D normal_hit_noop (1,1,1);
   
-    for (int i = 0; i < this->scene_->getGeoListSize(); i++) {
-        if (this->scene_->getGeoAt(i)->hasIntersection(shadow_ray, &point_hit_noop, &normal_hit_noop)) {
-            shadow_flag = 1;
-            break;
+    if(this->acceleration_structure_ != NULL){
+        shadow_flag = this->acceleration_structure_->hasIntersection(shadow_ray);
+    } else {
+        for (int i = 0; i < this->scene_->getGeoListSize(); i++) {
+            if (this->scene_->getGeoAt(i)->hasIntersection(shadow_ray, &point_hit_noop, &normal_hit_noop)) {
+                shadow_flag = 1;
+                break;
+            }
         }
     }
   
@@ -198,24 +1455,387 @@ bool RayTracer::computeShadowRay(Point3D* nearest_point, Light* casting_light){
     return shadow_flag;
 }
 
+/**
+ * Decides whether a path with the given throughput should be extended. Paths at
+ * or above the throughput threshold always continue. Below it, the path is cut,
+ * unless Russian roulette is enabled, in which case it survives with a 
+ * probability proportional to its throughput and its weight is scaled by the
+ * inverse of that probability so the expected result is unchanged.
+ * 
+ * @param throughput Throughput of the path, raised to the threshold if the path survives the roulette
+ * @param weight_scale Factor to apply to the contribution of the extended path
+ * @param path_state State of the path being extended
+ * @return Flag indicating whether the path should be extended
+ */
+bool RayTracer::continuePath(double &throughput, double &weight_scale, PathState* path_state){
+    weight_scale = 1.0;
+    
+    if(throughput >= this->throughput_threshold_){
+        return true;
+    }
+    
+    if(!this->russian_roulette_ || throughput <= 0.0){
+        return false;
+    }
+    
+    double survival_probability = throughput / this->throughput_threshold_;
+    if(path_state->getSampler()->nextDouble() >= survival_probability){
+        return false;
+    }
+    
+    weight_scale = 1.0 / survival_probability;
+    throughput = this->throughput_threshold_;
+    return true;
+}
+
+/**
+ * Spawns a reflection or refraction ray and returns the color it gathers, 
+ * filtered by the given weight. The ray is not spawned if the path's throughput
+ * becomes too low or the path has used up its ray budget.
+ * 
+ * @param ray_type Type of the ray to spawn (1: Reflection, 2: Refraction)
+ * @param weight Color filtering the light gathered by the ray
+ * @param nearest_point Point in 3D space the ray is spawned from
+ * @param offset_direction Side of the surface the ray starts on
+ * @param direction Direction of the spawned ray
+ * @param depth_level Current level of recursive ray casting
+ * @param throughput Throughput of the path up to this point
+ * @param path_state State of the path being traced
+ * @return Weighted color gathered by the spawned ray
+ */
+RgbColor RayTracer::spawnSecondaryRay(int ray_type, RgbColor weight, Point3D* nearest_point, Vector3D offset_direction, Vector3D direction, int depth_level, double throughput, PathState* path_state){
+    double ray_throughput = throughput * (weight.getMaxComponent() / 255);
+    double weight_scale = 1.0;
+    if(!continuePath(ray_throughput, weight_scale, path_state) || !path_state->consumeRay(ray_type)){
+        return RgbColor(0,0,0);
+    }
+    
+    //Start the ray slightly off of the surface so it does not hit the point it was spawned from
+    Ray* secondary_ray = new Ray(new Point3D(nearest_point->getX() + (offset_direction.getX() * SURFACE_EPSILON), 
+                                             nearest_point->getY() + (offset_direction.getY() * SURFACE_EPSILON), 
+                                             nearest_point->getZ() + (offset_direction.getZ() * SURFACE_EPSILON)), 
+                                 new Vector3D(direction.getX(), direction.getY(), direction.getZ()));
+    
+    std::vector<GBufferNode>* g_buffer_nodes = path_state->getGBufferNodes();
+    int node_index = (g_buffer_nodes != NULL) ? g_buffer_nodes->size() : -1;
+    RgbColor secondary_color = trace(secondary_ray, depth_level + 1, ray_throughput, path_state);
+    if(g_buffer_nodes != NULL){
+        (*g_buffer_nodes)[node_index].weight = weight;
+        (*g_buffer_nodes)[node_index].weight_scale = weight_scale;
+    }
+    
+    return (weight * secondary_color) * weight_scale;
+}
+
 /**
  * Computes a reflection ray based on the direction the original ray was cast in
  * and returns the color data at the end of the reflection ray
  * 
  * @param ray Original ray cast for which reflection needs to be computed
  * @param nearest_point Point in 3D space where the ray intersected the geometry
- * @param normal_at_nearest_point Normal at the point intersected by the ray
+ * @param normal_at_nearest_point Normal at the point intersected by the ray, facing the side the ray came from
+ * @param weight Color filtering the reflected light
  * @param depth_level Current level of recursive ray casting
+ * @param throughput Throughput of the path up to this point
+ * @param path_state State of the path being traced
  * @return Color intersected by the reflection ray
  */
-RgbColor RayTracer::computeReflection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point, int depth_level){
+RgbColor RayTracer::computeReflection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point, RgbColor weight, int depth_level, double throughput, PathState* path_state){
     Vector3D direction_to_eye(-ray->getDirection()->getX(), -ray->getDirection()->getY(), -ray->getDirection()->getZ()); 
     double a = std::max(0.0, normal_at_nearest_point->dot(&direction_to_eye));
     Vector3D reflection_direction = ((*normal_at_nearest_point * 2) * a) - direction_to_eye;
-    Ray* reflection_ray = new Ray(new Point3D(nearest_point->getX(), nearest_point->getY(), nearest_point->getZ()), 
-                                  new Vector3D(reflection_direction.getX(), reflection_direction.getY(), reflection_direction.getZ()));
     
-    return trace(reflection_ray, depth_level + 1);
+    return spawnSecondaryRay(1, weight, nearest_point, *normal_at_nearest_point, reflection_direction, depth_level, throughput, path_state);
+}
+
+/**
+ * Computes the fraction of light reflected at the boundary between two 
+ * dielectric media using the Fresnel equations for unpolarized light
+ * <https://en.wikipedia.org/wiki/Fresnel_equations>
+ * 
+ * @param incident_index Index of refraction of the medium the ray travels through
+ * @param transmitted_index Index of refraction of the medium the ray enters
+ * @param cos_incident Cosine of the angle between the ray and the surface normal
+ * @param cos_transmitted Cosine of the angle between the refracted ray and the flipped surface normal
+ * @return Fraction of light reflected (0-1)
+ */
+double RayTracer::computeFresnel(double incident_index, double transmitted_index, double cos_incident, double cos_transmitted){
+    double perpendicular = (incident_index * cos_incident - transmitted_index * cos_transmitted) / 
+                           (incident_index * cos_incident + transmitted_index * cos_transmitted);
+    double parallel = (incident_index * cos_transmitted - transmitted_index * cos_incident) / 
+                      (incident_index * cos_transmitted + transmitted_index * cos_incident);
+    return (perpendicular * perpendicular + parallel * parallel) / 2;
+}
+
+/**
+ * Splits the ray at the surface of a refractive geometry into a reflected and a 
+ * refracted ray using Snell's Law <https://en.wikipedia.org/wiki/Snell%27s_law>.
+ * The light carried by the transmissive color is divided between the two rays
+ * according to the Fresnel equations, and goes entirely to the reflected ray
+ * past the critical angle (total internal reflection). The ray with the larger
+ * weight is spawned first so it is favored when the path's ray budget runs out.
+ * 
+ * @param nearest_geometry Geometry object containing the refraction information
+ * @param ray Ray that intersected the geometry
+ * @param nearest_point Point in 3D space where the ray intersected the geometry
+ * @param normal_at_nearest_point Outward facing normal at the point intersected by the ray
+ * @param depth_level Current level of recursive ray casting
+ * @param throughput Throughput of the path up to this point
+ * @param path_state State of the path being traced
+ * @return Combined color of the reflected and refracted rays
+ */
+RgbColor RayTracer::computeRefraction(Geometry* nearest_geometry, Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point, int depth_level, double throughput, PathState* path_state){
+    Vector3D normal(normal_at_nearest_point->getX(), normal_at_nearest_point->getY(), normal_at_nearest_point->getZ());
+    double incident_index = 1.0;
+    double transmitted_index = nearest_geometry->getRefractionIndex();
+    double cos_incident = -ray->getDirection()->dot(&normal);
+    
+    //The ray is leaving the geometry, so the normal and the media are swapped
+    if(cos_incident < 0){
+        normal = normal * -1;
+        cos_incident = -cos_incident;
+        incident_index = transmitted_index;
+        transmitted_index = 1.0;
+    }
+    
+    double eta = incident_index / transmitted_index;
+    double sin2_transmitted = eta * eta * (1 - cos_incident * cos_incident);
+    
+    RgbColor transmissive_color = nearest_geometry->getTransmissiveColor();
+    double fresnel = 1.0;
+    Vector3D refraction_direction;
+    if(sin2_transmitted < 1.0){
+        double cos_transmitted = sqrt(1 - sin2_transmitted);
+        fresnel = computeFresnel(incident_index, transmitted_index, cos_incident, cos_transmitted);
+        refraction_direction = (*ray->getDirection() * eta) + (normal * (eta * cos_incident - cos_transmitted));
+        refraction_direction.normalize();
+    }
+    
+    RgbColor reflection_weight = nearest_geometry->getReflectiveColor() + (transmissive_color * fresnel);
+    RgbColor refraction_weight = transmissive_color * (1 - fresnel);
+    Vector3D inside_direction = normal * -1;
+    
+    RgbColor reflected_color(0,0,0);
+    RgbColor refracted_color(0,0,0);
+    if(reflection_weight.getMaxComponent() >= refraction_weight.getMaxComponent()){
+        reflected_color = computeReflection(ray, nearest_point, &normal, reflection_weight, depth_level, throughput, path_state);
+        if(fresnel < 1.0){
+            refracted_color = spawnSecondaryRay(2, refraction_weight, nearest_point, inside_direction, refraction_direction, depth_level, throughput, path_state);
+        }
+    } else {
+        refracted_color = spawnSecondaryRay(2, refraction_weight, nearest_point, inside_direction, refraction_direction, depth_level, throughput, path_state);
+        reflected_color = computeReflection(ray, nearest_point, &normal, reflection_weight, depth_level, throughput, path_state);
+    }
+    
+    return reflected_color + refracted_color;
+}
+
+/**
+ * Computes the diffuse and specular color contributed by a bounded (point
+ * or spot) light using the Phong Lighting Model. The shadow ray is skipped
+ * when the light does not reach the point or lies behind the surface.
+ * 
+ * @param nearest_geometry Geometry object containing the color information
+ * @param direction_to_eye Normalized direction from the point to the eye
+ * @param nearest_point Point in 3D space where the ray intersected the geometry
+ * @param normal_at_nearest_point Normal at the point intersected by the ray
+ * @param light Bounded light lighting the point
+ * @param path_state State of the path being traced
+ * @return Color contributed by the light
+ */
+RgbColor RayTracer::computeBoundedLight(Geometry* nearest_geometry, Vector3D* direction_to_eye, Point3D* nearest_point, Vector3D* normal_at_nearest_point, Light* light, PathState* path_state){
+    RgbColor light_color = light->getColorAt(nearest_point);
+    if(light_color.isBlack()){
+        return RgbColor(0,0,0);
+    }
+    
+    Vector3D direction_to_light = light->getDirectionToLight(nearest_point);
+    double a = normal_at_nearest_point->dot(&direction_to_light);
+    if(a <= 0.0){
+        return RgbColor(0,0,0);
+    }
+    
+    if(computeShadowRay(nearest_point, &direction_to_light, light->getDistanceToLight(nearest_point), path_state)){
+        return RgbColor(0,0,0);
+    }
+    
+    Vector3D reflection_direction = ((*normal_at_nearest_point * 2) * a) - direction_to_light;
+    double b = std::max(0.0, direction_to_eye->dot(&reflection_direction));
+    
+    RgbColor diffuse_color = light_color * (nearest_geometry->getDiffuseColor() * a);
+    RgbColor specular_color = light_color * ((nearest_geometry->getSpecularHighlight() * b) ^ nearest_geometry->getPhongConstant());
+    
+    return diffuse_color + specular_color;
+}
+
+/**
+ * Computes the diffuse and specular color cast onto a point from a single 
+ * point on the surface of an area light, using the Phong Lighting Model
+ * 
+ * @param nearest_geometry Geometry object containing the color information
+ * @param direction_to_eye Normalized direction from the point to the eye
+ * @param nearest_point Point in 3D space where the ray intersected the geometry
+ * @param normal_at_nearest_point Normal at the point intersected by the ray
+ * @param light Area light lighting the point
+ * @param u First coordinate of the sample on the light (0-1)
+ * @param v Second coordinate of the sample on the light (0-1)
+ * @param path_state State of the path being traced
+ * @param occluded Resulting flag indicating whether geometry blocked the sample
+ *                 (not set for samples facing away from the point or the light)
+ * @return Color contributed by the sample
+ */
+RgbColor RayTracer::computeAreaLightSample(Geometry* nearest_geometry, Vector3D* direction_to_eye, Point3D* nearest_point, Vector3D* normal_at_nearest_point, AreaLight* light, double u, double v, PathState* path_state, bool &occluded){
+    occluded = false;
+    Point3D light_point = light->samplePoint(u, v);
+    RgbColor light_color = light->getColorFrom(&light_point, nearest_point);
+    if(light_color.isBlack()){
+        return RgbColor(0,0,0);
+    }
+    
+    Vector3D direction_to_light = nearest_point->computeDirection(&light_point, false);
+    double distance_to_light = direction_to_light.magnitude();
+    direction_to_light = direction_to_light * (1.0 / distance_to_light);
+    double a = normal_at_nearest_point->dot(&direction_to_light);
+    if(a <= 0.0){
+        return RgbColor(0,0,0);
+    }
+    
+    if(computeShadowRay(nearest_point, &direction_to_light, distance_to_light, path_state)){
+        occluded = true;
+        return RgbColor(0,0,0);
+    }
+    
+    Vector3D reflection_direction = ((*normal_at_nearest_point * 2) * a) - direction_to_light;
+    double b = std::max(0.0, direction_to_eye->dot(&reflection_direction));
+    
+    RgbColor diffuse_color = light_color * (nearest_geometry->getDiffuseColor() * a);
+    RgbColor specular_color = light_color * ((nearest_geometry->getSpecularHighlight() * b) ^ nearest_geometry->getPhongConstant());
+    
+    return diffuse_color + specular_color;
+}
+
+/**
+ * Computes the color cast onto a point by an area light, with soft shadows.
+ * The surface of the light is divided into a grid of strata and one jittered
+ * sample is taken in each stratum used. The first four samples are taken from
+ * the four quadrants of the light. If their shadow rays agree (all blocked or
+ * none), they are averaged and no more shadow rays are cast. Samples facing 
+ * away from the point or the light don't count as blocked, so a point the 
+ * light only partly faces is not mistaken for a penumbra. Otherwise the point
+ * lies in a penumbra and the remaining strata are sampled so that every 
+ * stratum of the light is used exactly once.
+ * 
+ * @param nearest_geometry Geometry object containing the color information
+ * @param direction_to_eye Normalized direction from the point to the eye
+ * @param nearest_point Point in 3D space where the ray intersected the geometry
+ * @param normal_at_nearest_point Normal at the point intersected by the ray
+ * @param light Area light lighting the point
+ * @param path_state State of the path being traced
+ * @return Color contributed by the light
+ */
+RgbColor RayTracer::computeAreaLight(Geometry* nearest_geometry, Vector3D* direction_to_eye, Point3D* nearest_point, Vector3D* normal_at_nearest_point, AreaLight* light, PathState* path_state){
+    Sampler* sampler = path_state->getSampler();
+    
+    //The grid has an even number of strata per side so it splits into quadrants
+    int strata = (int)sqrt((double)light->getShadowSampleCount());
+    strata = std::min(std::max(strata + (strata % 2), 2), MAX_AREA_LIGHT_STRATA);
+    int half_strata = strata / 2;
+    
+    bool sampled[MAX_AREA_LIGHT_STRATA * MAX_AREA_LIGHT_STRATA] = {false};
+    RgbColor light_color(0,0,0);
+    int occluded_count = 0;
+    for (int quadrant = 0; quadrant < 4; quadrant++) {
+        int stratum_x = (quadrant & 1) * half_strata + std::min((int)(sampler->nextDouble() * half_strata), half_strata - 1);
+        int stratum_y = (quadrant >> 1) * half_strata + std::min((int)(sampler->nextDouble() * half_strata), half_strata - 1);
+        sampled[stratum_y * strata + stratum_x] = true;
+        
+        bool occluded = false;
+        light_color = light_color + computeAreaLightSample(nearest_geometry, direction_to_eye, nearest_point, normal_at_nearest_point, light, 
+                                                           (stratum_x + sampler->nextDouble()) / strata, (stratum_y + sampler->nextDouble()) / strata, path_state, occluded);
+        occluded_count += occluded;
+    }
+    
+    if(occluded_count == 0 || occluded_count == 4 || strata == 2){
+        return light_color * 0.25;
+    }
+    
+    for (int stratum_y = 0; stratum_y < strata; stratum_y++) {
+        for (int stratum_x = 0; stratum_x < strata; stratum_x++) {
+            if(sampled[stratum_y * strata + stratum_x]){
+                continue;
+            }
+            bool occluded = false;
+            light_color = light_color + computeAreaLightSample(nearest_geometry, direction_to_eye, nearest_point, normal_at_nearest_point, light, 
+                                                               (stratum_x + sampler->nextDouble()) / strata, (stratum_y + sampler->nextDouble()) / strata, path_state, occluded);
+        }
+    }
+    
+    return light_color * (1.0 / (strata * strata));
+}
+
+/**
+ * Adds the light cast directly onto a point by every light in the scene to 
+ * the given color, using the Phong Lighting Model. Only shadow rays are cast,
+ * so the point can be shaded again from a G-Buffer when the lights change.
+ * 
+ * @param nearest_geometry Geometry object containing the color information
+ * @param direction_to_eye Normalized direction from the point to the eye
+ * @param nearest_point Point in 3D space where the ray intersected the geometry
+ * @param normal_at_nearest_point Normal at the point intersected by the ray
+ * @param pixel_color Color gathered by the reflection and refraction rays of the point
+ * @param path_state State of the path being traced
+ * @return Color of the point with the direct light added
+ */
+RgbColor RayTracer::computeDirectLighting(Geometry* nearest_geometry, Vector3D* direction_to_eye, Point3D* nearest_point, Vector3D* normal_at_nearest_point, RgbColor pixel_color, PathState* path_state){
+    //All ambient lights were summed into one color by Scene::compile
+    pixel_color = pixel_color + nearest_geometry->getDiffuseColor() * this->scene_->getAmbientColor();
+    
+    CompiledDirectionalLight* directional_lights = this->scene_->getDirectionalLights();
+    for (int i = 0; i < this->scene_->getDirectionalLightCount(); i++) {
+        Vector3D* direction_to_light = &directional_lights[i].direction_to_light;
+
+        double a = std::max(0.0, normal_at_nearest_point->dot(direction_to_light));
+        Vector3D reflection_direction = ((*normal_at_nearest_point * 2) * a) - *direction_to_light;
+        double b = std::max(0.0, direction_to_eye->dot(&reflection_direction));
+        
+        //Neither diffuse nor specular light can reach the eye, so the shadow does not matter
+        if(a == 0.0 && b == 0.0){
+            continue;
+        }
+        
+        if(computeShadowRay(nearest_point, direction_to_light, INFINITY, path_state)){
+            continue;
+        }
+
+        RgbColor diffuse_color = directional_lights[i].color * (nearest_geometry->getDiffuseColor() * a);
+        RgbColor specular_color = directional_lights[i].color * ((nearest_geometry->getSpecularHighlight() * b) ^ nearest_geometry->getPhongConstant());
+    
+        pixel_color = pixel_color + diffuse_color + specular_color;
+    }
+    
+    for (int i = 0; i < this->scene_->getAreaLightCount(); i++) {
+        pixel_color = pixel_color + computeAreaLight(nearest_geometry, direction_to_eye, nearest_point, normal_at_nearest_point, this->scene_->getAreaLightAt(i), path_state);
+    }
+    
+    if(this->light_sample_count_ > 0){
+        for (int i = 0; i < this->light_sample_count_; i++) {
+            double pdf = 0.0;
+            PointLight* light = this->scene_->getLightHierarchy()->sample(nearest_point, normal_at_nearest_point, path_state->getSampler()->nextDouble(), pdf);
+            if(light != NULL){
+                RgbColor light_color = computeBoundedLight(nearest_geometry, direction_to_eye, nearest_point, normal_at_nearest_point, light, path_state);
+                pixel_color = pixel_color + light_color * (1.0 / (pdf * this->light_sample_count_));
+            }
+        }
+    } else {
+        //Only the point and spot lights whose influence reaches the point are evaluated
+        std::vector<PointLight*> lights_in_range;
+        this->scene_->getLightHierarchy()->query(nearest_point, &lights_in_range);
+        for (unsigned int i = 0; i < lights_in_range.size(); i++) {
+            pixel_color = pixel_color + computeBoundedLight(nearest_geometry, direction_to_eye, nearest_point, normal_at_nearest_point, lights_in_range[i], path_state);
+        }
+    }
+
+    return pixel_color;
 }
 
 /**
@@ -235,37 +1855,72 @@ RgbColor RayTracer::computeReflection(Ray* ray, Point3D* nearest_point, Vector3D
  * @param nearest_point Point in 3D space where the ray intersected the geometry
  * @param normal_at_nearest_point Normal at the point intersected by the ray
  * @param depth_level Current level of recursive ray casting
+ * @param throughput Throughput of the path up to this point
+ * @param path_state State of the path being traced
  * @return Color of the pixel
  */
-RgbColor RayTracer::computePhongLightingModel(Geometry* nearest_geometry, Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point, int depth_level){
+RgbColor RayTracer::computePhongLightingModel(Geometry* nearest_geometry, Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point, int depth_level, double throughput, PathState* path_state){
     RgbColor pixel_color(0,0,0);
     
-    if(nearest_geometry->hasReflection() && depth_level <= MAX_RAY_DEPTH){
-        pixel_color = nearest_geometry->getReflectiveColor() * computeReflection(ray, nearest_point, normal_at_nearest_point, depth_level);
+    if(depth_level <= this->max_ray_depth_){
+        if(nearest_geometry->hasRefraction()){
+            pixel_color = computeRefraction(nearest_geometry, ray, nearest_point, normal_at_nearest_point, depth_level, throughput, path_state);
+        } else if(nearest_geometry->hasReflection()){
+            pixel_color = computeReflection(ray, nearest_point, normal_at_nearest_point, nearest_geometry->getReflectiveColor(), depth_level, throughput, path_state);
+        }
     }
     
-    for (int i = 0; i < this->scene_->getLightListSize(); i++) {
-        if(this->scene_->getLightAt(i)->getType() == 0){ //Is Ambient
-            RgbColor ambient_color = nearest_geometry->getDiffuseColor() * this->scene_->getLightAt(i)->getColor();
-            pixel_color = pixel_color + ambient_color; 
-        } else if (this->scene_->getLightAt(i)->getType() == 1) { // Is Directional
-            bool shadow_mask = computeShadowRay(nearest_point, this->scene_->getLightAt(i));
-            
-            Vector3D direction_to_light = this->scene_->getLightAt(i)->getDirectionToLight();
+    Vector3D direction_to_eye = ray->getInverseDirection();
+    return computeDirectLighting(nearest_geometry, &direction_to_eye, nearest_point, normal_at_nearest_point, pixel_color, path_state);
+}
 
-            double a = std::max(0.0, normal_at_nearest_point->dot(&direction_to_light));
-            Vector3D reflection_direction = ((*normal_at_nearest_point * 2) * a) - direction_to_light;
-            Vector3D direction_to_eye = ray->getInverseDirection();
-            double b = std::max(0.0, direction_to_eye.dot(&reflection_direction));
+/**
+ * Records the surface hit by a ray to the G-Buffer nodes of the path, as a 
+ * child of the surface whose rays are being traced. The weight of the node
+ * is set by spawnSecondaryRay once the ray's color has been gathered.
+ * 
+ * @param nearest_geometry Geometry hit by the ray (NULL if the ray missed)
+ * @param ray Ray that hit the surface
+ * @param nearest_point Point in 3D space where the ray intersected the geometry
+ * @param normal_at_nearest_point Normal at the point intersected by the ray
+ * @param path_state State of the path being traced
+ * @return Index of the recorded node
+ */
+int RayTracer::recordGBufferNode(Geometry* nearest_geometry, Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point, PathState* path_state){
+    GBufferNode node;
+    node.parent_index = path_state->getCurrentNode();
+    node.geometry = nearest_geometry;
+    node.position = *nearest_point;
+    node.normal = *normal_at_nearest_point;
+    node.direction_to_eye = ray->getInverseDirection();
+    node.weight = RgbColor(255,255,255);
+    node.weight_scale = 1.0;
+    
+    path_state->getGBufferNodes()->push_back(node);
+    return path_state->getGBufferNodes()->size() - 1;
+}
 
-            RgbColor diffuse_color = (this->scene_->getLightAt(1)->getColor() * (nearest_geometry->getDiffuseColor() * a)) * !shadow_mask;
-            RgbColor specular_color = (this->scene_->getLightAt(1)->getColor() * ((nearest_geometry->getSpecularHighlight() * b) ^ nearest_geometry->getPhongConstant())) * !shadow_mask;
-        
-            pixel_color = pixel_color + diffuse_color + specular_color;
-        }
+/**
+ * Records the output variables of the surface hit by a primary ray
+ * 
+ * @param nearest_geometry Geometry hit by the ray (NULL if the ray missed)
+ * @param ray Ray that hit the surface
+ * @param nearest_point Point in 3D space where the ray intersected the geometry
+ * @param normal_at_nearest_point Normal at the point intersected by the ray
+ * @param aov_sample Output variables to fill
+ */
+void RayTracer::recordAovSample(Geometry* nearest_geometry, Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point, AovSample* aov_sample){
+    if(nearest_geometry == NULL){
+        aov_sample->depth = INFINITY;
+        aov_sample->normal[0] = aov_sample->normal[1] = aov_sample->normal[2] = 0.0f;
+        aov_sample->object_id = 0.0f;
+        return;
     }
-
-    return pixel_color;
+    aov_sample->depth = ray->getOrigin()->computeDistance(nearest_point);
+    aov_sample->normal[0] = normal_at_nearest_point->getX();
+    aov_sample->normal[1] = normal_at_nearest_point->getY();
+    aov_sample->normal[2] = normal_at_nearest_point->getZ();
+    aov_sample->object_id = nearest_geometry->getObjectId();
 }
 
 /**
@@ -273,13 +1928,32 @@ RgbColor RayTracer::computePhongLightingModel(Geometry* nearest_geometry, Ray* r
  * 
  * @param ray Ray to compute intersections and color data by
  * @param depth_level Current level of recursive ray casting
+ * @param throughput Throughput of the path up to this ray (1 for primary rays)
+ * @param path_state State of the path being traced
  * @return Color data of the pixel
  */
-RgbColor RayTracer::trace(Ray* ray, int depth_level)
+RgbColor RayTracer::trace(Ray* ray, int depth_level, double throughput, PathState* path_state)
 {    
     Point3D nearest_point (0,0,0);
     Vector3D normal_at_nearest_point (1,1,1);
-    Geometry* nearest_geometry = computeNearestIntersection(ray, &nearest_point, &normal_at_nearest_point);
+    Geometry* nearest_geometry = NULL;
+    if(depth_level == 1 && this->projection_grid_ != NULL){
+        nearest_geometry = this->projection_grid_->computeNearestIntersection(ray, &nearest_point, &normal_at_nearest_point);
+    } else {
+        nearest_geometry = computeNearestIntersection(ray, &nearest_point, &normal_at_nearest_point);
+    }
+  
+    int parent_node = path_state->getCurrentNode();
+    if(path_state->getGBufferNodes() != NULL){
+        int node_index = recordGBufferNode(nearest_geometry, ray, &nearest_point, &normal_at_nearest_point, path_state);
+        if(nearest_geometry != NULL){
+            path_state->setCurrentNode(node_index);
+        }
+    }
+    if(path_state->getAovSample() != NULL){
+        recordAovSample(nearest_geometry, ray, &nearest_point, &normal_at_nearest_point, path_state->getAovSample());
+        path_state->setAovSample(NULL);
+    }
   
     if (nearest_geometry == NULL){
         delete ray;
@@ -292,10 +1966,10 @@ RgbColor RayTracer::trace(Ray* ray, int depth_level)
             pixel_color = nearest_geometry->getDiffuseColor();
             break;
         case 1: //Phong Shader
-            pixel_color = computePhongLightingModel(nearest_geometry, ray, &nearest_point, &normal_at_nearest_point, depth_level);
+            pixel_color = computePhongLightingModel(nearest_geometry, ray, &nearest_point, &normal_at_nearest_point, depth_level, throughput, path_state);
             break;           
     }
-    pixel_color.correctOverflow();
+    path_state->setCurrentNode(parent_node);
     
     delete ray;
 
@@ -28,18 +28,50 @@
 #ifndef RAY_TRACER_H
 #define	RAY_TRACER_H
 
+#include <algorithm>
+#include <atomic>
 #include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cctype>
+#include <cstring>
+#include <exception>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "scene.h"
 #include "ray.h"
+#include "path_state.h"
+#include "aov_buffer.h"
+#include "frame_buffer.h"
+#include "g_buffer.h"
+#include "animation.h"
 
+#include "accel/acceleration_structure.h"
+#include "accel/bvh.h"
+#include "accel/bvh4.h"
+#include "accel/compressed_bvh.h"
+#include "accel/projection_grid.h"
+#include "accel/two_level_grid.h"
+#include "accel/uniform_grid.h"
+
+#include "file_writer/binary_ppm_writer.h"
 #include "file_writer/file_writer.h"
+#include "file_writer/mapped_ppm_writer.h"
+#include "file_writer/pfm_writer.h"
+#include "file_writer/stream_writer.h"
 
 #include "light/directional_light.h"
+#include "light/area_light.h"
 #include "light/light.h"
+#include "light/light_bvh.h"
+#include "light/point_light.h"
 
 #include "geo/geometry.h"
 
@@ -47,6 +79,17 @@
 #include "math/point3d.h"
 #include "math/vector3d.h"
 
+#include "post/post_process.h"
+
+//Progress of a tiled render, shared by the threads tracing it
+struct TileProgress {
+    int tile_count_x;
+    int tile_count_y;
+    std::atomic<int> next_tile;
+    std::mutex mutex;
+    std::vector<int> remaining_tiles;
+};
+
 class RayTracer{
 public:
     RayTracer();
@@ -54,21 +97,101 @@ public:
     ~RayTracer();
     
     void run();
+    void cancel();
+    void clearCancel();
+    bool isCancelled();
+    void relight();
+    int update();
+    void renderSequence(Animation* animation, int first_frame, int last_frame, std::string filename_pattern);
+    
+    void setFileWriter(FileWriter* file_writer);
+    FileWriter* getFileWriter();
+    Scene* getScene();
+    void setSamplesPerPixel(int samples_per_pixel);
+    int getSamplesPerPixel();
+    void setMaxRayDepth(int max_ray_depth);
+    int getMaxRayDepth();
+    void setThroughputThreshold(double throughput_threshold);
+    double getThroughputThreshold();
+    void setRussianRoulette(bool enabled);
+    bool getRussianRoulette();
+    void setRayBudget(int ray_budget);
+    int getRayBudget();
+    void setLightSampleCount(int light_sample_count);
+    int getLightSampleCount();
+    void setKeepGBuffer(bool keep_g_buffer);
+    bool getKeepGBuffer();
+    GBuffer* getGBuffer();
+    void setOutputChannel(int channel, bool enabled);
+    bool getOutputChannel(int channel);
+    AovBuffer* getAovBuffer();
+    void writeOutputChannel(int channel, std::string filename);
+    void setAccelerationType(int acceleration_type);
+    int getAccelerationType();
+    AccelerationStructure* getAccelerationStructure();
+    PostProcess* getPostProcess();
+    
+    long long getRayCount(int ray_type);
+    void printRayStatistics(std::ostream& output);
     
-    void normalizeAndCenterPixel(double &x, double &y);
-    void convertToScreenSpace(double &x, double &y);
-    void convertToCameraSpace(double &x, double &y);
-    Ray* generatePrimaryRay(double x, double y);
+    void computeEditedTiles(std::vector<Geometry*>* edited_geometry, std::vector<char>* edited_tiles, int tile_count_x, int tile_count_y);
+    bool markProjectedRegion(std::vector<Point3D>* region, std::vector<char>* edited_tiles, int tile_count_x, int tile_count_y);
+    int chooseAccelerationType();
+    void buildAccelerationStructure();
+    void updateAccelerationStructure(bool geometry_edited);
+    void prepareFrame();
+    void finishFrame();
+    void renderFrame();
+    void renderTiles(MappedPpmWriter* image_writer);
+    void renderTileWorker(MappedPpmWriter* image_writer, TileProgress* progress);
+    void prepareRegions();
+    void renderRegion(int first_x, int first_y, int width, int height, float* samples);
+    void writeFrameBuffer();
+    static void addFrameBuffer(FileWriter* file_writer, FrameBuffer* frame_buffer);
+    static std::string formatFrameBuffer(FrameBuffer* frame_buffer);
+    void postProcessFrameBuffer(FrameBuffer* frame_buffer, FrameBuffer* written_frame_buffer);
+    static std::string formatFrameFilename(std::string filename_pattern, int frame);
+    static void writeFrame(FileWriter* file_writer, FrameBuffer* frame_buffer, std::string filename, std::exception_ptr* error);
+    RgbColor renderPixel(int x, int y);
+    RgbColor relightPixel(int x, int y);
+    Ray* generatePrimaryRay(double x, double y, double lens_u, double lens_v);
     
     Geometry* computeNearestIntersection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point);
-    bool computeShadowRay(Point3D* nearest_point, Light* casting_light);
-    RgbColor computeReflection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point, int depth_level);
-    RgbColor computePhongLightingModel(Geometry* nearest_geometry, Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point, int depth_level);  
-    RgbColor trace(Ray* ray, int depth_level);
+    bool computeShadowRay(Point3D* nearest_point, Vector3D* direction_to_light, double distance_to_light, PathState* path_state);
+    bool continuePath(double &throughput, double &weight_scale, PathState* path_state);
+    RgbColor spawnSecondaryRay(int ray_type, RgbColor weight, Point3D* nearest_point, Vector3D offset_direction, Vector3D direction, int depth_level, double throughput, PathState* path_state);
+    RgbColor computeReflection(Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point, RgbColor weight, int depth_level, double throughput, PathState* path_state);
+    double computeFresnel(double incident_index, double transmitted_index, double cos_incident, double cos_transmitted);
+    RgbColor computeRefraction(Geometry* nearest_geometry, Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point, int depth_level, double throughput, PathState* path_state);
+    RgbColor computeBoundedLight(Geometry* nearest_geometry, Vector3D* direction_to_eye, Point3D* nearest_point, Vector3D* normal_at_nearest_point, Light* light, PathState* path_state);
+    RgbColor computeAreaLightSample(Geometry* nearest_geometry, Vector3D* direction_to_eye, Point3D* nearest_point, Vector3D* normal_at_nearest_point, AreaLight* light, double u, double v, PathState* path_state, bool &occluded);
+    RgbColor computeAreaLight(Geometry* nearest_geometry, Vector3D* direction_to_eye, Point3D* nearest_point, Vector3D* normal_at_nearest_point, AreaLight* light, PathState* path_state);
+    RgbColor computeDirectLighting(Geometry* nearest_geometry, Vector3D* direction_to_eye, Point3D* nearest_point, Vector3D* normal_at_nearest_point, RgbColor pixel_color, PathState* path_state);
+    RgbColor computePhongLightingModel(Geometry* nearest_geometry, Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point, int depth_level, double throughput, PathState* path_state);  
+    int recordGBufferNode(Geometry* nearest_geometry, Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point, PathState* path_state);
+    void recordAovSample(Geometry* nearest_geometry, Ray* ray, Point3D* nearest_point, Vector3D* normal_at_nearest_point, AovSample* aov_sample);
+    RgbColor trace(Ray* ray, int depth_level, double throughput, PathState* path_state);
     
 private:
     Scene* scene_;
     FileWriter* file_writer_;
+    ProjectionGrid* projection_grid_;
+    AccelerationStructure* acceleration_structure_;
+    int acceleration_type_;
+    int samples_per_pixel_;
+    int max_ray_depth_;
+    double throughput_threshold_;
+    bool russian_roulette_;
+    int ray_budget_;
+    int light_sample_count_;
+    bool keep_g_buffer_;
+    GBuffer* g_buffer_;
+    bool output_channels_[AOV_CHANNEL_COUNT];
+    AovBuffer* aov_buffer_;
+    FrameBuffer* frame_buffer_;
+    PostProcess* post_process_;
+    std::atomic<long long> ray_counts_[RAY_TYPE_COUNT];
+    std::atomic<bool> cancelled_;
 };
 
 #endif	/* RAYTRACER_H */
@@ -24,6 +24,8 @@
 #include "scene.h"
 
 Scene::Scene() {
+    this->camera_ = NULL;
+    this->light_hierarchy_ = NULL;
 }
 
 Scene::Scene(const Scene& orig) {
@@ -32,6 +34,7 @@ Scene::Scene(const Scene& orig) {
 
 Scene::~Scene() {
     delete this->camera_;
+    delete this->light_hierarchy_;
     
     while(!this->geometry_list_.empty()){
         Geometry* geometry = this->geometry_list_.back();
@@ -39,6 +42,13 @@ Scene::~Scene() {
         this->geometry_list_.pop_back();
     }
     
+    //Assets are deleted after the instances placing them
+    while(!this->asset_list_.empty()){
+        Asset* asset = this->asset_list_.back();
+        delete asset;
+        this->asset_list_.pop_back();
+    }
+    
     while(!this->light_list_.empty()){
         Light* light = this->light_list_.back();
         delete light;
@@ -65,14 +75,27 @@ RgbColor Scene::getBackgroundColor(){
 }
 
 /**
- * Set the projection parameters of the scene defined as a Camera object
+ * Set the projection parameters of the scene defined as a Camera object. The
+ * scene takes ownership of the camera and deletes the previous one.
  * 
  * @param camera Projection parameters to set
  */
 void Scene::setCamera(Camera* camera){
+    if(camera != this->camera_){
+        delete this->camera_;
+    }
     this->camera_ = camera;
 }
 
+/**
+ * Gets the projection parameters of the scene
+ * 
+ * @return Projection parameters of the scene
+ */
+Camera* Scene::getCamera(){
+    return this->camera_;
+}
+
 /**
  * Gets the origin of the camera
  * 
@@ -119,11 +142,16 @@ double Scene::getCameraFieldOfView(){
 }
 
 /**
- * Adds a Geometry description to the scene to be rendered
+ * Adds a Geometry description to the scene to be rendered. Geometry without
+ * an object id is numbered by the order it is added in, starting at 1.
  * 
  * @param geometry Pointer to a geometry description
  */
 void Scene::addGeo(Geometry* geometry){
+    if(geometry->getObjectId() == 0){
+        geometry->setObjectId(this->geometry_list_.size() + 1);
+    }
+    geometry->markEdited(true);
     this->geometry_list_.push_back(geometry);
 }
 
@@ -146,6 +174,71 @@ int Scene::getGeoListSize(){
     return this->geometry_list_.size();
 }
 
+/**
+ * Computes the box enclosing all geometry in the scene
+ * 
+ * @return Box enclosing the scene
+ */
+BoundingBox Scene::getBounds(){
+    BoundingBox bounds;
+    for (unsigned int i = 0; i < this->geometry_list_.size(); i++) {
+        bounds.expand(this->geometry_list_[i]->getBounds());
+    }
+    return bounds;
+}
+
+/**
+ * Collects the geometry edited (or added) since the edits were last cleared
+ * 
+ * @param edited_geometry List to append the edited geometry to
+ */
+void Scene::getEditedGeometry(std::vector<Geometry*>* edited_geometry){
+    for (unsigned int i = 0; i < this->geometry_list_.size(); i++) {
+        if(this->geometry_list_[i]->isEdited()){
+            edited_geometry->push_back(this->geometry_list_[i]);
+        }
+    }
+}
+
+/**
+ * Forgets the edits made to all geometry, once they have been rendered
+ */
+void Scene::clearEdits(){
+    for (unsigned int i = 0; i < this->geometry_list_.size(); i++) {
+        this->geometry_list_[i]->clearEdits();
+    }
+}
+
+/**
+ * Adds an asset to the scene, which takes ownership of it. The asset itself
+ * is not rendered: it is placed in the scene by adding Instances of it with 
+ * addGeo, which all share its geometry.
+ * 
+ * @param asset Asset to add
+ */
+void Scene::addAsset(Asset* asset){
+    this->asset_list_.push_back(asset);
+}
+
+/**
+ * Retrieves the asset at the given index
+ * 
+ * @param index Index to retrieve the asset from
+ * @return Asset at the given index
+ */
+Asset* Scene::getAssetAt(int index){
+    return this->asset_list_.at(index);
+}
+
+/**
+ * Gets the amount of assets added to the scene
+ * 
+ * @return Amount of assets added to the scene
+ */
+int Scene::getAssetListSize(){
+    return this->asset_list_.size();
+}
+
 /**
  * Adds a light description to the scene
  * 
@@ -155,6 +248,18 @@ void Scene::addLight(Light* light){
     this->light_list_.push_back(light);
 }
 
+/**
+ * Removes and deletes every light of the scene, so another set of lights can
+ * be added. The scene must be compiled again before rendering.
+ */
+void Scene::clearLights(){
+    while(!this->light_list_.empty()){
+        Light* light = this->light_list_.back();
+        delete light;
+        this->light_list_.pop_back();
+    }
+}
+
 /**
  * Retrieves the light description at the given index
  * 
@@ -172,4 +277,104 @@ Light* Scene::getLightAt(int index){
  */
 int Scene::getLightListSize(){
     return this->light_list_.size();
-}
\ No newline at end of file
+}
+/**
+ * Prepares the lights of the scene for rendering. Must be called again after
+ * lights are added or changed.
+ * 
+ * 1. The colors of all ambient lights are summed into a single ambient color
+ * 2. Directional lights are reduced to their color and their normalized 
+ *       direction towards the light, stored in a contiguous array
+ * 3. Bounded lights (point and spot) are sorted into a hierarchy so that only
+ *       the lights in range of a point need to be evaluated
+ * 4. Area lights (rectangle and disc) are gathered into their own list
+ */
+void Scene::compile(){
+    delete this->light_hierarchy_;
+    this->ambient_color_ = RgbColor(0,0,0);
+    this->directional_lights_.clear();
+    this->area_lights_.clear();
+    
+    std::vector<PointLight*> bounded_lights;
+    for (unsigned int i = 0; i < this->light_list_.size(); i++) {
+        Light* light = this->light_list_[i];
+        switch(light->getType()){
+            case 0: //Ambient
+                this->ambient_color_ = this->ambient_color_ + light->getColor();
+                break;
+            case 1: { //Directional
+                CompiledDirectionalLight directional_light;
+                directional_light.direction_to_light = light->getDirectionToLight();
+                directional_light.direction_to_light.normalize();
+                directional_light.color = light->getColor();
+                this->directional_lights_.push_back(directional_light);
+                break;
+            }
+            case 2: //Point
+            case 3: //Spot
+                bounded_lights.push_back(static_cast<PointLight*>(light));
+                break;
+            case 4: //Rectangle
+            case 5: //Disc
+                this->area_lights_.push_back(static_cast<AreaLight*>(light));
+                break;
+        }
+    }
+    
+    this->light_hierarchy_ = new LightBvh(bounded_lights);
+}
+
+/**
+ * Gets the sum of the colors of all ambient lights computed by compile
+ * 
+ * @return Ambient color of the scene
+ */
+RgbColor Scene::getAmbientColor(){
+    return this->ambient_color_;
+}
+
+/**
+ * Gets the directional lights of the scene computed by compile
+ * 
+ * @return Array of the compiled directional lights
+ */
+CompiledDirectionalLight* Scene::getDirectionalLights(){
+    return this->directional_lights_.empty() ? NULL : &this->directional_lights_[0];
+}
+
+/**
+ * Gets the amount of directional lights in the scene computed by compile
+ * 
+ * @return Amount of directional lights in the scene
+ */
+int Scene::getDirectionalLightCount(){
+    return this->directional_lights_.size();
+}
+
+/**
+ * Retrieves the area light at the given index gathered by compile
+ * 
+ * @param index Index to retrieve the area light from
+ * @return Area light at the given index
+ */
+AreaLight* Scene::getAreaLightAt(int index){
+    return this->area_lights_.at(index);
+}
+
+/**
+ * Gets the amount of area lights in the scene gathered by compile
+ * 
+ * @return Amount of area lights in the scene
+ */
+int Scene::getAreaLightCount(){
+    return this->area_lights_.size();
+}
+
+/**
+ * Gets the hierarchy of bounded lights built by compile
+ * 
+ * @return Hierarchy of the point and spot lights in the scene
+ */
+LightBvh* Scene::getLightHierarchy(){
+    return this->light_hierarchy_;
+}
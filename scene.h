@@ -28,12 +28,24 @@
 
 #include "camera.h"
 
+#include "geo/asset.h"
 #include "geo/geometry.h"
 
+#include "light/area_light.h"
 #include "light/light.h"
+#include "light/light_bvh.h"
+#include "light/point_light.h"
 
+#include "math/bounding_box.h"
 #include "math/rgb_color.h"
 #include "math/point3d.h"
+#include "math/vector3d.h"
+
+//A directional light reduced to the values read while shading
+struct CompiledDirectionalLight {
+    Vector3D direction_to_light;
+    RgbColor color;
+};
 
 class Scene {
 public:
@@ -45,6 +57,7 @@ public:
     RgbColor getBackgroundColor();
     
     void setCamera(Camera* camera);
+    Camera* getCamera();
     Point3D* getCameraOrigin();
     int getWidthResolution();
     int getHeightResolution();
@@ -54,16 +67,37 @@ public:
     void addGeo(Geometry* geometry);
     Geometry* getGeoAt(int index);
     int getGeoListSize();
+    BoundingBox getBounds();
+    void getEditedGeometry(std::vector<Geometry*>* edited_geometry);
+    void clearEdits();
+    
+    void addAsset(Asset* asset);
+    Asset* getAssetAt(int index);
+    int getAssetListSize();
     
     void addLight(Light* light);
+    void clearLights();
     Light* getLightAt(int index);
     int getLightListSize();
     
+    void compile();
+    RgbColor getAmbientColor();
+    CompiledDirectionalLight* getDirectionalLights();
+    int getDirectionalLightCount();
+    AreaLight* getAreaLightAt(int index);
+    int getAreaLightCount();
+    LightBvh* getLightHierarchy();
+    
 private:
     RgbColor background_color_;
     Camera* camera_;
     std::vector<Geometry*> geometry_list_;
+    std::vector<Asset*> asset_list_;
     std::vector<Light*> light_list_;
+    RgbColor ambient_color_;
+    std::vector<CompiledDirectionalLight> directional_lights_;
+    std::vector<AreaLight*> area_lights_;
+    LightBvh* light_hierarchy_;
 };
 
 #endif /* SCENE_H */
@@ -0,0 +1,487 @@
+// Ray Tracer: farm_coordinator.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: The Farm Coordinator renders a single frame across several 
+//                  processes. It splits the image into tiles and hands them 
+//                  out over TCP to Farm Workers, local ones it starts itself
+//                  or remote ones connecting to its port, then assembles 
+//                  their samples into the frame. Tiles of workers which 
+//                  disconnect or exceed the tile timeout are handed out 
+//                  again, and once no tile is left to hand out, idle workers
+//                  render copies of the tiles still outstanding so a slow 
+//                  worker does not hold up the frame.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "farm_coordinator.h"
+
+#define DEFAULT_FARM_TILE_SIZE 64
+#define DEFAULT_FARM_TILE_TIMEOUT 30.0
+#define FARM_TILES_IN_FLIGHT 2
+#define FARM_MAX_TILE_HOLDERS 2
+#define FARM_POLL_INTERVAL 100
+#define FARM_WORKER_EXIT_WAIT 1.0
+#define READ_CHUNK_SIZE 65536
+
+FarmCoordinator::FarmCoordinator(){
+    this->tile_size_ = DEFAULT_FARM_TILE_SIZE;
+    this->tile_timeout_ = DEFAULT_FARM_TILE_TIMEOUT;
+    this->listen_fd_ = -1;
+    this->port_ = 0;
+    this->remaining_count_ = 0;
+    this->worker_count_ = 0;
+    this->reassigned_count_ = 0;
+    this->duplicated_count_ = 0;
+    this->dropped_worker_count_ = 0;
+}
+
+FarmCoordinator::FarmCoordinator(int tile_size, double tile_timeout){
+    this->tile_size_ = tile_size > 0 ? tile_size : DEFAULT_FARM_TILE_SIZE;
+    this->tile_timeout_ = tile_timeout > 0 ? tile_timeout : DEFAULT_FARM_TILE_TIMEOUT;
+    this->listen_fd_ = -1;
+    this->port_ = 0;
+    this->remaining_count_ = 0;
+    this->worker_count_ = 0;
+    this->reassigned_count_ = 0;
+    this->duplicated_count_ = 0;
+    this->dropped_worker_count_ = 0;
+}
+
+FarmCoordinator::~FarmCoordinator(){
+    stopWorkers();
+    if(this->listen_fd_ >= 0){
+        close(this->listen_fd_);
+    }
+}
+
+/**
+ * Sets the scene to render, described as text (see Scene Parser)
+ * 
+ * @param scene_text Description of the scene
+ */
+void FarmCoordinator::setScene(std::string scene_text){
+    this->parser_.parse(scene_text);
+    this->scene_text_ = scene_text;
+}
+
+/**
+ * Listens for workers on a TCP port of every interface
+ * 
+ * @param port Port to listen on, 0 for any free port (see getPort)
+ */
+void FarmCoordinator::listen(int port){
+    this->listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if(this->listen_fd_ < 0){
+        throw std::runtime_error(std::string("Could not create socket: ") + strerror(errno));
+    }
+    int reuse = 1;
+    setsockopt(this->listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    socklen_t address_size = sizeof(address);
+    if(bind(this->listen_fd_, (sockaddr*)&address, sizeof(address)) < 0 || ::listen(this->listen_fd_, SOMAXCONN) < 0 ||
+       getsockname(this->listen_fd_, (sockaddr*)&address, &address_size) < 0){
+        throw std::runtime_error(std::string("Could not listen for workers: ") + strerror(errno));
+    }
+    this->port_ = ntohs(address.sin_port);
+}
+
+/**
+ * Gets the port the coordinator listens on
+ * 
+ * @return Port of the coordinator
+ */
+int FarmCoordinator::getPort(){
+    return this->port_;
+}
+
+/**
+ * Starts worker processes on this machine, running the given executable 
+ * with "--farm-worker 127.0.0.1 PORT". Must be called after listen.
+ * 
+ * @param worker_count Amount of workers to start
+ * @param executable Path of the ray tracer executable
+ */
+void FarmCoordinator::spawnLocalWorkers(int worker_count, std::string executable){
+    std::ostringstream port;
+    port << this->port_;
+    std::string port_text = port.str();
+    for (int i = 0; i < worker_count; i++) {
+        pid_t pid = fork();
+        if(pid < 0){
+            throw std::runtime_error(std::string("Could not start a worker: ") + strerror(errno));
+        }
+        if(pid == 0){
+            close(this->listen_fd_);
+            execl(executable.c_str(), executable.c_str(), "--farm-worker", "127.0.0.1", port_text.c_str(), (char*)NULL);
+            _exit(127);
+        }
+        this->local_workers_.push_back(pid);
+    }
+}
+
+/**
+ * Renders the frame with the connected workers, assembling the raw samples
+ * of the tiles into a frame buffer. Returns once every tile is done, and 
+ * fails if every local worker has exited while no worker is connected.
+ * 
+ * @param frame_buffer Frame buffer matching the resolution of the scene
+ */
+void FarmCoordinator::run(FrameBuffer* frame_buffer){
+    int tile_count_x = (frame_buffer->getWidth() + this->tile_size_ - 1) / this->tile_size_;
+    int tile_count_y = (frame_buffer->getHeight() + this->tile_size_ - 1) / this->tile_size_;
+    this->tiles_.clear();
+    this->pending_tiles_.clear();
+    for (int tile_y = 0; tile_y < tile_count_y; tile_y++) {
+        for (int tile_x = 0; tile_x < tile_count_x; tile_x++) {
+            FarmTile tile;
+            tile.x = tile_x * this->tile_size_;
+            tile.y = tile_y * this->tile_size_;
+            tile.width = std::min(this->tile_size_, frame_buffer->getWidth() - tile.x);
+            tile.height = std::min(this->tile_size_, frame_buffer->getHeight() - tile.y);
+            tile.done = false;
+            tile.holder_count = 0;
+            this->pending_tiles_.push_back(this->tiles_.size());
+            this->tiles_.push_back(tile);
+        }
+    }
+    this->remaining_count_ = this->tiles_.size();
+    
+    std::vector<pollfd> descriptors;
+    while(this->remaining_count_ > 0){
+        if(this->connections_.empty() && !this->local_workers_.empty() && !localWorkersAlive()){
+            throw std::runtime_error("Every worker has exited before the frame was complete.");
+        }
+        assignTiles();
+        
+        descriptors.clear();
+        pollfd listen_descriptor = {this->listen_fd_, POLLIN, 0};
+        descriptors.push_back(listen_descriptor);
+        for (unsigned int i = 0; i < this->connections_.size(); i++) {
+            pollfd descriptor = {this->connections_[i]->fd, POLLIN, 0};
+            descriptors.push_back(descriptor);
+        }
+        if(poll(&descriptors[0], descriptors.size(), FARM_POLL_INTERVAL) < 0 && errno != EINTR){
+            throw std::runtime_error(std::string("Could not wait for workers: ") + strerror(errno));
+        }
+        
+        //Connections are walked backwards, so dropping one keeps the indices of the others
+        for (int i = descriptors.size() - 2; i >= 0; i--) {
+            if(descriptors[i + 1].revents != 0 && !readFromWorker(this->connections_[i], frame_buffer)){
+                dropWorker(i);
+            }
+        }
+        if(descriptors[0].revents & POLLIN){
+            acceptWorker();
+        }
+        
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        for (int i = this->connections_.size() - 1; i >= 0; i--) {
+            FarmConnection* connection = this->connections_[i];
+            if(!connection->tiles.empty() && 
+               std::chrono::duration<double>(now - connection->progress_time).count() > this->tile_timeout_){
+                dropWorker(i);
+            }
+        }
+    }
+    
+    for (unsigned int i = 0; i < this->connections_.size(); i++) {
+        RenderService::sendLine(this->connections_[i]->fd, "FINISH");
+    }
+}
+
+/**
+ * Renders the frame with the workers, then post processes it and writes it
+ * to a binary PPM, or a PFM if the output ends in ".pfm"
+ * 
+ * @param output Name of the output file
+ */
+void FarmCoordinator::render(std::string output){
+    Scene* scene = new Scene();
+    this->parser_.applyView(scene);
+    FileWriter* file_writer = RenderService::createFileWriter(output);
+    RayTracer ray_tracer(scene, file_writer);
+    
+    FrameBuffer frame_buffer(scene->getWidthResolution(), scene->getHeightResolution());
+    run(&frame_buffer);
+    
+    file_writer->init();
+    file_writer->defineHeaders(frame_buffer.getWidth(), frame_buffer.getHeight(), 255);
+    FrameBuffer written_frame_buffer(frame_buffer.getWidth(), frame_buffer.getHeight());
+    ray_tracer.postProcessFrameBuffer(&frame_buffer, &written_frame_buffer);
+    RayTracer::addFrameBuffer(file_writer, &written_frame_buffer);
+}
+
+/**
+ * Gets the amount of tiles of the last frame
+ * 
+ * @return Amount of tiles
+ */
+int FarmCoordinator::getTileCount(){
+    return this->tiles_.size();
+}
+
+/**
+ * Gets the amount of workers which connected to the coordinator
+ * 
+ * @return Amount of workers
+ */
+int FarmCoordinator::getWorkerCount(){
+    return this->worker_count_;
+}
+
+/**
+ * Gets the amount of tiles handed out again after their worker was dropped
+ * 
+ * @return Amount of reassigned tiles
+ */
+int FarmCoordinator::getReassignedCount(){
+    return this->reassigned_count_;
+}
+
+/**
+ * Gets the amount of copies of outstanding tiles handed to idle workers
+ * 
+ * @return Amount of duplicated tiles
+ */
+int FarmCoordinator::getDuplicatedCount(){
+    return this->duplicated_count_;
+}
+
+/**
+ * Gets the amount of workers dropped for disconnecting or timing out
+ * 
+ * @return Amount of dropped workers
+ */
+int FarmCoordinator::getDroppedWorkerCount(){
+    return this->dropped_worker_count_;
+}
+
+/**
+ * Accepts a worker and sends it the scene
+ */
+void FarmCoordinator::acceptWorker(){
+    int fd = accept(this->listen_fd_, NULL, NULL);
+    if(fd < 0){
+        return;
+    }
+    int no_delay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+    
+    std::ostringstream header;
+    header << "SCENE " << this->scene_text_.size();
+    if(!RenderService::sendLine(fd, header.str()) || 
+       !RenderService::sendBytes(fd, this->scene_text_.data(), this->scene_text_.size())){
+        close(fd);
+        return;
+    }
+    
+    FarmConnection* connection = new FarmConnection();
+    connection->fd = fd;
+    connection->ready = false;
+    connection->progress_time = std::chrono::steady_clock::now();
+    connection->completed_count = 0;
+    this->connections_.push_back(connection);
+    this->worker_count_++;
+}
+
+/**
+ * Reads the data received from a worker, copying the samples of each tile 
+ * result into the frame buffer. Copies of tiles already done are ignored.
+ * 
+ * @param connection Connection to the worker
+ * @param frame_buffer Frame buffer being assembled
+ * @return False if the worker disconnected or broke the protocol
+ */
+bool FarmCoordinator::readFromWorker(FarmConnection* connection, FrameBuffer* frame_buffer){
+    char chunk[READ_CHUNK_SIZE];
+    ssize_t received = recv(connection->fd, chunk, sizeof(chunk), 0);
+    if(received < 0 && errno == EINTR){
+        return true;
+    }
+    if(received <= 0){
+        return false;
+    }
+    connection->input.append(chunk, received);
+    
+    while(true){
+        size_t end = connection->input.find('\n');
+        if(end == std::string::npos){
+            return true;
+        }
+        std::string line = connection->input.substr(0, end);
+        if(line == "READY"){
+            connection->ready = true;
+            connection->input.erase(0, end + 1);
+            continue;
+        }
+        
+        int tile_id;
+        if(sscanf(line.c_str(), "RESULT %d", &tile_id) != 1){
+            return false;
+        }
+        std::vector<int>::iterator held = std::find(connection->tiles.begin(), connection->tiles.end(), tile_id);
+        if(held == connection->tiles.end()){
+            return false;
+        }
+        FarmTile* tile = &this->tiles_[tile_id];
+        size_t row_size = 3 * tile->width * sizeof(float);
+        if(connection->input.size() < end + 1 + row_size * tile->height){
+            return true;
+        }
+        
+        if(!tile->done){
+            const char* samples = connection->input.data() + end + 1;
+            for (int y = 0; y < tile->height; y++) {
+                memcpy(frame_buffer->getRow(tile->y + y) + 3 * tile->x, samples + y * row_size, row_size);
+            }
+            tile->done = true;
+            this->remaining_count_--;
+        }
+        tile->holder_count--;
+        connection->tiles.erase(held);
+        connection->completed_count++;
+        connection->progress_time = std::chrono::steady_clock::now();
+        connection->input.erase(0, end + 1 + row_size * tile->height);
+    }
+}
+
+/**
+ * Hands tiles to the ready workers with room for more. Pending tiles come 
+ * first; once none are left, idle workers get a copy of an outstanding tile
+ * held by the fewest workers.
+ */
+void FarmCoordinator::assignTiles(){
+    for (unsigned int i = 0; i < this->connections_.size(); i++) {
+        FarmConnection* connection = this->connections_[i];
+        while(connection->ready && connection->tiles.size() < FARM_TILES_IN_FLIGHT && !this->pending_tiles_.empty()){
+            int tile_id = this->pending_tiles_.front();
+            this->pending_tiles_.pop_front();
+            if(!this->tiles_[tile_id].done && !assignTile(connection, tile_id)){
+                break;
+            }
+        }
+    }
+    
+    for (unsigned int i = 0; i < this->connections_.size(); i++) {
+        FarmConnection* connection = this->connections_[i];
+        if(!connection->ready || !connection->tiles.empty() || !this->pending_tiles_.empty()){
+            continue;
+        }
+        int best_tile = -1;
+        for (unsigned int tile_id = 0; tile_id < this->tiles_.size(); tile_id++) {
+            FarmTile* tile = &this->tiles_[tile_id];
+            if(!tile->done && tile->holder_count < FARM_MAX_TILE_HOLDERS && 
+               (best_tile < 0 || tile->holder_count < this->tiles_[best_tile].holder_count)){
+                best_tile = tile_id;
+            }
+        }
+        if(best_tile >= 0 && assignTile(connection, best_tile)){
+            this->duplicated_count_++;
+        }
+    }
+}
+
+/**
+ * Sends a tile to a worker
+ * 
+ * @param connection Connection to the worker
+ * @param tile_id Index of the tile
+ * @return False if the tile could not be sent, in which case it is pending again
+ */
+bool FarmCoordinator::assignTile(FarmConnection* connection, int tile_id){
+    FarmTile* tile = &this->tiles_[tile_id];
+    std::ostringstream request;
+    request << "TILE " << tile_id << " " << tile->x << " " << tile->y << " " << tile->width << " " << tile->height;
+    if(!RenderService::sendLine(connection->fd, request.str())){
+        if(tile->holder_count == 0){
+            this->pending_tiles_.push_front(tile_id);
+        }
+        return false;
+    }
+    
+    if(connection->tiles.empty()){
+        connection->progress_time = std::chrono::steady_clock::now();
+    }
+    connection->tiles.push_back(tile_id);
+    tile->holder_count++;
+    return true;
+}
+
+/**
+ * Closes the connection to a worker, handing its outstanding tiles out 
+ * again unless another worker holds them
+ * 
+ * @param index Index of the connection
+ */
+void FarmCoordinator::dropWorker(int index){
+    FarmConnection* connection = this->connections_[index];
+    for (unsigned int i = 0; i < connection->tiles.size(); i++) {
+        FarmTile* tile = &this->tiles_[connection->tiles[i]];
+        tile->holder_count--;
+        if(!tile->done && tile->holder_count == 0){
+            this->pending_tiles_.push_front(connection->tiles[i]);
+            this->reassigned_count_++;
+        }
+    }
+    close(connection->fd);
+    delete connection;
+    this->connections_.erase(this->connections_.begin() + index);
+    this->dropped_worker_count_++;
+}
+
+/**
+ * Checks whether any local worker is still running, collecting those which
+ * have exited
+ * 
+ * @return True if a local worker is still running
+ */
+bool FarmCoordinator::localWorkersAlive(){
+    for (int i = this->local_workers_.size() - 1; i >= 0; i--) {
+        if(waitpid(this->local_workers_[i], NULL, WNOHANG) != 0){
+            this->local_workers_.erase(this->local_workers_.begin() + i);
+        }
+    }
+    return !this->local_workers_.empty();
+}
+
+/**
+ * Closes every connection and waits for the local workers to exit, killing
+ * those still running after a second (such as stopped workers)
+ */
+void FarmCoordinator::stopWorkers(){
+    for (unsigned int i = 0; i < this->connections_.size(); i++) {
+        close(this->connections_[i]->fd);
+        delete this->connections_[i];
+    }
+    this->connections_.clear();
+    
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while(localWorkersAlive() && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < FARM_WORKER_EXIT_WAIT){
+        usleep(10000);
+    }
+    for (unsigned int i = 0; i < this->local_workers_.size(); i++) {
+        kill(this->local_workers_[i], SIGKILL);
+        waitpid(this->local_workers_[i], NULL, 0);
+    }
+    this->local_workers_.clear();
+}
@@ -0,0 +1,125 @@
+// Ray Tracer: farm_coordinator.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: The Farm Coordinator renders a single frame across several 
+//                  processes. It splits the image into tiles and hands them 
+//                  out over TCP to Farm Workers, local ones it starts itself
+//                  or remote ones connecting to its port, then assembles 
+//                  their samples into the frame. Tiles of workers which 
+//                  disconnect or exceed the tile timeout are handed out 
+//                  again, and once no tile is left to hand out, idle workers
+//                  render copies of the tiles still outstanding so a slow 
+//                  worker does not hold up the frame.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef FARM_COORDINATOR_H
+#define	FARM_COORDINATOR_H
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "render_service.h"
+#include "scene_parser.h"
+
+#include "../frame_buffer.h"
+#include "../ray_tracer.h"
+#include "../scene.h"
+
+//A tile of the frame, which may be held by several workers at once
+struct FarmTile {
+    int x;
+    int y;
+    int width;
+    int height;
+    bool done;
+    int holder_count;
+};
+
+//Connection to a worker, with the tiles it was handed in order
+struct FarmConnection {
+    int fd;
+    std::string input;
+    bool ready;
+    std::vector<int> tiles;
+    std::chrono::steady_clock::time_point progress_time;
+    int completed_count;
+};
+
+class FarmCoordinator {
+public:
+    FarmCoordinator();
+    FarmCoordinator(int tile_size, double tile_timeout);
+    virtual ~FarmCoordinator();
+    
+    void setScene(std::string scene_text);
+    void listen(int port);
+    int getPort();
+    void spawnLocalWorkers(int worker_count, std::string executable);
+    void run(FrameBuffer* frame_buffer);
+    void render(std::string output);
+    
+    int getTileCount();
+    int getWorkerCount();
+    int getReassignedCount();
+    int getDuplicatedCount();
+    int getDroppedWorkerCount();
+    
+private:
+    void acceptWorker();
+    bool readFromWorker(FarmConnection* connection, FrameBuffer* frame_buffer);
+    void assignTiles();
+    bool assignTile(FarmConnection* connection, int tile_id);
+    void dropWorker(int index);
+    bool localWorkersAlive();
+    void stopWorkers();
+    
+    int tile_size_;
+    double tile_timeout_;
+    std::string scene_text_;
+    SceneParser parser_;
+    int listen_fd_;
+    int port_;
+    std::vector<FarmTile> tiles_;
+    std::deque<int> pending_tiles_;
+    int remaining_count_;
+    std::vector<FarmConnection*> connections_;
+    std::vector<pid_t> local_workers_;
+    int worker_count_;
+    int reassigned_count_;
+    int duplicated_count_;
+    int dropped_worker_count_;
+};
+
+#endif	/* FARM_COORDINATOR_H */
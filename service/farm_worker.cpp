@@ -0,0 +1,159 @@
+// Ray Tracer: farm_worker.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Farm Worker renders tiles of a frame split across processes
+//                  by a Farm Coordinator. It connects to the coordinator over
+//                  TCP, builds the scene it receives, then traces each tile 
+//                  it is handed and sends back its raw samples, until the
+//                  coordinator finishes the frame or closes the connection.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "farm_worker.h"
+
+FarmWorker::FarmWorker(){
+    this->host_ = "127.0.0.1";
+    this->port_ = 0;
+    this->fd_ = -1;
+    this->tile_count_ = 0;
+}
+
+FarmWorker::FarmWorker(std::string host, int port){
+    this->host_ = host;
+    this->port_ = port;
+    this->fd_ = -1;
+    this->tile_count_ = 0;
+}
+
+FarmWorker::~FarmWorker(){
+    if(this->fd_ >= 0){
+        close(this->fd_);
+    }
+}
+
+/**
+ * Connects to the coordinator, builds the scene it sends and renders tiles 
+ * until told to finish. Samples are sent as native floats, so remote 
+ * workers must share the byte order of the coordinator.
+ * 
+ * Farm Protocol (10/19/2016)
+ * 
+ * Coordinator: "SCENE SIZE" followed by SIZE bytes of scene description 
+ *     (see Scene Parser)
+ * Worker: "READY" once the scene is built
+ * Coordinator: "TILE ID X Y WIDTH HEIGHT"
+ * Worker: "RESULT ID" followed by the WIDTH * HEIGHT * 3 float samples of 
+ *     the tile, row by row, before post processing
+ * Coordinator: "FINISH" once the frame is complete
+ */
+void FarmWorker::run(){
+    connect();
+    
+    std::string line;
+    std::string scene_text;
+    int scene_size = -1;
+    if(!RenderService::readLine(this->fd_, &this->buffer_, &line) || 
+       sscanf(line.c_str(), "SCENE %d", &scene_size) != 1 || scene_size < 0 ||
+       !RenderService::readBytes(this->fd_, &this->buffer_, scene_size, &scene_text)){
+        throw std::runtime_error("The coordinator did not send a scene.");
+    }
+    
+    SceneParser parser;
+    parser.parse(scene_text);
+    Scene* scene = new Scene();
+    parser.addGeometry(scene);
+    parser.applyView(scene);
+    RayTracer ray_tracer(scene, NULL);
+    ray_tracer.setAccelerationType(parser.getAccelerationType());
+    ray_tracer.setSamplesPerPixel(parser.getSamplesPerPixel());
+    ray_tracer.prepareRegions();
+    
+    int width = scene->getWidthResolution();
+    int height = scene->getHeightResolution();
+    std::vector<float> samples;
+    bool connected = RenderService::sendLine(this->fd_, "READY");
+    while(connected && RenderService::readLine(this->fd_, &this->buffer_, &line)){
+        int id, x, y, tile_width, tile_height;
+        if(line == "FINISH"){
+            break;
+        }
+        if(sscanf(line.c_str(), "TILE %d %d %d %d %d", &id, &x, &y, &tile_width, &tile_height) != 5 ||
+           x < 0 || y < 0 || tile_width <= 0 || tile_height <= 0 || x + tile_width > width || y + tile_height > height){
+            ray_tracer.finishFrame();
+            throw std::runtime_error("Unexpected request from the coordinator: " + line);
+        }
+        
+        samples.resize(3 * tile_width * tile_height);
+        ray_tracer.renderRegion(x, y, tile_width, tile_height, &samples[0]);
+        
+        //Sent at once, so the samples do not wait for the header to be acknowledged
+        std::ostringstream header;
+        header << "RESULT " << id << "\n";
+        std::string message = header.str();
+        message.append((const char*)&samples[0], samples.size() * sizeof(float));
+        connected = RenderService::sendBytes(this->fd_, message.data(), message.size());
+        this->tile_count_++;
+    }
+    
+    ray_tracer.finishFrame();
+}
+
+/**
+ * Gets the amount of tiles rendered by the worker
+ * 
+ * @return Amount of tiles rendered
+ */
+int FarmWorker::getTileCount(){
+    return this->tile_count_;
+}
+
+/**
+ * Connects to the coordinator at the host and port of the worker
+ */
+void FarmWorker::connect(){
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses;
+    std::ostringstream port;
+    port << this->port_;
+    int status = getaddrinfo(this->host_.c_str(), port.str().c_str(), &hints, &addresses);
+    if(status != 0){
+        throw std::runtime_error("Could not resolve " + this->host_ + ": " + gai_strerror(status));
+    }
+    
+    for (addrinfo* address = addresses; address != NULL; address = address->ai_next) {
+        this->fd_ = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if(this->fd_ < 0){
+            continue;
+        }
+        if(::connect(this->fd_, address->ai_addr, address->ai_addrlen) == 0){
+            break;
+        }
+        close(this->fd_);
+        this->fd_ = -1;
+    }
+    freeaddrinfo(addresses);
+    if(this->fd_ < 0){
+        throw std::runtime_error("Could not connect to the coordinator at " + this->host_ + ":" + port.str());
+    }
+    
+    int no_delay = 1;
+    setsockopt(this->fd_, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+}
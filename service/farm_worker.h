@@ -0,0 +1,67 @@
+// Ray Tracer: farm_worker.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: A Farm Worker renders tiles of a frame split across processes
+//                  by a Farm Coordinator. It connects to the coordinator over
+//                  TCP, builds the scene it receives, then traces each tile 
+//                  it is handed and sends back its raw samples, until the
+//                  coordinator finishes the frame or closes the connection.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef FARM_WORKER_H
+#define	FARM_WORKER_H
+
+#include <cstdio>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "render_service.h"
+#include "scene_parser.h"
+
+#include "../ray_tracer.h"
+#include "../scene.h"
+
+class FarmWorker {
+public:
+    FarmWorker();
+    FarmWorker(std::string host, int port);
+    virtual ~FarmWorker();
+    
+    void run();
+    int getTileCount();
+    
+private:
+    void connect();
+    
+    std::string host_;
+    int port_;
+    int fd_;
+    std::string buffer_;
+    int tile_count_;
+};
+
+#endif	/* FARM_WORKER_H */
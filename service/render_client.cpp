@@ -0,0 +1,131 @@
+// Ray Tracer: render_client.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: The Render Client connects to a Render Service and sends it
+//                  requests, reading back their replies one line at a time
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "render_client.h"
+
+RenderClient::RenderClient(){
+    this->socket_path_ = "/tmp/ray_tracer.sock";
+    this->fd_ = -1;
+}
+
+RenderClient::RenderClient(std::string socket_path){
+    this->socket_path_ = socket_path;
+    this->fd_ = -1;
+}
+
+RenderClient::~RenderClient(){
+    close();
+}
+
+/**
+ * Connects to the service listening on the socket path
+ */
+void RenderClient::connect(){
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(this->socket_path_.size() >= sizeof(address.sun_path)){
+        throw std::invalid_argument("Socket path is too long: " + this->socket_path_);
+    }
+    strcpy(address.sun_path, this->socket_path_.c_str());
+    
+    close();
+    this->fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(this->fd_ < 0 || ::connect(this->fd_, (sockaddr*)&address, sizeof(address)) < 0){
+        std::string error = strerror(errno);
+        close();
+        throw std::runtime_error("Could not connect to " + this->socket_path_ + ": " + error);
+    }
+}
+
+/**
+ * Closes the connection, if open
+ */
+void RenderClient::close(){
+    if(this->fd_ >= 0){
+        ::close(this->fd_);
+        this->fd_ = -1;
+    }
+    this->buffer_.clear();
+}
+
+/**
+ * Sends a line to the service
+ * 
+ * @param line Line to send, without its line ending
+ */
+void RenderClient::sendLine(std::string line){
+    if(!RenderService::sendLine(this->fd_, line)){
+        throw std::runtime_error("Connection to the render service lost");
+    }
+}
+
+/**
+ * Waits for the next reply of the service
+ * 
+ * @return Reply read, without its line ending
+ */
+std::string RenderClient::readLine(){
+    std::string line;
+    if(!RenderService::readLine(this->fd_, &this->buffer_, &line)){
+        throw std::runtime_error("Connection to the render service lost");
+    }
+    return line;
+}
+
+/**
+ * Sends a single line request and waits for its reply
+ * 
+ * @param line Request to send
+ * @return Reply to the request
+ */
+std::string RenderClient::request(std::string line){
+    sendLine(line);
+    return readLine();
+}
+
+/**
+ * Sends a RENDER request and waits for its job to be queued. The reply 
+ * telling how the job ended is read afterwards with readLine.
+ * 
+ * @param priority Priority of the job (higher renders first)
+ * @param output File to write the image to
+ * @param scene_text Description of the scene (see Scene Parser)
+ * @return Id of the job
+ */
+int RenderClient::queueRender(int priority, std::string output, std::string scene_text){
+    std::ostringstream request;
+    request << "RENDER " << priority << " " << output << "\n" << scene_text;
+    if(!scene_text.empty() && scene_text[scene_text.size() - 1] != '\n'){
+        request << "\n";
+    }
+    request << "END";
+    
+    std::string reply = request.str();
+    sendLine(reply);
+    reply = readLine();
+    if(reply.compare(0, 7, "QUEUED ") != 0){
+        throw std::runtime_error(reply);
+    }
+    return atoi(reply.c_str() + 7);
+}
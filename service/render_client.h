@@ -0,0 +1,58 @@
+// Ray Tracer: render_client.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: The Render Client connects to a Render Service and sends it
+//                  requests, reading back their replies one line at a time
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef RENDER_CLIENT_H
+#define	RENDER_CLIENT_H
+
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "render_service.h"
+
+class RenderClient {
+public:
+    RenderClient();
+    RenderClient(std::string socket_path);
+    virtual ~RenderClient();
+    
+    void connect();
+    void close();
+    void sendLine(std::string line);
+    std::string readLine();
+    std::string request(std::string line);
+    int queueRender(int priority, std::string output, std::string scene_text);
+    
+private:
+    std::string socket_path_;
+    int fd_;
+    std::string buffer_;
+};
+
+#endif	/* RENDER_CLIENT_H */
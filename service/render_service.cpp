@@ -0,0 +1,588 @@
+// Ray Tracer: render_service.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: The Render Service is a long running renderer accepting jobs
+//                  over a local Unix domain socket. Worker threads render the
+//                  queued jobs by priority, reusing the scenes and 
+//                  acceleration structures kept by a Scene Cache, so jobs 
+//                  only changing the camera, lights or sampling of a scene
+//                  already rendered skip building it.
+//
+//              Protocol (one request per line, one reply per line):
+//              - RENDER PRIORITY OUTPUT, followed by the lines of the scene
+//                   (see Scene Parser) and a line holding END. Replies 
+//                   "QUEUED ID" then, once the job ends, "DONE ID HIT|MISS 
+//                   SECONDS", "CANCELLED ID" or "ERROR ID MESSAGE". Higher 
+//                   priorities are rendered first. OUTPUT is written as a
+//                   binary PPM, or a PFM if it ends in ".pfm".
+//              - CANCEL ID: replies "CANCELLING ID" or "UNKNOWN ID"
+//              - STATS: replies "STATS" followed by name and value pairs
+//              - SHUTDOWN: cancels every job, replies "BYE" and stops
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "render_service.h"
+
+#define DEFAULT_SOCKET_PATH "/tmp/ray_tracer.sock"
+#define LISTEN_BACKLOG 16
+#define READ_CHUNK_SIZE 4096
+
+RenderService::RenderService(){
+    this->socket_path_ = DEFAULT_SOCKET_PATH;
+    this->worker_count_ = 1;
+    this->listen_fd_ = -1;
+    this->scene_cache_ = new SceneCache();
+    this->next_job_id_ = 1;
+    this->next_sequence_ = 0;
+    this->running_count_ = 0;
+    this->completed_count_ = 0;
+    this->cancelled_count_ = 0;
+    this->failed_count_ = 0;
+    this->stopping_ = false;
+}
+
+RenderService::RenderService(std::string socket_path, int worker_count, int cache_capacity){
+    this->socket_path_ = socket_path;
+    this->worker_count_ = worker_count > 0 ? worker_count : 1;
+    this->listen_fd_ = -1;
+    this->scene_cache_ = new SceneCache(cache_capacity);
+    this->next_job_id_ = 1;
+    this->next_sequence_ = 0;
+    this->running_count_ = 0;
+    this->completed_count_ = 0;
+    this->cancelled_count_ = 0;
+    this->failed_count_ = 0;
+    this->stopping_ = false;
+}
+
+RenderService::~RenderService(){
+    delete this->scene_cache_;
+}
+
+/**
+ * Listens on the socket and serves connections until a SHUTDOWN request. 
+ * Each connection is served by its own thread, handling its requests in 
+ * order: a RENDER request blocks the connection until its job ends, so 
+ * concurrent jobs are sent over separate connections.
+ */
+void RenderService::run(){
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(this->socket_path_.size() >= sizeof(address.sun_path)){
+        throw std::invalid_argument("Socket path is too long: " + this->socket_path_);
+    }
+    strcpy(address.sun_path, this->socket_path_.c_str());
+    
+    this->listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(this->listen_fd_ < 0){
+        throw std::runtime_error(std::string("Could not create socket: ") + strerror(errno));
+    }
+    unlink(this->socket_path_.c_str());
+    if(bind(this->listen_fd_, (sockaddr*)&address, sizeof(address)) < 0 || listen(this->listen_fd_, LISTEN_BACKLOG) < 0){
+        std::string error = strerror(errno);
+        ::close(this->listen_fd_);
+        throw std::runtime_error("Could not listen on " + this->socket_path_ + ": " + error);
+    }
+    
+    for (int i = 0; i < this->worker_count_; i++) {
+        this->workers_.push_back(std::thread(&RenderService::workerLoop, this));
+    }
+    
+    while(true){
+        int fd = accept(this->listen_fd_, NULL, NULL);
+        if(fd < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            break;
+        }
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        if(this->stopping_){
+            ::close(fd);
+            break;
+        }
+        this->connections_.insert(fd);
+        std::thread(&RenderService::serveConnection, this, fd).detach();
+    }
+    
+    for (unsigned int i = 0; i < this->workers_.size(); i++) {
+        this->workers_[i].join();
+    }
+    this->workers_.clear();
+    
+    //Connections still open are closed, and their threads waited for
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    for (std::set<int>::iterator it = this->connections_.begin(); it != this->connections_.end(); ++it) {
+        ::shutdown(*it, SHUT_RDWR);
+    }
+    while(!this->connections_.empty()){
+        this->job_finished_.wait(lock);
+    }
+    lock.unlock();
+    
+    ::close(this->listen_fd_);
+    this->listen_fd_ = -1;
+    unlink(this->socket_path_.c_str());
+}
+
+/**
+ * Stops the service: queued jobs are cancelled, running jobs are asked to 
+ * stop, and run returns once the workers have ended
+ */
+void RenderService::shutdown(){
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->stopping_ = true;
+    for (std::map<int, RenderJob*>::iterator it = this->jobs_.begin(); it != this->jobs_.end(); ++it) {
+        it->second->cancel_requested = true;
+        if(it->second->ray_tracer != NULL){
+            it->second->ray_tracer->cancel();
+        }
+    }
+    this->queue_changed_.notify_all();
+    if(this->listen_fd_ >= 0){
+        ::shutdown(this->listen_fd_, SHUT_RDWR);
+    }
+}
+
+/**
+ * Gets the path of the Unix domain socket the service listens on
+ * 
+ * @return Path of the socket
+ */
+std::string RenderService::getSocketPath(){
+    return this->socket_path_;
+}
+
+/**
+ * Gets the amount of jobs rendered at the same time
+ * 
+ * @return Amount of worker threads
+ */
+int RenderService::getWorkerCount(){
+    return this->worker_count_;
+}
+
+/**
+ * Gets the cache of the scenes rendered by the service
+ * 
+ * @return Scene cache of the service
+ */
+SceneCache* RenderService::getSceneCache(){
+    return this->scene_cache_;
+}
+
+/**
+ * Creates the writer of an output file: a PFM if its name ends in ".pfm", a
+ * binary PPM otherwise
+ * 
+ * @param output Name of the output file
+ * @return Writer of the file, not initialized yet
+ */
+FileWriter* RenderService::createFileWriter(std::string output){
+    if(output.size() > 4 && output.compare(output.size() - 4, 4, ".pfm") == 0){
+        return new PfmWriter(output);
+    }
+    return new BinaryPpmWriter(output);
+}
+
+/**
+ * Reads a line from a socket, without its line ending. Data received past 
+ * the line is kept in the buffer for the next call.
+ * 
+ * @param fd Socket to read from
+ * @param buffer Data received but not read yet
+ * @param line Set to the line read
+ * @return False if the connection closed before a full line was received
+ */
+bool RenderService::readLine(int fd, std::string* buffer, std::string* line){
+    size_t end = buffer->find('\n');
+    while(end == std::string::npos){
+        char chunk[READ_CHUNK_SIZE];
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if(received < 0 && errno == EINTR){
+            continue;
+        }
+        if(received <= 0){
+            return false;
+        }
+        buffer->append(chunk, received);
+        end = buffer->find('\n');
+    }
+    *line = buffer->substr(0, end);
+    buffer->erase(0, end + 1);
+    if(!line->empty() && (*line)[line->size() - 1] == '\r'){
+        line->erase(line->size() - 1);
+    }
+    return true;
+}
+
+/**
+ * Reads an exact amount of bytes from a socket, taking first the data 
+ * already received in the buffer
+ * 
+ * @param fd Socket to read from
+ * @param buffer Data received but not read yet
+ * @param size Amount of bytes to read
+ * @param bytes Set to the bytes read
+ * @return False if the connection closed before all bytes were received
+ */
+bool RenderService::readBytes(int fd, std::string* buffer, size_t size, std::string* bytes){
+    while(buffer->size() < size){
+        char chunk[READ_CHUNK_SIZE];
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if(received < 0 && errno == EINTR){
+            continue;
+        }
+        if(received <= 0){
+            return false;
+        }
+        buffer->append(chunk, received);
+    }
+    *bytes = buffer->substr(0, size);
+    buffer->erase(0, size);
+    return true;
+}
+
+/**
+ * Sends a line over a socket
+ * 
+ * @param fd Socket to send to
+ * @param line Line to send, without its line ending
+ * @return False if the line could not be sent
+ */
+bool RenderService::sendLine(int fd, std::string line){
+    line += '\n';
+    return sendBytes(fd, line.data(), line.size());
+}
+
+/**
+ * Sends bytes over a socket. A closed connection fails the send instead of
+ * raising SIGPIPE.
+ * 
+ * @param fd Socket to send to
+ * @param data Bytes to send
+ * @param size Amount of bytes to send
+ * @return False if the bytes could not be sent
+ */
+bool RenderService::sendBytes(int fd, const char* data, size_t size){
+    size_t sent = 0;
+    while(sent < size){
+        ssize_t written = send(fd, data + sent, size - sent, MSG_NOSIGNAL);
+        if(written < 0 && errno == EINTR){
+            continue;
+        }
+        if(written <= 0){
+            return false;
+        }
+        sent += written;
+    }
+    return true;
+}
+
+/**
+ * Handles the requests of a connection until it is closed
+ * 
+ * @param fd Socket of the connection
+ */
+void RenderService::serveConnection(int fd){
+    std::string buffer;
+    std::string line;
+    while(readLine(fd, &buffer, &line)){
+        std::istringstream request(line);
+        std::string command;
+        if(!(request >> command)){
+            continue;
+        }
+        
+        if(command == "RENDER"){
+            handleRender(fd, &buffer, &request);
+        } else if(command == "CANCEL"){
+            sendLine(fd, handleCancel(&request));
+        } else if(command == "STATS"){
+            sendLine(fd, handleStats());
+        } else if(command == "SHUTDOWN"){
+            sendLine(fd, "BYE");
+            shutdown();
+            break;
+        } else {
+            sendLine(fd, "ERROR 0 Unknown request " + command);
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    ::close(fd);
+    this->connections_.erase(fd);
+    this->job_finished_.notify_all();
+}
+
+/**
+ * Reads the scene of a RENDER request, queues its job and replies once the
+ * job has ended. Scenes failing to parse are refused before being queued.
+ * 
+ * @param fd Socket of the connection
+ * @param buffer Data received but not read yet
+ * @param request Arguments of the request
+ */
+void RenderService::handleRender(int fd, std::string* buffer, std::istringstream* request){
+    RenderJob* job = new RenderJob();
+    job->cancel_requested = false;
+    job->started = false;
+    job->finished = false;
+    job->ray_tracer = NULL;
+    if(!(*request >> job->priority >> job->output)){
+        job->output.clear();
+    }
+    
+    std::string scene_text;
+    std::string line;
+    bool complete = false;
+    while(readLine(fd, buffer, &line)){
+        if(line == "END"){
+            complete = true;
+            break;
+        }
+        scene_text += line + '\n';
+    }
+    if(!complete){
+        delete job;
+        return;
+    }
+    if(job->output.empty()){
+        delete job;
+        sendLine(fd, "ERROR 0 Usage: RENDER PRIORITY OUTPUT");
+        return;
+    }
+    try {
+        job->parser.parse(scene_text);
+    } catch ( const std::exception& error ) {
+        delete job;
+        sendLine(fd, std::string("ERROR 0 ") + error.what());
+        return;
+    }
+    
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    if(this->stopping_){
+        lock.unlock();
+        delete job;
+        sendLine(fd, "ERROR 0 The service is shutting down");
+        return;
+    }
+    job->id = this->next_job_id_++;
+    this->jobs_[job->id] = job;
+    QueuedJob queued_job;
+    queued_job.priority = job->priority;
+    queued_job.sequence = this->next_sequence_++;
+    queued_job.id = job->id;
+    this->queue_.push(queued_job);
+    this->queue_changed_.notify_one();
+    
+    std::ostringstream reply;
+    reply << "QUEUED " << job->id;
+    sendLine(fd, reply.str());
+    
+    while(!job->finished){
+        this->job_finished_.wait(lock);
+    }
+    this->jobs_.erase(job->id);
+    std::string result = job->result;
+    lock.unlock();
+    
+    delete job;
+    sendLine(fd, result);
+}
+
+/**
+ * Cancels a job. A queued job ends at once, while a running job stops at 
+ * its next row or tile and its output is not written.
+ * 
+ * @param request Arguments of the request
+ * @return Reply to the request
+ */
+std::string RenderService::handleCancel(std::istringstream* request){
+    int id = 0;
+    *request >> id;
+    std::ostringstream reply;
+    
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    std::map<int, RenderJob*>::iterator found = this->jobs_.find(id);
+    if(found == this->jobs_.end() || found->second->finished){
+        reply << "UNKNOWN " << id;
+        return reply.str();
+    }
+    
+    RenderJob* job = found->second;
+    job->cancel_requested = true;
+    if(job->ray_tracer != NULL){
+        job->ray_tracer->cancel();
+    } else if(!job->started){
+        //Still queued: the worker popping it skips it
+        std::ostringstream result;
+        result << "CANCELLED " << job->id;
+        job->finished = true;
+        job->result = result.str();
+        this->cancelled_count_++;
+        this->job_finished_.notify_all();
+    }
+    reply << "CANCELLING " << id;
+    return reply.str();
+}
+
+/**
+ * Describes the state of the service and its scene cache
+ * 
+ * @return Reply to the request
+ */
+std::string RenderService::handleStats(){
+    std::ostringstream reply;
+    reply << "STATS cached " << this->scene_cache_->getSize()
+          << " hits " << this->scene_cache_->getHitCount()
+          << " misses " << this->scene_cache_->getMissCount();
+    
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    reply << " queued " << this->jobs_.size() - this->running_count_
+          << " running " << this->running_count_
+          << " completed " << this->completed_count_
+          << " cancelled " << this->cancelled_count_
+          << " failed " << this->failed_count_;
+    return reply.str();
+}
+
+/**
+ * Renders queued jobs until the service stops
+ */
+void RenderService::workerLoop(){
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    while(true){
+        while(this->queue_.empty() && !this->stopping_){
+            this->queue_changed_.wait(lock);
+        }
+        if(this->queue_.empty()){
+            break;
+        }
+        
+        QueuedJob queued_job = this->queue_.top();
+        this->queue_.pop();
+        std::map<int, RenderJob*>::iterator found = this->jobs_.find(queued_job.id);
+        if(found == this->jobs_.end()){
+            continue;
+        }
+        RenderJob* job = found->second;
+        if(job->cancel_requested){
+            if(!job->finished){
+                std::ostringstream result;
+                result << "CANCELLED " << job->id;
+                job->finished = true;
+                job->result = result.str();
+                this->cancelled_count_++;
+                this->job_finished_.notify_all();
+            }
+            continue;
+        }
+        
+        job->started = true;
+        this->running_count_++;
+        lock.unlock();
+        renderJob(job);
+        lock.lock();
+        this->running_count_--;
+    }
+}
+
+/**
+ * Renders a job with the cached scene of its geometry, building the scene 
+ * first on a cache miss. Jobs for the same scene take turns, each applying
+ * its own camera, lights and sampling to it.
+ * 
+ * @param job Job to render
+ */
+void RenderService::renderJob(RenderJob* job){
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool hit;
+    SceneCacheEntry* entry = this->scene_cache_->acquire(&job->parser, &hit);
+    std::ostringstream result;
+    
+    try {
+        std::lock_guard<std::mutex> scene_lock(entry->mutex);
+        if(entry->ray_tracer == NULL){
+            Scene* scene = new Scene();
+            job->parser.addGeometry(scene);
+            job->parser.applyView(scene);
+            entry->ray_tracer = new RayTracer(scene, NULL);
+            entry->ray_tracer->setAccelerationType(job->parser.getAccelerationType());
+        }
+        
+        RayTracer* ray_tracer = entry->ray_tracer;
+        Scene* scene = ray_tracer->getScene();
+        job->parser.applyView(scene);
+        ray_tracer->setSamplesPerPixel(job->parser.getSamplesPerPixel());
+        
+        FileWriter* file_writer = createFileWriter(job->output);
+        ray_tracer->setFileWriter(file_writer);
+        file_writer->init();
+        file_writer->defineHeaders(scene->getWidthResolution(), scene->getHeightResolution(), 255);
+        
+        std::unique_lock<std::mutex> lock(this->mutex_);
+        bool cancelled = job->cancel_requested;
+        if(!cancelled){
+            ray_tracer->clearCancel();
+            job->ray_tracer = ray_tracer;
+            lock.unlock();
+            ray_tracer->run();
+            lock.lock();
+            job->ray_tracer = NULL;
+            cancelled = ray_tracer->isCancelled();
+        }
+        lock.unlock();
+        ray_tracer->setFileWriter(NULL);
+        
+        if(cancelled){
+            remove(job->output.c_str());
+            result << "CANCELLED " << job->id;
+        } else {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            result << "DONE " << job->id << (hit ? " HIT " : " MISS ") << seconds;
+        }
+    } catch ( const std::exception& error ) {
+        result.str("");
+        result << "ERROR " << job->id << " " << error.what();
+    }
+    
+    this->scene_cache_->release(entry);
+    finishJob(job, result.str());
+}
+
+/**
+ * Records the result of a job and wakes the connection waiting for it
+ * 
+ * @param job Job which ended
+ * @param result Reply to send for the job
+ */
+void RenderService::finishJob(RenderJob* job, std::string result){
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if(result.compare(0, 4, "DONE") == 0){
+        this->completed_count_++;
+    } else if(result.compare(0, 9, "CANCELLED") == 0){
+        this->cancelled_count_++;
+    } else {
+        this->failed_count_++;
+    }
+    job->finished = true;
+    job->result = result;
+    this->job_finished_.notify_all();
+}
@@ -0,0 +1,143 @@
+// Ray Tracer: render_service.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: The Render Service is a long running renderer accepting jobs
+//                  over a local Unix domain socket. Worker threads render the
+//                  queued jobs by priority, reusing the scenes and 
+//                  acceleration structures kept by a Scene Cache, so jobs 
+//                  only changing the camera, lights or sampling of a scene
+//                  already rendered skip building it.
+//
+//              Protocol (one request per line, one reply per line):
+//              - RENDER PRIORITY OUTPUT, followed by the lines of the scene
+//                   (see Scene Parser) and a line holding END. Replies 
+//                   "QUEUED ID" then, once the job ends, "DONE ID HIT|MISS 
+//                   SECONDS", "CANCELLED ID" or "ERROR ID MESSAGE". Higher 
+//                   priorities are rendered first. OUTPUT is written as a
+//                   binary PPM, or a PFM if it ends in ".pfm".
+//              - CANCEL ID: replies "CANCELLING ID" or "UNKNOWN ID"
+//              - STATS: replies "STATS" followed by name and value pairs
+//              - SHUTDOWN: cancels every job, replies "BYE" and stops
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef RENDER_SERVICE_H
+#define	RENDER_SERVICE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "scene_cache.h"
+#include "scene_parser.h"
+
+#include "../ray_tracer.h"
+
+#include "../file_writer/binary_ppm_writer.h"
+#include "../file_writer/pfm_writer.h"
+
+//A render job, from the RENDER request queuing it until its reply is sent
+struct RenderJob {
+    int id;
+    int priority;
+    std::string output;
+    SceneParser parser;
+    bool cancel_requested;
+    bool started;
+    bool finished;
+    RayTracer* ray_tracer;
+    std::string result;
+};
+
+//Position of a job in the queue: higher priorities first, then oldest first
+struct QueuedJob {
+    int priority;
+    long long sequence;
+    int id;
+    
+    bool operator<(const QueuedJob& other) const {
+        if(this->priority != other.priority){
+            return this->priority < other.priority;
+        }
+        return this->sequence > other.sequence;
+    }
+};
+
+class RenderService {
+public:
+    RenderService();
+    RenderService(std::string socket_path, int worker_count, int cache_capacity);
+    virtual ~RenderService();
+    
+    void run();
+    void shutdown();
+    
+    std::string getSocketPath();
+    int getWorkerCount();
+    SceneCache* getSceneCache();
+    
+    static FileWriter* createFileWriter(std::string output);
+    static bool readLine(int fd, std::string* buffer, std::string* line);
+    static bool readBytes(int fd, std::string* buffer, size_t size, std::string* bytes);
+    static bool sendLine(int fd, std::string line);
+    static bool sendBytes(int fd, const char* data, size_t size);
+    
+private:
+    void serveConnection(int fd);
+    void handleRender(int fd, std::string* buffer, std::istringstream* request);
+    std::string handleCancel(std::istringstream* request);
+    std::string handleStats();
+    void workerLoop();
+    void renderJob(RenderJob* job);
+    void finishJob(RenderJob* job, std::string result);
+    
+    std::string socket_path_;
+    int worker_count_;
+    int listen_fd_;
+    SceneCache* scene_cache_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable queue_changed_;
+    std::condition_variable job_finished_;
+    std::priority_queue<QueuedJob> queue_;
+    std::map<int, RenderJob*> jobs_;
+    std::set<int> connections_;
+    int next_job_id_;
+    long long next_sequence_;
+    int running_count_;
+    long long completed_count_;
+    long long cancelled_count_;
+    long long failed_count_;
+    bool stopping_;
+};
+
+#endif	/* RENDER_SERVICE_H */
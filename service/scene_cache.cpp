@@ -0,0 +1,168 @@
+// Ray Tracer: scene_cache.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: The Scene Cache keeps the most recently used scenes of the
+//                  render service, each with the ray tracer holding its built
+//                  acceleration structure, keyed by the hash of their 
+//                  geometry. Once full, the least recently used scene is
+//                  evicted, and deleted when the last job using it ends.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "scene_cache.h"
+
+#define DEFAULT_CACHE_CAPACITY 8
+
+SceneCache::SceneCache(){
+    this->capacity_ = DEFAULT_CACHE_CAPACITY;
+    this->hit_count_ = 0;
+    this->miss_count_ = 0;
+}
+
+SceneCache::SceneCache(int capacity){
+    this->capacity_ = capacity > 0 ? capacity : 1;
+    this->hit_count_ = 0;
+    this->miss_count_ = 0;
+}
+
+SceneCache::~SceneCache(){
+    while(!this->entries_.empty()){
+        SceneCacheEntry* entry = this->entries_.back();
+        delete entry->ray_tracer;
+        delete entry;
+        this->entries_.pop_back();
+    }
+}
+
+/**
+ * Finds the cached scene with the geometry of a parsed scene, making it the 
+ * most recently used, or adds an empty entry for it. The ray tracer of a new
+ * entry is NULL: the job acquiring it builds the scene while holding the 
+ * mutex of the entry, so later jobs for the same geometry wait for the build
+ * instead of repeating it. Every entry acquired must be released.
+ * 
+ * @param parser Parsed scene to look up
+ * @param hit Set to whether the scene was already cached
+ * @return Entry of the scene
+ */
+SceneCacheEntry* SceneCache::acquire(SceneParser* parser, bool* hit){
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    uint64_t hash = parser->getGeometryHash();
+    std::string geometry_key = parser->getGeometryKey();
+    
+    std::map<uint64_t, std::list<SceneCacheEntry*>::iterator>::iterator found = this->positions_.find(hash);
+    if(found != this->positions_.end()){
+        SceneCacheEntry* entry = *found->second;
+        if(entry->geometry_key == geometry_key){
+            this->entries_.splice(this->entries_.begin(), this->entries_, found->second);
+            entry->user_count++;
+            this->hit_count_++;
+            *hit = true;
+            return entry;
+        }
+        //Two geometries with the same hash: the older one is replaced
+        evict(found->second);
+    }
+    
+    SceneCacheEntry* entry = new SceneCacheEntry();
+    entry->hash = hash;
+    entry->geometry_key = geometry_key;
+    entry->ray_tracer = NULL;
+    entry->user_count = 1;
+    entry->evicted = false;
+    this->entries_.push_front(entry);
+    this->positions_[hash] = this->entries_.begin();
+    this->miss_count_++;
+    *hit = false;
+    
+    while((int)this->entries_.size() > this->capacity_){
+        evict(--this->entries_.end());
+    }
+    return entry;
+}
+
+/**
+ * Releases an entry acquired by a finished job, deleting it if it was 
+ * evicted while in use
+ * 
+ * @param entry Entry to release
+ */
+void SceneCache::release(SceneCacheEntry* entry){
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    entry->user_count--;
+    if(entry->evicted && entry->user_count == 0){
+        delete entry->ray_tracer;
+        delete entry;
+    }
+}
+
+/**
+ * Removes an entry from the cache. Entries still used by a job are deleted 
+ * when released instead. The mutex of the cache must be held.
+ * 
+ * @param position Position of the entry in the recently used list
+ */
+void SceneCache::evict(std::list<SceneCacheEntry*>::iterator position){
+    SceneCacheEntry* entry = *position;
+    this->positions_.erase(entry->hash);
+    this->entries_.erase(position);
+    entry->evicted = true;
+    if(entry->user_count == 0){
+        delete entry->ray_tracer;
+        delete entry;
+    }
+}
+
+/**
+ * Gets the amount of scenes the cache keeps
+ * 
+ * @return Capacity of the cache
+ */
+int SceneCache::getCapacity(){
+    return this->capacity_;
+}
+
+/**
+ * Gets the amount of scenes currently cached
+ * 
+ * @return Amount of cached scenes
+ */
+int SceneCache::getSize(){
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->entries_.size();
+}
+
+/**
+ * Gets the amount of lookups that found their scene cached
+ * 
+ * @return Amount of cache hits
+ */
+long long SceneCache::getHitCount(){
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->hit_count_;
+}
+
+/**
+ * Gets the amount of lookups that had to build their scene
+ * 
+ * @return Amount of cache misses
+ */
+long long SceneCache::getMissCount(){
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->miss_count_;
+}
@@ -0,0 +1,76 @@
+// Ray Tracer: scene_cache.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: The Scene Cache keeps the most recently used scenes of the
+//                  render service, each with the ray tracer holding its built
+//                  acceleration structure, keyed by the hash of their 
+//                  geometry. Once full, the least recently used scene is
+//                  evicted, and deleted when the last job using it ends.
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef SCENE_CACHE_H
+#define	SCENE_CACHE_H
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+
+#include "scene_parser.h"
+
+#include "../ray_tracer.h"
+
+//A cached scene. Jobs lock its mutex while they render it, since each job
+//changes the camera and lights of the scene.
+struct SceneCacheEntry {
+    uint64_t hash;
+    std::string geometry_key;
+    RayTracer* ray_tracer;
+    std::mutex mutex;
+    int user_count;
+    bool evicted;
+};
+
+class SceneCache {
+public:
+    SceneCache();
+    SceneCache(int capacity);
+    virtual ~SceneCache();
+    
+    SceneCacheEntry* acquire(SceneParser* parser, bool* hit);
+    void release(SceneCacheEntry* entry);
+    
+    int getCapacity();
+    int getSize();
+    long long getHitCount();
+    long long getMissCount();
+    
+private:
+    void evict(std::list<SceneCacheEntry*>::iterator position);
+    
+    int capacity_;
+    std::list<SceneCacheEntry*> entries_;
+    std::map<uint64_t, std::list<SceneCacheEntry*>::iterator> positions_;
+    std::mutex mutex_;
+    long long hit_count_;
+    long long miss_count_;
+};
+
+#endif	/* SCENE_CACHE_H */
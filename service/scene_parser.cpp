@@ -0,0 +1,284 @@
+// Ray Tracer: scene_parser.cpp
+// 
+// Author: Wesley Hauwiller
+//
+// Description: The Scene Parser reads a scene described as text, one command 
+//                  per line ("#" starts a comment). Geometry commands build
+//                  the geometry of a scene and make up its cache key, while
+//                  view commands set the camera, lights and sampling of each
+//                  render, so a cached scene can be rendered again with 
+//                  another view without sorting its geometry again.
+//
+//              Geometry commands:
+//              - sphere X Y Z RADIUS constant R G B
+//              - sphere X Y Z RADIUS phong R G B SR SG SB EXPONENT 
+//                   [RR RG RB [TR TG TB INDEX]] (specular, reflective and
+//                   transmissive colors, and index of refraction)
+//              - accel TYPE (acceleration structure, see the Acceleration 
+//                   Structure Flag List)
+//
+//              View commands:
+//              - camera OX OY OZ LX LY LZ FOV WIDTH HEIGHT (origin, point 
+//                   looked at, field of view in degrees, resolution)
+//              - background R G B
+//              - ambient R G B
+//              - directional R G B DX DY DZ (direction the light travels)
+//              - point R G B X Y Z RADIUS
+//              - samples N (rays per pixel)
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "scene_parser.h"
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+SceneParser::SceneParser(){
+    this->acceleration_type_ = -1;
+    this->samples_per_pixel_ = 1;
+}
+
+SceneParser::~SceneParser(){
+}
+
+/**
+ * Reads a scene description, checking the command names and the amount of
+ * arguments of every line. The geometry commands are also printed into the 
+ * geometry key, one per line with every number written in full, so scenes 
+ * whose geometry only differs in spacing or comments share a key.
+ * 
+ * @param text Scene description
+ */
+void SceneParser::parse(std::string text){
+    this->geometry_commands_.clear();
+    this->view_commands_.clear();
+    this->geometry_key_.clear();
+    this->acceleration_type_ = -1;
+    this->samples_per_pixel_ = 1;
+    bool has_camera = false;
+    
+    std::istringstream lines(text);
+    std::string line;
+    int line_number = 0;
+    while(std::getline(lines, line)){
+        line_number++;
+        line = line.substr(0, line.find('#'));
+        
+        std::istringstream tokens(line);
+        SceneCommand command;
+        if(!(tokens >> command.name)){
+            continue;
+        }
+        std::string token;
+        while(tokens >> token){
+            char* end;
+            double value = strtod(token.c_str(), &end);
+            if(*end != '\0'){
+                if(command.name == "sphere" && command.values.size() == 4 && command.shader.empty()){
+                    command.shader = token;
+                    continue;
+                }
+                std::ostringstream error;
+                error << "Line " << line_number << ": \"" << token << "\" is not a number.";
+                throw std::invalid_argument(error.str());
+            }
+            command.values.push_back(value);
+        }
+        
+        int value_count = command.values.size();
+        bool valid;
+        bool geometry = false;
+        if(command.name == "sphere"){
+            geometry = true;
+            valid = (command.shader == "constant" && value_count == 7) || 
+                    (command.shader == "phong" && (value_count == 11 || value_count == 14 || value_count == 18));
+        } else if(command.name == "accel"){
+            geometry = true;
+            valid = value_count == 1;
+            this->acceleration_type_ = valid ? (int)command.values[0] : -1;
+        } else if(command.name == "camera"){
+            valid = value_count == 9 && command.values[7] >= 1 && command.values[8] >= 1;
+            has_camera = true;
+        } else if(command.name == "background" || command.name == "ambient"){
+            valid = value_count == 3;
+        } else if(command.name == "directional"){
+            valid = value_count == 6;
+        } else if(command.name == "point"){
+            valid = value_count == 7;
+        } else if(command.name == "samples"){
+            valid = value_count == 1 && command.values[0] >= 1;
+            this->samples_per_pixel_ = valid ? (int)command.values[0] : 1;
+        } else {
+            std::ostringstream error;
+            error << "Line " << line_number << ": unknown command \"" << command.name << "\".";
+            throw std::invalid_argument(error.str());
+        }
+        if(!valid){
+            std::ostringstream error;
+            error << "Line " << line_number << ": wrong arguments for \"" << command.name << "\".";
+            throw std::invalid_argument(error.str());
+        }
+        
+        if(geometry){
+            this->geometry_key_ += command.name;
+            if(!command.shader.empty()){
+                this->geometry_key_ += " " + command.shader;
+            }
+            for (int i = 0; i < value_count; i++) {
+                char number[32];
+                snprintf(number, sizeof(number), " %.17g", command.values[i]);
+                this->geometry_key_ += number;
+            }
+            this->geometry_key_ += '\n';
+            this->geometry_commands_.push_back(command);
+        } else {
+            this->view_commands_.push_back(command);
+        }
+    }
+    
+    if(!has_camera){
+        throw std::invalid_argument("The scene has no camera.");
+    }
+}
+
+/**
+ * Gets the geometry commands of the last scene parsed, printed one per line
+ * 
+ * @return Geometry key of the scene
+ */
+std::string SceneParser::getGeometryKey(){
+    return this->geometry_key_;
+}
+
+/**
+ * Gets the hash of the geometry key of the last scene parsed
+ * 
+ * @return Hash of the geometry of the scene
+ */
+uint64_t SceneParser::getGeometryHash(){
+    return hashText(this->geometry_key_);
+}
+
+/**
+ * Gets the acceleration structure requested by the last scene parsed
+ * 
+ * @return Flag of the acceleration structure (-1 to choose automatically)
+ */
+int SceneParser::getAccelerationType(){
+    return this->acceleration_type_;
+}
+
+/**
+ * Gets the rays per pixel requested by the last scene parsed
+ * 
+ * @return Rays cast through each pixel
+ */
+int SceneParser::getSamplesPerPixel(){
+    return this->samples_per_pixel_;
+}
+
+/**
+ * Adds the geometry of the last scene parsed to a scene
+ * 
+ * @param scene Scene to add the geometry to
+ */
+void SceneParser::addGeometry(Scene* scene){
+    for (unsigned int i = 0; i < this->geometry_commands_.size(); i++) {
+        SceneCommand* command = &this->geometry_commands_[i];
+        if(command->name != "sphere"){
+            continue;
+        }
+        
+        std::vector<double>* values = &command->values;
+        Point3D* center = new Point3D((*values)[0], (*values)[1], (*values)[2]);
+        Sphere* sphere;
+        if(command->shader == "constant"){
+            sphere = new Sphere(center, (*values)[3], new ConstantShader());
+            sphere->setDiffuseColor(readColor(values, 4));
+        } else {
+            sphere = new Sphere(center, (*values)[3], new PhongShader());
+            sphere->setDiffuseColor(readColor(values, 4));
+            sphere->setSpecularHighlight(readColor(values, 7));
+            sphere->setPhongConstant((int)(*values)[10]);
+            if(values->size() >= 14){
+                sphere->setReflectiveColor(readColor(values, 11));
+            }
+            if(values->size() >= 18){
+                sphere->setTransmissiveColor(readColor(values, 14));
+                sphere->setRefractionIndex((*values)[17]);
+            }
+        }
+        scene->addGeo(sphere);
+    }
+}
+
+/**
+ * Sets the camera, background and lights of a scene to those of the last 
+ * scene parsed, replacing its previous camera and lights
+ * 
+ * @param scene Scene to change
+ */
+void SceneParser::applyView(Scene* scene){
+    scene->clearLights();
+    scene->setBackgroundColor(RgbColor(0,0,0));
+    for (unsigned int i = 0; i < this->view_commands_.size(); i++) {
+        SceneCommand* command = &this->view_commands_[i];
+        std::vector<double>* values = &command->values;
+        if(command->name == "camera"){
+            Camera* camera = new Camera();
+            camera->setResolution((int)(*values)[7], (int)(*values)[8]);
+            camera->setOrigin(new Point3D((*values)[0], (*values)[1], (*values)[2]));
+            camera->setLookAt(new Point3D((*values)[3], (*values)[4], (*values)[5]));
+            camera->setFocalParams((*values)[6], false);
+            camera->setDistToImagePlane(1);
+            scene->setCamera(camera);
+        } else if(command->name == "background"){
+            scene->setBackgroundColor(readColor(values, 0));
+        } else if(command->name == "ambient"){
+            scene->addLight(new AmbientLight(readColor(values, 0)));
+        } else if(command->name == "directional"){
+            scene->addLight(new DirectionalLight(readColor(values, 0), new Vector3D((*values)[3], (*values)[4], (*values)[5])));
+        } else if(command->name == "point"){
+            scene->addLight(new PointLight(readColor(values, 0), new Point3D((*values)[3], (*values)[4], (*values)[5]), (*values)[6]));
+        }
+    }
+}
+
+/**
+ * Computes the 64-bit FNV-1a hash of a text
+ * 
+ * @param text Text to hash
+ * @return Hash of the text
+ */
+uint64_t SceneParser::hashText(std::string text){
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (unsigned int i = 0; i < text.size(); i++) {
+        hash = (hash ^ (unsigned char)text[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Reads three consecutive arguments as a color
+ * 
+ * @param values Arguments of a command
+ * @param first Index of the red component
+ * @return Color read
+ */
+RgbColor SceneParser::readColor(std::vector<double>* values, int first){
+    return RgbColor((*values)[first], (*values)[first + 1], (*values)[first + 2]);
+}
@@ -0,0 +1,101 @@
+// Ray Tracer: scene_parser.h
+// 
+// Author: Wesley Hauwiller
+//
+// Description: The Scene Parser reads a scene described as text, one command 
+//                  per line ("#" starts a comment). Geometry commands build
+//                  the geometry of a scene and make up its cache key, while
+//                  view commands set the camera, lights and sampling of each
+//                  render, so a cached scene can be rendered again with 
+//                  another view without sorting its geometry again.
+//
+//              Geometry commands:
+//              - sphere X Y Z RADIUS constant R G B
+//              - sphere X Y Z RADIUS phong R G B SR SG SB EXPONENT 
+//                   [RR RG RB [TR TG TB INDEX]] (specular, reflective and
+//                   transmissive colors, and index of refraction)
+//              - accel TYPE (acceleration structure, see the Acceleration 
+//                   Structure Flag List)
+//
+//              View commands:
+//              - camera OX OY OZ LX LY LZ FOV WIDTH HEIGHT (origin, point 
+//                   looked at, field of view in degrees, resolution)
+//              - background R G B
+//              - ambient R G B
+//              - directional R G B DX DY DZ (direction the light travels)
+//              - point R G B X Y Z RADIUS
+//              - samples N (rays per pixel)
+//
+// Copyright (C) 2016  whauwiller.blogspot.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// A full copy of the GNU General Public License may be found at
+// <http://www.gnu.org/licenses/>.
+//
+
+#ifndef SCENE_PARSER_H
+#define	SCENE_PARSER_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "../camera.h"
+#include "../scene.h"
+
+#include "../geo/sphere.h"
+
+#include "../light/ambient_light.h"
+#include "../light/directional_light.h"
+#include "../light/point_light.h"
+
+#include "../shader/constant_shader.h"
+#include "../shader/phong_shader.h"
+
+//A command of a scene description, with its numeric arguments
+struct SceneCommand {
+    std::string name;
+    std::string shader;
+    std::vector<double> values;
+};
+
+class SceneParser {
+public:
+    SceneParser();
+    virtual ~SceneParser();
+    
+    void parse(std::string text);
+    std::string getGeometryKey();
+    uint64_t getGeometryHash();
+    int getAccelerationType();
+    int getSamplesPerPixel();
+    
+    void addGeometry(Scene* scene);
+    void applyView(Scene* scene);
+    
+    static uint64_t hashText(std::string text);
+    
+private:
+    static RgbColor readColor(std::vector<double>* values, int first);
+    
+    std::vector<SceneCommand> geometry_commands_;
+    std::vector<SceneCommand> view_commands_;
+    std::string geometry_key_;
+    int acceleration_type_;
+    int samples_per_pixel_;
+};
+
+#endif	/* SCENE_PARSER_H */
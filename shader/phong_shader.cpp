@@ -28,6 +28,7 @@ PhongShader::PhongShader() {
     this->diffuse_color_ = RgbColor(0,0,0);
     this->specular_highlight_ = RgbColor(0,0,0);
     this->reflective_color_ = RgbColor(0,0,0);
+    this->transmissive_color_ = RgbColor(0,0,0);
     this->phong_constant_ = 2;
     this->refraction_index_ = 1.33;
 }
@@ -66,12 +67,14 @@ bool PhongShader::hasReflection(){
 }
 
 /**
- * Queries the shader to see whether it has refraction or not
+ * Queries the shader to see whether it has refraction or not.
+ * Light is only transmitted when the shader has a transmissive color
+ * and a valid index of refraction.
  * 
  * @return Boolean indicating presence of refraction in the shader
  */
 bool PhongShader::hasRefraction(){
-    if(this->refraction_index_ == 0.0){
+    if(this->transmissive_color_.isBlack() || this->refraction_index_ == 0.0){
         return false;
     } else {
         return true;
@@ -132,6 +135,25 @@ void PhongShader::setReflectiveColor(RgbColor reflective_color){
     this->reflective_color_ = reflective_color;
 }
 
+/**
+ * Gets the transmissive color
+ * 
+ * @return Shader Transmissive Color
+ */
+RgbColor PhongShader::getTransmissiveColor(){
+    return this->transmissive_color_;
+}
+
+/**
+ * Sets the transmissive color. This is the color that filters the light 
+ * refracted through the geometry.
+ * 
+ * @param transmissive_color Transmissive color to set
+ */
+void PhongShader::setTransmissiveColor(RgbColor transmissive_color){
+    this->transmissive_color_ = transmissive_color;
+}
+
 /**
  * Gets the phong constant indicating the amount of specular reflection
  * 
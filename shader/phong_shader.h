@@ -43,6 +43,8 @@ public:
     void setSpecularHighlight(RgbColor specular_highlight);
     RgbColor getReflectiveColor();
     void setReflectiveColor(RgbColor reflective_color);
+    RgbColor getTransmissiveColor();
+    void setTransmissiveColor(RgbColor transmissive_color);
     int getPhongConstant();
     void setPhongConstant(int phong_constant);
     double getRefractionIndex();
@@ -52,6 +54,7 @@ private:
     RgbColor diffuse_color_;
     RgbColor specular_highlight_;
     RgbColor reflective_color_;
+    RgbColor transmissive_color_;
     int phong_constant_;
     double refraction_index_;
 };
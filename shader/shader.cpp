@@ -107,6 +107,24 @@ RgbColor Shader::getReflectiveColor(){
  */
 void Shader::setReflectiveColor(RgbColor reflective_color){ }
 
+/**
+ * Gets the transmissive color
+ * (No-Op unless overridden)
+ * 
+ * @return Shader Transmissive Color
+ */
+RgbColor Shader::getTransmissiveColor(){
+    return RgbColor(0,0,0);
+}
+
+/**
+ * Sets the transmissive color
+ * (No-Op unless overridden)
+ * 
+ * @param transmissive_color Transmissive color to set
+ */
+void Shader::setTransmissiveColor(RgbColor transmissive_color){ }
+
 /**
  * Gets the phong constant indicating the amount of specular reflection
  * (No-Op unless overridden)
@@ -45,6 +45,8 @@ public:
     virtual void setSpecularHighlight(RgbColor specular_highlight);
     virtual RgbColor getReflectiveColor();
     virtual void setReflectiveColor(RgbColor reflective_color);
+    virtual RgbColor getTransmissiveColor();
+    virtual void setTransmissiveColor(RgbColor transmissive_color);
     virtual int getPhongConstant();
     virtual void setPhongConstant(int phong_constant);
     virtual double getRefractionIndex();